@@ -1,3 +1,6 @@
+#ifndef WINDOW_MANAGER_H
+#define WINDOW_MANAGER_H
+
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <vector>
@@ -5,10 +8,17 @@
 #include <cstring>
 #include <FreeRTOS.h>
 #include <queue>
+#include "key_event.h"
+#include "spsc_ring.h"
+#include "ssd1306_region.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
+#define COVER_WORDS ((SCREEN_WIDTH + 63) / 64)   // 每行覆盖位图的 64 位字数
 #define QUEUE_LENGTH 10  // 每个窗口按键事件队列长度
+#define INPUT_RING_SIZE 32  // 输入线程到显示线程的按键事件缓冲
+#define MAX_DAMAGE_RECTS 8  // 每帧的脏矩形数量上限, 超出时合并
+#define FPS_TEXT_WIDTH 48
 
 // 4x4 Bayer矩阵用于有序抖动
 const uint8_t bayerMatrix[4][4] = {
@@ -25,6 +35,113 @@ enum DitheringType {
     ERROR_DIFFUSION      // 误差扩散抖动（Floyd-Steinberg）
 };
 
+// 矩形 [x0, x1) × [y0, y1)
+struct ScreenRect {
+    int16_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    bool empty() const {
+        return x0 >= x1 || y0 >= y1;
+    }
+
+    bool operator==(const ScreenRect& r) const {
+        return (empty() && r.empty()) || (x0 == r.x0 && y0 == r.y0 && x1 == r.x1 && y1 == r.y1);
+    }
+
+    ScreenRect intersect(const ScreenRect& r) const {
+        return {std::max(x0, r.x0), std::max(y0, r.y0), std::min(x1, r.x1), std::min(y1, r.y1)};
+    }
+
+    ScreenRect unite(const ScreenRect& r) const {
+        if (empty()) return r;
+        if (r.empty()) return *this;
+        return {std::min(x0, r.x0), std::min(y0, r.y0), std::max(x1, r.x1), std::max(y1, r.y1)};
+    }
+
+    // 相交或相邻
+    bool touches(const ScreenRect& r) const {
+        return x0 <= r.x1 && r.x0 <= x1 && y0 <= r.y1 && r.y0 <= y1;
+    }
+
+    int32_t area() const {
+        return empty() ? 0 : (int32_t)(x1 - x0) * (y1 - y0);
+    }
+
+    ScreenRect offset(int16_t dx, int16_t dy) const {
+        return {(int16_t)(x0 + dx), (int16_t)(y0 + dy), (int16_t)(x1 + dx), (int16_t)(y1 + dy)};
+    }
+};
+
+// 一帧的脏区域: 互不相交的矩形, 相交或相邻的矩形在加入时合并
+class DamageList {
+public:
+    void add(ScreenRect r) {
+        r = r.intersect({0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+        if (r.empty()) return;
+        // 合并后可能又与其他矩形相交, 重复到没有为止
+        for (int i = 0; i < count; ) {
+            if (rects[i].touches(r)) {
+                r = r.unite(rects[i]);
+                rects[i] = rects[--count];
+                i = 0;
+            } else {
+                i++;
+            }
+        }
+        if (count < MAX_DAMAGE_RECTS) {
+            rects[count++] = r;
+            return;
+        }
+        // 已满: 并入使面积增加最少的矩形
+        int best = 0;
+        int32_t bestGrowth = INT32_MAX;
+        for (int i = 0; i < count; i++) {
+            int32_t growth = rects[i].unite(r).area() - rects[i].area();
+            if (growth < bestGrowth) {
+                bestGrowth = growth;
+                best = i;
+            }
+        }
+        ScreenRect merged = rects[best].unite(r);
+        rects[best] = rects[--count];
+        add(merged);
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    bool intersects(const ScreenRect& r) const {
+        for (int i = 0; i < count; i++) {
+            if (!rects[i].intersect(r).empty()) return true;
+        }
+        return false;
+    }
+
+    int size() const {
+        return count;
+    }
+
+    const ScreenRect& operator[](int i) const {
+        return rects[i];
+    }
+
+    int32_t area() const {
+        int32_t a = 0;
+        for (int i = 0; i < count; i++) {
+            a += rects[i].area();
+        }
+        return a;
+    }
+
+private:
+    ScreenRect rects[MAX_DAMAGE_RECTS];
+    int count = 0;
+};
+
 // 窗口类型枚举
 enum WindowType {
     NORMAL_WINDOW,        // 普通窗口
@@ -34,19 +151,6 @@ enum WindowType {
     FIXED_BOTTOM_WINDOW   // 固定底部窗口，始终在最底层
 };
 
-// 按键事件状态枚举
-typedef enum {
-    KEY_IDLE,
-    KEY_ATTACK,
-    KEY_RELEASE
-} key_status_t;
-
-// 按键事件结构
-typedef struct {
-    uint8_t num;         // 按键编号
-    key_status_t status; // 按键状态
-} key_event_t;
-
 // 窗口类
 class Window : public Adafruit_GFX {
 public:
@@ -66,12 +170,54 @@ public:
         vSemaphoreDelete(bufferMutex);
     }
 
-    // 提交显示
+    // 提交显示: 逐行比较, 只复制变化的部分并记入脏矩形 (窗口坐标)
     void display() {
         if (xSemaphoreTake(bufferMutex, portMAX_DELAY) == pdTRUE) {
-            std::memcpy(displayBuffer, drawBuffer, bufferSize);
+            int16_t w = width();
+            for (int16_t y = 0; y < height(); y++) {
+                const uint8_t* src = drawBuffer + y * w;
+                uint8_t* dst = displayBuffer + y * w;
+                if (std::memcmp(src, dst, w) == 0) continue;
+                int16_t x0 = 0, x1 = w;
+                while (src[x0] == dst[x0]) x0++;
+                while (src[x1 - 1] == dst[x1 - 1]) x1--;
+                std::memcpy(dst + x0, src + x0, x1 - x0);
+                damage = damage.unite({x0, y, x1, (int16_t)(y + 1)});
+            }
+            // 本次提交已包含对这些按键的响应
+            if (consumedInputUs && !frameInputUs) frameInputUs = consumedInputUs;
+            consumedInputUs = 0;
+            xSemaphoreGive(bufferMutex);
+        }
+    }
+
+    // 取出并清空脏矩形 (窗口坐标), 由窗口管理器在合成前调用
+    ScreenRect takeDamage() {
+        ScreenRect r;
+        if (xSemaphoreTake(bufferMutex, portMAX_DELAY) == pdTRUE) {
+            r = damage;
+            damage = ScreenRect();
             xSemaphoreGive(bufferMutex);
         }
+        return r;
+    }
+
+    // 整个窗口在下一帧重绘, 包括边框 (内容外一圈)
+    void markDirty() {
+        if (xSemaphoreTake(bufferMutex, portMAX_DELAY) == pdTRUE) {
+            damage = {-1, -1, (int16_t)(width() + 1), (int16_t)(height() + 1)};
+            xSemaphoreGive(bufferMutex);
+        }
+    }
+
+    // 上一帧合成时在屏幕上占据的区域 (含边框), 由窗口管理器维护
+    ScreenRect composedRect;
+
+    // 取出已提交画面对应的最早按键时间 (由窗口管理器在推送帧后调用), 没有时为 0
+    int64_t takeFrameInputTime() {
+        int64_t t = frameInputUs;
+        frameInputUs = 0;
+        return t;
     }
 
     // 获取显示缓冲区
@@ -131,6 +277,7 @@ public:
     // 设置窗口的抖动类型
     void setDitheringType(DitheringType type) {
         ditheringType = type;
+        markDirty();
     }
 
     // 是否启用边框
@@ -143,14 +290,15 @@ public:
         key_event_t event;
         static const key_event_t idleEvent = {0, KEY_IDLE};
         if (xQueueReceive(keyEventQueue, &event, 0) == pdPASS) {
+            if (!consumedInputUs) consumedInputUs = event.us;
             return event;
         }
         return idleEvent;
     }
 
-    // 将按键事件推送到窗口的事件队列
-    void pushKeyEvent(const key_event_t& event) {
-        xQueueSend(keyEventQueue, &event, portMAX_DELAY);
+    // 将按键事件推送到窗口的事件队列, 队列满时丢弃 (不阻塞调用者)
+    bool pushKeyEvent(const key_event_t& event) {
+        return xQueueSend(keyEventQueue, &event, 0) == pdPASS;
     }
 
     // drawPixel 方法
@@ -170,14 +318,16 @@ private:
     bool hasBorder;            // 是否有边框
     DitheringType ditheringType; // 抖动类型
     QueueHandle_t keyEventQueue; // 按键事件队列
+    volatile int64_t consumedInputUs = 0; // 已取出但尚未提交画面的最早按键时间
+    volatile int64_t frameInputUs = 0;    // 已提交但尚未推送到屏幕的最早按键时间
+    ScreenRect damage;                    // 自上次合成以来变化的区域 (窗口坐标)
 };
 
 // 窗口管理器类
 class WindowManager {
 public:
-    WindowManager(Adafruit_SSD1306* display)
+    WindowManager(RegionSSD1306* display)
         : display(display), ditheringType(ORDERED_DITHERING) {
-        covered.resize(SCREEN_WIDTH, std::vector<bool>(SCREEN_HEIGHT, false));
     }
 
     ~WindowManager() {
@@ -210,8 +360,6 @@ public:
         windows.insert(windows.begin() + insertPos, window);
         
         startAnimation(window, true);
-        
-        updateCoveredAreas();
         return window;
     }
 
@@ -230,7 +378,7 @@ public:
             windows.erase(it);
             windows.push_back(window);
             enforceFixedLayerOrder();
-            updateCoveredAreas();
+            window->markDirty();
         }
     }
 
@@ -240,7 +388,7 @@ public:
             windows.erase(it);
             windows.insert(windows.begin(), window);
             enforceFixedLayerOrder();
-            updateCoveredAreas();
+            window->markDirty();
         }
     }
 
@@ -249,7 +397,7 @@ public:
         if (it != windows.end() && it + 1 != windows.end() && window->getWindowType() != FIXED_BOTTOM_WINDOW) {
             std::iter_swap(it, it + 1);
             enforceFixedLayerOrder();
-            updateCoveredAreas();
+            window->markDirty();
         }
     }
 
@@ -258,62 +406,114 @@ public:
         if (it != windows.begin() && window->getWindowType() != MODAL_WINDOW) {
             std::iter_swap(it, it - 1);
             enforceFixedLayerOrder();
-            updateCoveredAreas();
+            window->markDirty();
         }
     }
 
+    // 焦点窗口: 最上层的非浮动窗口 (浮动窗口只用于状态显示)
+    Window* getFocusedWindow() const {
+        for (int i = windows.size() - 1; i >= 0; --i) {
+            if (windows[i]->getWindowType() != FLOATING_WINDOW) {
+                return windows[i];
+            }
+        }
+        return nullptr;
+    }
+
     void pushKeyEvent(const key_event_t& event) {
-        if (!windows.empty()) {
-            windows.back()->pushKeyEvent(event);
+        Window* focused = getFocusedWindow();
+        if (focused && !focused->pushKeyEvent(event)) {
+            droppedKeyEvents++;
         }
     }
 
+    // 任意单个输入线程调用, 不阻塞; 事件在下一帧开始时交给焦点窗口
+    bool postKeyEvent(const key_event_t& event) {
+        if (inputEvents.push(event)) return true;
+        droppedKeyEvents++;
+        return false;
+    }
+
+    // 输入到画面的延迟: 按键事件时间到包含响应的帧推送完成
+    void printInputStats() {
+        printf("Input: %lu frames with input, latency avg %.1fms max %.1fms, %lu dropped\n",
+               (unsigned long)inputFrames, inputFrames ? inputLatencySumUs / 1000.0f / inputFrames : 0.0f,
+               inputLatencyMaxUs / 1000.0f, (unsigned long)droppedKeyEvents);
+    }
+
+    void resetInputStats() {
+        inputFrames = 0;
+        inputLatencySumUs = 0;
+        inputLatencyMaxUs = 0;
+        droppedKeyEvents = 0;
+    }
+
 #define SHOW_FPS
 
-    // 显示所有窗口
+    // 显示所有窗口: 只重新合成脏区域, 只把脏区域所在的列与页推送到屏幕, 没有变化时不推送
     void display_all() {
+        dispatchKeyEvents();
         updateAnimations();
+        collectDamage();
 
-        for (auto& row : covered) {
-            std::fill(row.begin(), row.end(), false);
+        // 帧率文字只在数值变化 (每秒统计一次), 开关切换, 或被其他脏区域盖住时重绘
+        const ScreenRect fpsRect = {0, 0, FPS_TEXT_WIDTH, 8};
+        if (fpsDirty || (showFps && (updateFps() || damage.intersects(fpsRect)))) {
+            damage.add(fpsRect);
+            fpsDirty = false;
         }
-
-        for (auto window : windows) {
-            if (window->getWindowType() == MODAL_WINDOW || window->getWindowType() == POPUP_WINDOW) {
-                continue;
-            }
-            renderWindowContent(window);
+        if (damage.empty()) {
+            skippedFrames++;
+            recordInputLatency();
+            return;
         }
 
         bool hasModalOrPopup = std::any_of(windows.begin(), windows.end(), [](Window* w) {
             return w->getWindowType() == MODAL_WINDOW || w->getWindowType() == POPUP_WINDOW;
         });
 
-        if (hasModalOrPopup) {
-            drawCheckerboardMask();
-        }
-
-        for (auto window : windows) {
-            if (window->getWindowType() == MODAL_WINDOW || window->getWindowType() == POPUP_WINDOW) {
-                renderWindowContent(window);
-            }
-        }
-
         if (xSemaphoreTake(displayMutex, portMAX_DELAY) == pdTRUE) {
-            if (showFps) {
-                static unsigned long lastFrameTime = 0;
-                unsigned long currentTime = millis();
-                unsigned long frameTime = currentTime - lastFrameTime;
-                lastFrameTime = currentTime;
-
+            for (int i = 0; i < damage.size(); i++) {
+                composite(damage[i], hasModalOrPopup);
+            }
+            if (showFps && damage.intersects(fpsRect)) {
                 display->setTextSize(1);
                 display->setTextColor(SSD1306_WHITE);
                 display->setCursor(0, 0);
-                display->printf("FPS: %lu", frameTime > 0 ? 1000 / frameTime : 0);
+                display->printf("FPS: %lu", (unsigned long)shownFps);
+            }
+            for (int i = 0; i < damage.size(); i++) {
+                const ScreenRect& r = damage[i];
+                display->displayRegion(r.x0, r.y0, r.x1, r.y1);
             }
-            display->display();
             xSemaphoreGive(displayMutex);
         }
+        composedFrames++;
+        fpsFrames++;
+        composedPixels += damage.area();
+        damage.clear();
+        recordInputLatency();
+    }
+
+    // 下一帧整屏重绘 (例如屏幕被窗口管理器以外的代码改写之后)
+    void invalidate() {
+        fullRedraw = true;
+    }
+
+    // 合成统计: 推送的帧, 无变化跳过的帧, 平均合成像素与 SPI 字节
+    void printDisplayStats() {
+        printf("Display: %lu frames pushed, %lu skipped, avg %lu px composited, %lu bytes pushed\n",
+               (unsigned long)composedFrames, (unsigned long)skippedFrames,
+               (unsigned long)(composedFrames ? composedPixels / composedFrames : 0),
+               (unsigned long)(composedFrames ? display->pushedBytes / composedFrames : 0));
+    }
+
+    void resetDisplayStats() {
+        composedFrames = 0;
+        skippedFrames = 0;
+        composedPixels = 0;
+        display->pushedBytes = 0;
+        display->pushes = 0;
     }
 
     int getForegroundWindowIndex() const {
@@ -326,6 +526,7 @@ public:
     }
 
     void setShowFps(bool status) {
+        if (status != showFps) fpsDirty = true;
         showFps = status;
     }
 
@@ -334,13 +535,99 @@ public:
     }
 
 private:
-    Adafruit_SSD1306* display;
+    RegionSSD1306* display;
     std::vector<Window*> windows;
     DitheringType ditheringType;
-    std::vector<std::vector<bool>> covered;
+    uint64_t covered[SCREEN_HEIGHT][COVER_WORDS];   // 合成时已被上层占据的像素, 每行一个位图
     std::vector<Window*> unregisterPendingWindows;
     SemaphoreHandle_t displayMutex = xSemaphoreCreateMutex();
     bool showFps = false;
+    bool fpsDirty = false;
+    uint32_t fpsFrames = 0;         // 推送的帧数, 不随 resetDisplayStats 清零
+    uint32_t fpsFrameBase = 0;
+    unsigned long fpsWindowStart = 0;
+    uint32_t shownFps = 0;
+    SpscRing<key_event_t> inputEvents{INPUT_RING_SIZE};
+    volatile uint32_t droppedKeyEvents = 0;
+    uint32_t inputFrames = 0;
+    int64_t inputLatencySumUs = 0;
+    int64_t inputLatencyMaxUs = 0;
+    DamageList damage;
+    bool fullRedraw = true;
+    bool lastHadModal = false;
+    uint32_t composedFrames = 0;
+    uint32_t skippedFrames = 0;
+    uint64_t composedPixels = 0;
+
+    // 每秒统计一次实际推送的帧率; 返回显示的数值是否变化
+    bool updateFps() {
+        unsigned long now = millis();
+        if (now - fpsWindowStart < 1000) return false;
+        uint32_t fps = (fpsFrames - fpsFrameBase) * 1000 / (now - fpsWindowStart);
+        fpsWindowStart = now;
+        fpsFrameBase = fpsFrames;
+        if (fps == shownFps) return false;
+        shownFps = fps;
+        return true;
+    }
+
+    void dispatchKeyEvents() {
+        key_event_t event;
+        while (inputEvents.pop(event)) {
+            pushKeyEvent(event);
+        }
+    }
+
+    void recordInputLatency() {
+        int64_t now = esp_timer_get_time();
+        for (auto window : windows) {
+            int64_t t = window->takeFrameInputTime();
+            if (!t) continue;
+            int64_t latency = now - t;
+            inputFrames++;
+            inputLatencySumUs += latency;
+            if (latency > inputLatencyMaxUs) inputLatencyMaxUs = latency;
+        }
+    }
+
+    // 窗口在屏幕上占据的区域 (含动画偏移与边框)
+    ScreenRect screenRect(Window* window) {
+        int16_t x = window->getPosX();
+        int16_t y = window->getPosY() + getAnimationOffset(window);
+        int16_t b = window->hasBorderEnabled() ? 1 : 0;
+        return {(int16_t)(x - b), (int16_t)(y - b), (int16_t)(x + window->getWidth() + b), (int16_t)(y + window->getHeight() + b)};
+    }
+
+    // 汇总本帧的脏区域: 窗口内容变化, 移动 / 缩放 / 动画露出与覆盖的区域, 模态遮罩的出现与消失
+    void collectDamage() {
+        bool hasModal = std::any_of(windows.begin(), windows.end(), [](Window* w) {
+            return w->getWindowType() == MODAL_WINDOW || w->getWindowType() == POPUP_WINDOW;
+        });
+        if (hasModal != lastHadModal) {
+            lastHadModal = hasModal;
+            fullRedraw = true;
+        }
+        if (fullRedraw) {
+            fullRedraw = false;
+            damage.add({0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
+        }
+        for (auto window : windows) {
+            ScreenRect r = screenRect(window);
+            ScreenRect d = window->takeDamage();
+            if (!(r == window->composedRect)) {
+                damage.add(window->composedRect);
+                damage.add(r);
+                window->composedRect = r;
+            } else if (!d.empty()) {
+                int16_t b = window->hasBorderEnabled() ? 1 : 0;
+                // 误差扩散依赖前面的像素, 有变化时整窗重绘
+                if (window->getDitheringType() == ERROR_DIFFUSION) {
+                    d = {0, 0, (int16_t)window->getWidth(), (int16_t)window->getHeight()};
+                }
+                damage.add(d.offset(r.x0 + b, r.y0 + b));
+            }
+        }
+    }
 
     struct AnimationState {
         Window* window;
@@ -351,23 +638,6 @@ private:
 
     std::vector<AnimationState> animations;
 
-    void updateCoveredAreas() {
-        for (auto& row : covered) {
-            std::fill(row.begin(), row.end(), false);
-        }
-        for (const auto& window : windows) {
-            int16_t x = window->getPosX();
-            int16_t y = window->getPosY();
-            uint16_t w = window->getWidth();
-            uint16_t h = window->getHeight();
-            for (int16_t i = x; i < x + w && i < SCREEN_WIDTH; i++) {
-                for (int16_t j = y; j < y + h && j < SCREEN_HEIGHT; j++) {
-                    covered[i][j] = true;
-                }
-            }
-        }
-    }
-
     void enforceFixedLayerOrder() {
         auto fixedBottomEnd = std::stable_partition(windows.begin(), windows.end(), [](Window* w) {
             return w->getWindowType() == FIXED_BOTTOM_WINDOW;
@@ -392,70 +662,171 @@ private:
         return windows.size();
     }
 
-    void drawWindowBorder(int16_t x, int16_t y, uint16_t w, uint16_t h) {
-        display->drawRect(x - 1, y - 1, w + 2, h + 2, SSD1306_WHITE);
+    static bool isOverlay(Window* window) {
+        return window->getWindowType() == MODAL_WINDOW || window->getWindowType() == POPUP_WINDOW;
     }
 
-    void drawCheckerboardMask() {
-        for (int16_t i = 0; i < SCREEN_WIDTH; i++) {
-            for (int16_t j = 0; j < SCREEN_HEIGHT; j++) {
-                if (!covered[i][j] && ((i + j) & 1) == 0) { 
-                    display->drawPixel(i, j, SSD1306_BLACK);
+    // 第 word 个字中属于 [x0, x1) 的位
+    static uint64_t spanBits(int word, int16_t x0, int16_t x1) {
+        int lo = std::max<int>(x0 - word * 64, 0);
+        int hi = std::min<int>(x1 - word * 64, 64);
+        if (lo >= hi) {
+            return 0;
+        }
+        uint64_t bits = hi == 64 ? ~0ull : (1ull << hi) - 1;
+        return bits & ~((1ull << lo) - 1);
+    }
+
+    // 第 y 行 [x0, x1) 中尚未被覆盖的像素, 返回是否非空
+    bool visibleSpan(int16_t y, int16_t x0, int16_t x1, uint64_t* visible) const {
+        uint64_t any = 0;
+        for (int w = 0; w < COVER_WORDS; w++) {
+            visible[w] = spanBits(w, x0, x1) & ~covered[y][w];
+            any |= visible[w];
+        }
+        return any != 0;
+    }
+
+    void cover(int16_t y, const uint64_t* bits) {
+        for (int w = 0; w < COVER_WORDS; w++) {
+            covered[y][w] |= bits[w];
+        }
+    }
+
+    // 合成一个脏矩形: 先清为背景, 再自顶向下绘制与之相交的窗口
+    // 每个像素只由最上层可见的窗口写一次, 被上层完全遮住的行只做一次位运算
+    void composite(const ScreenRect& clip, bool hasModalOrPopup) {
+        display->fillRect(clip.x0, clip.y0, clip.x1 - clip.x0, clip.y1 - clip.y0, SSD1306_BLACK);
+        for (int16_t y = clip.y0; y < clip.y1; y++) {
+            memset(covered[y], 0, sizeof(covered[y]));
+        }
+
+        for (auto it = windows.rbegin(); it != windows.rend(); ++it) {
+            if (isOverlay(*it)) {
+                renderWindowContent(*it, clip);
+            }
+        }
+
+        if (hasModalOrPopup) {
+            drawCheckerboardMask(clip);
+        }
+
+        for (auto it = windows.rbegin(); it != windows.rend(); ++it) {
+            if (!isOverlay(*it)) {
+                renderWindowContent(*it, clip);
+            }
+        }
+    }
+
+    // 边框只画落在 clip 内且未被遮挡的部分
+    void drawWindowBorder(int16_t x, int16_t y, uint16_t w, uint16_t h, const ScreenRect& clip) {
+        ScreenRect edges[4] = {
+            {(int16_t)(x - 1), (int16_t)(y - 1), (int16_t)(x + w + 1), y},
+            {(int16_t)(x - 1), (int16_t)(y + h), (int16_t)(x + w + 1), (int16_t)(y + h + 1)},
+            {(int16_t)(x - 1), y, x, (int16_t)(y + h)},
+            {(int16_t)(x + w), y, (int16_t)(x + w + 1), (int16_t)(y + h)},
+        };
+        uint64_t visible[COVER_WORDS];
+        for (const ScreenRect& e : edges) {
+            ScreenRect r = e.intersect(clip);
+            if (r.empty()) {
+                continue;
+            }
+            for (int16_t row = r.y0; row < r.y1; row++) {
+                if (!visibleSpan(row, r.x0, r.x1, visible)) {
+                    continue;
                 }
+                drawBits(row, visible, SSD1306_WHITE);
+                cover(row, visible);
             }
         }
     }
 
-    void renderWindowContent(Window* window) {
-        if (xSemaphoreTake(window->bufferMutex, portMAX_DELAY) == pdTRUE) {
-            uint8_t* buffer = window->getDisplayBuffer();
-            int16_t posX = window->getPosX();
-            int16_t posY = window->getPosY();
-            uint16_t width = window->getWidth();
-            uint16_t height = window->getHeight();
+    void drawBits(int16_t y, const uint64_t* bits, uint16_t color) {
+        for (int w = 0; w < COVER_WORDS; w++) {
+            uint64_t b = bits[w];
+            while (b) {
+                display->drawPixel(w * 64 + __builtin_ctzll(b), y, color);
+                b &= b - 1;
+            }
+        }
+    }
 
-            DitheringType dithering = window->getDitheringType();
-            bool orderedDithering = (dithering == ORDERED_DITHERING);
+    // 模态窗口下方: 偶数格像素保持黑色 (composite 开头已清为黑色), 只需标记为已覆盖
+    void drawCheckerboardMask(const ScreenRect& clip) {
+        for (int16_t j = clip.y0; j < clip.y1; j++) {
+            uint64_t parity = (j & 1) ? 0xAAAAAAAAAAAAAAAAull : 0x5555555555555555ull;
+            for (int w = 0; w < COVER_WORDS; w++) {
+                covered[j][w] |= spanBits(w, clip.x0, clip.x1) & parity;
+            }
+        }
+    }
 
-            int16_t renderOffsetY = getAnimationOffset(window);
-            int16_t renderPosY = posY + renderOffsetY;
+    void renderWindowContent(Window* window, const ScreenRect& clip) {
+        int16_t posX = window->getPosX();
+        int16_t renderPosY = window->getPosY() + getAnimationOffset(window);
+        uint16_t width = window->getWidth();
+        uint16_t height = window->getHeight();
+        if (window->hasBorderEnabled()) {
+            drawWindowBorder(posX, renderPosY, width, height, clip);
+        }
+        // 窗口内容与脏矩形的交集 (窗口坐标)
+        ScreenRect area = ScreenRect{posX, renderPosY, (int16_t)(posX + width), (int16_t)(renderPosY + height)}
+                              .intersect(clip).offset(-posX, -renderPosY);
+        if (area.empty()) {
+            return;
+        }
 
-            if (window->hasBorderEnabled()) {
-                drawWindowBorder(posX, renderPosY, width, height);
-            }
+        if (xSemaphoreTake(window->bufferMutex, portMAX_DELAY) == pdTRUE) {
+            uint8_t* buffer = window->getDisplayBuffer();
 
-            for (int16_t y = 0; y < height; y++) {
-                for (int16_t x = 0; x < width; x++) {
-                    int16_t screenX = posX + x;
-                    int16_t screenY = renderPosY + y;
+            DitheringType dithering = window->getDitheringType();
+            uint64_t visible[COVER_WORDS];
+
+            for (int16_t y = area.y0; y < area.y1; y++) {
+                int16_t screenY = renderPosY + y;
+                bool any = visibleSpan(screenY, posX + area.x0, posX + area.x1, visible);
+
+                // 误差扩散依赖整行的扫描顺序, 被遮住的像素也要参与扩散
+                if (dithering == ERROR_DIFFUSION) {
+                    for (int16_t x = area.x0; x < area.x1; x++) {
+                        uint8_t pixelValue = buffer[x + y * width];
+                        bool isWhite = pixelValue > 127;
+                        int error = pixelValue - (isWhite ? 255 : 0);
+
+                        if (x + 1 < width)                buffer[(x + 1) + y * width] += (error * 7) >> 4;
+                        if (y + 1 < height) {
+                            if (x > 0)                   buffer[(x - 1) + (y + 1) * width] += (error * 3) >> 4;
+                                                        buffer[x + (y + 1) * width] += (error * 5) >> 4;
+                            if (x + 1 < width)           buffer[(x + 1) + (y + 1) * width] += error >> 4;
+                        }
 
-                    if (screenX >= SCREEN_WIDTH || screenY >= SCREEN_HEIGHT || screenY < 0 || covered[screenX][screenY]) {
-                        continue;
+                        int16_t screenX = posX + x;
+                        if ((visible[screenX >> 6] >> (screenX & 63)) & 1) {
+                            display->drawPixel(screenX, screenY, isWhite ? SSD1306_WHITE : SSD1306_BLACK);
+                        }
                     }
-
-                    uint8_t pixelValue = buffer[x + y * width];
-                    bool isWhite;
-
-                    if (dithering != NO_DITHERING) {  // 如果启用了抖动
-                        if (orderedDithering) {  // 有序抖动
-                            int ditherThreshold = bayerMatrix[y & 3][x & 3];  // y % 4 -> y & 3, x % 4 -> x & 3
-                            isWhite = pixelValue > ditherThreshold;
-                        } else if (dithering == ERROR_DIFFUSION) {  // 误差扩散抖动
-                            isWhite = pixelValue > 127;
-                            int error = pixelValue - (isWhite ? 255 : 0);
-
-                            if (x + 1 < width)                buffer[(x + 1) + y * width] += (error * 7) >> 4;
-                            if (y + 1 < height) {
-                                if (x > 0)                   buffer[(x - 1) + (y + 1) * width] += (error * 3) >> 4;
-                                                            buffer[x + (y + 1) * width] += (error * 5) >> 4;
-                                if (x + 1 < width)           buffer[(x + 1) + (y + 1) * width] += error >> 4;
+                } else if (any) {
+                    // 只遍历可见位
+                    for (int w = 0; w < COVER_WORDS; w++) {
+                        uint64_t b = visible[w];
+                        while (b) {
+                            int16_t screenX = w * 64 + __builtin_ctzll(b);
+                            b &= b - 1;
+                            int16_t x = screenX - posX;
+                            uint8_t pixelValue = buffer[x + y * width];
+                            bool isWhite;
+                            if (dithering == ORDERED_DITHERING) {
+                                isWhite = pixelValue > bayerMatrix[y & 3][x & 3];  // y % 4 -> y & 3, x % 4 -> x & 3
+                            } else {  // 不启用抖动
+                                isWhite = pixelValue;
                             }
+                            display->drawPixel(screenX, screenY, isWhite ? SSD1306_WHITE : SSD1306_BLACK);
                         }
-                    } else {  // 不启用抖动
-                        isWhite = pixelValue;
                     }
-
-                    display->drawPixel(screenX, screenY, isWhite ? SSD1306_WHITE : SSD1306_BLACK);
+                }
+                if (any) {
+                    cover(screenY, visible);
                 }
             }
             xSemaphoreGive(window->bufferMutex);
@@ -503,6 +874,7 @@ private:
                 return anim.window == pendingWindow && !anim.active;
             });
             if (animIt != animations.end()) {
+                damage.add(pendingWindow->composedRect);
                 windows.erase(std::remove(windows.begin(), windows.end(), pendingWindow), windows.end());
                 delete pendingWindow;
                 it = unregisterPendingWindows.erase(it);
@@ -683,4 +1055,6 @@ void runDemoTask(void* pvParameters) {
         vTaskDelay(24);
     }
 }
-*/
\ No newline at end of file
+*/
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "platform_compat.h"
+#include "audio_health.h"
+#include "src_config.h"
+
+#ifdef ESP_PLATFORM
+#include "driver/i2s_std.h"
+#endif
+
+typedef enum {
+    AUDIO_BACKEND_I2S,   // ESP32 I2S (仅目标板)
+    AUDIO_BACKEND_WAV,   // 写入 WAV 文件
+    AUDIO_BACKEND_NULL,  // 丢弃数据, 只计数
+    AUDIO_BACKEND_PIPE,  // 原始 s16le PCM 写到 stdout
+    AUDIO_BACKEND_COUNT
+} audio_backend_t;
+
+const char* const audio_backend_name[AUDIO_BACKEND_COUNT] = {"i2s", "wav", "null", "pipe"};
+
+// pipe 后端的输出流, 为空时使用 stdout
+FILE* audio_pipe_stream = nullptr;
+
+// 音频输出后端, 每次写入一个单声道 int16 块
+class AudioBackend {
+public:
+    uint64_t framesWritten = 0;
+
+    virtual bool begin() = 0;
+    virtual void end() = 0;
+    // 写入 frames 个采样, 实时后端会阻塞到有空间为止
+    virtual size_t write(const int16_t* data, size_t frames) = 0;
+    // 实时后端的写入阻塞决定了引擎节拍
+    virtual bool isRealtime() { return false; }
+    virtual ~AudioBackend() {}
+};
+
+class NullAudioBackend: public AudioBackend {
+public:
+    bool begin() { return true; }
+    void end() {}
+    size_t write(const int16_t*, size_t frames) {
+        framesWritten += frames;
+        return frames;
+    }
+};
+
+// 写入原始 PCM, 默认写到 stdout, 可直接接 aplay -f S16_LE -c 1 -r 44100
+class PipeAudioBackend: public AudioBackend {
+public:
+    PipeAudioBackend(FILE* stream = nullptr): stream(stream ? stream : (audio_pipe_stream ? audio_pipe_stream : stdout)) {}
+
+    bool begin() {
+        return stream != nullptr;
+    }
+    void end() {
+        fflush(stream);
+    }
+    size_t write(const int16_t* data, size_t frames) {
+        size_t n = fwrite(data, sizeof(int16_t), frames, stream);
+        framesWritten += n;
+        return n;
+    }
+
+private:
+    FILE* stream;
+};
+
+class WavAudioBackend: public AudioBackend {
+public:
+    WavAudioBackend(const char* filePath) {
+        strncpy(path, filePath, sizeof(path) - 1);
+    }
+
+    bool begin() {
+        file = fopen(path, "wb");
+        if (!file) {
+            printf("WAV: cannot open %s\n", path);
+            return false;
+        }
+        framesWritten = 0;
+        writeHeader(0);
+        return true;
+    }
+    void end() {
+        if (!file) return;
+        // 回填 RIFF/data 长度
+        fseek(file, 0, SEEK_SET);
+        writeHeader(framesWritten * sizeof(int16_t));
+        fclose(file);
+        file = nullptr;
+        printf("WAV: %s closed, %llu frames\n", path, (unsigned long long)framesWritten);
+    }
+    size_t write(const int16_t* data, size_t frames) {
+        if (!file) return 0;
+        size_t n = fwrite(data, sizeof(int16_t), frames, file);
+        framesWritten += n;
+        return n;
+    }
+    ~WavAudioBackend() {
+        end();
+    }
+
+private:
+    char path[64] = {};
+    FILE* file = nullptr;
+
+    static void putLE(uint8_t* p, uint32_t v, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            p[i] = (v >> (i * 8)) & 0xFF;
+        }
+    }
+
+    void writeHeader(uint32_t dataBytes) {
+        uint8_t h[44];
+        memcpy(h, "RIFF", 4);
+        putLE(h + 4, 36 + dataBytes, 4);
+        memcpy(h + 8, "WAVEfmt ", 8);
+        putLE(h + 16, 16, 4);                         // fmt 块长度
+        putLE(h + 20, 1, 2);                          // PCM
+        putLE(h + 22, 1, 2);                          // 单声道
+        putLE(h + 24, SMP_RATE, 4);
+        putLE(h + 28, SMP_RATE * sizeof(int16_t), 4); // 字节率
+        putLE(h + 32, sizeof(int16_t), 2);            // 块对齐
+        putLE(h + 34, 16, 2);                         // 位深
+        memcpy(h + 36, "data", 4);
+        putLE(h + 40, dataBytes, 4);
+        fwrite(h, 1, sizeof(h), file);
+    }
+};
+
+#ifdef ESP_PLATFORM
+class I2SAudioBackend: public AudioBackend {
+public:
+    i2s_chan_handle_t tx_handle = nullptr;
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SMP_RATE),
+        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = GPIO_NUM_42,
+            .ws = GPIO_NUM_40,
+            .dout = GPIO_NUM_41,
+            .din = I2S_GPIO_UNUSED,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+
+    // DMA 已发送完所有缓冲且没有新数据, 即欠载
+    static bool IRAM_ATTR onSendQueueOverflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+        audio_health.reportUnderrunFromISR();
+        return false;
+    }
+
+    bool begin() {
+        // 每个 DMA 描述符对应一个块, 欠载时输出静音而不是重复旧数据
+        chan_cfg.dma_desc_num = AUDIO_DMA_BLOCKS;
+        chan_cfg.dma_frame_num = AUDIO_BLOCK_SIZE;
+        chan_cfg.auto_clear = true;
+        if (i2s_new_channel(&chan_cfg, &tx_handle, NULL) != ESP_OK) {
+            printf("i2s: channel allocation failed\n");
+            return false;
+        }
+        i2s_channel_init_std_mode(tx_handle, &std_cfg);
+        i2s_event_callbacks_t cbs = {};
+        cbs.on_send_q_ovf = onSendQueueOverflow;
+        i2s_channel_register_event_callback(tx_handle, &cbs, this);
+        i2s_channel_enable(tx_handle);
+        printf("i2s start!\n");
+        return true;
+    }
+    void end() {
+        if (!tx_handle) return;
+        i2s_channel_disable(tx_handle);
+        i2s_del_channel(tx_handle);
+        tx_handle = nullptr;
+        printf("i2s is disable\n");
+    }
+    size_t write(const int16_t* data, size_t frames) {
+        size_t writed = 0;
+        i2s_channel_write(tx_handle, data, frames * sizeof(int16_t), &writed, portMAX_DELAY);
+        framesWritten += writed / sizeof(int16_t);
+        return writed / sizeof(int16_t);
+    }
+    bool isRealtime() {
+        return true;
+    }
+    ~I2SAudioBackend() {
+        end();
+    }
+};
+#endif
+
+// 按类型创建后端, 不支持的类型返回 nullptr
+inline AudioBackend* createAudioBackend(audio_backend_t type, const char* wavPath) {
+    switch (type) {
+#ifdef ESP_PLATFORM
+        case AUDIO_BACKEND_I2S:
+            return new I2SAudioBackend();
+#endif
+        case AUDIO_BACKEND_WAV:
+            return new WavAudioBackend(wavPath);
+        case AUDIO_BACKEND_NULL:
+            return new NullAudioBackend();
+        case AUDIO_BACKEND_PIPE:
+            return new PipeAudioBackend();
+        default:
+            return nullptr;
+    }
+}
+
+#endif
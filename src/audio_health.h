@@ -0,0 +1,159 @@
+#ifndef AUDIO_HEALTH_H
+#define AUDIO_HEALTH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "platform_compat.h"
+#include "src_config.h"
+
+typedef enum {
+    XRUN_UNDERRUN,     // I2S DMA 缓冲耗尽, 硬件输出了静音
+    XRUN_LATE_BLOCK    // 块渲染时间超过块周期
+} xrun_type_t;
+
+typedef struct {
+    int64_t timestamp;   // esp_timer 时间 (us)
+    uint32_t block;      // 发生时的块序号
+    int32_t margin;      // 截止时间余量 (us), 负数为超时
+    xrun_type_t type;
+} xrun_event_t;
+
+// 音频引擎健康统计, 由引擎循环和输出模块 (含 ISR) 共同更新
+class AudioHealth {
+public:
+    // 一个块的时间预算 (us)
+    static const int32_t BLOCK_DEADLINE_US = (int32_t)((int64_t)AUDIO_BLOCK_SIZE * 1000000 / SMP_RATE);
+
+    volatile uint32_t blocks = 0;
+    volatile uint32_t underruns = 0;
+    volatile uint32_t lateBlocks = 0;
+    int32_t lastRenderUs = 0;
+    int32_t worstRenderUs = 0;
+    int32_t worstMarginUs = BLOCK_DEADLINE_US;
+
+    // 引擎循环在每块开始时调用
+    void beginBlock() {
+        blockStart = esp_timer_get_time();
+        sinkWaitUs = 0;
+        sinkPresent = false;
+    }
+
+    // 输出模块报告本块阻塞等待 DMA 的时间, 该时间不计入渲染时间
+    void addSinkWait(int64_t us) {
+        sinkWaitUs += us;
+        sinkPresent = true;
+    }
+
+    // 本块是否有输出模块负责节拍
+    bool blockHadSink() const {
+        return sinkPresent;
+    }
+
+    // 引擎循环在每块结束时调用
+    void endBlock() {
+        int32_t render = (int32_t)(esp_timer_get_time() - blockStart - sinkWaitUs);
+        int32_t margin = BLOCK_DEADLINE_US - render;
+        lastRenderUs = render;
+        if (render > worstRenderUs) worstRenderUs = render;
+        if (margin < worstMarginUs) worstMarginUs = margin;
+        if (margin < 0) {
+            lateBlocks++;
+            logXrun(XRUN_LATE_BLOCK, margin);
+        }
+        blocks++;
+        // 第一个块送出后才开始统计欠载, 避免启动阶段的误报
+        if (sinkPresent) armed = true;
+    }
+
+    // I2S 发送队列溢出回调中调用 (DMA 已无新数据可发)
+    void IRAM_ATTR reportUnderrunFromISR() {
+        if (!armed) return;
+        portENTER_CRITICAL_ISR(&lock);
+        underruns++;
+        pushXrun(XRUN_UNDERRUN, 0);
+        portEXIT_CRITICAL_ISR(&lock);
+    }
+
+    // 读取最近的 xrun 记录 (从旧到新), 返回数量
+    int getXruns(xrun_event_t* out, int maxCount) {
+        portENTER_CRITICAL(&lock);
+        int count = xrunCount < maxCount ? xrunCount : maxCount;
+        for (int i = 0; i < count; i++) {
+            out[i] = xrunLog[(xrunHead + XRUN_LOG_SIZE - count + i) % XRUN_LOG_SIZE];
+        }
+        portEXIT_CRITICAL(&lock);
+        return count;
+    }
+
+    // 平均负载 (%), 按最近一块计算
+    int getLoadPercent() const {
+        return lastRenderUs * 100 / BLOCK_DEADLINE_US;
+    }
+
+    void reset() {
+        portENTER_CRITICAL(&lock);
+        blocks = 0;
+        underruns = 0;
+        lateBlocks = 0;
+        worstRenderUs = 0;
+        worstMarginUs = BLOCK_DEADLINE_US;
+        xrunHead = 0;
+        xrunCount = 0;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    void printStatus() {
+        printf("Audio health: block=%d smp, deadline=%ldus\n", AUDIO_BLOCK_SIZE, (long)BLOCK_DEADLINE_US);
+        printf(" Blocks: %lu\n", (unsigned long)blocks);
+        printf(" Underruns: %lu\n", (unsigned long)underruns);
+        printf(" Late blocks: %lu\n", (unsigned long)lateBlocks);
+        printf(" Render: last=%ldus worst=%ldus load=%d%%\n", (long)lastRenderUs, (long)worstRenderUs, getLoadPercent());
+        printf(" Worst margin: %ldus\n", (long)worstMarginUs);
+    }
+
+    void printXruns() {
+        xrun_event_t log[XRUN_LOG_SIZE];
+        int count = getXruns(log, XRUN_LOG_SIZE);
+        printf("Recent xruns (%d):\n", count);
+        for (int i = 0; i < count; i++) {
+            printf(" [%lld.%06lld] block %lu %s", (long long)(log[i].timestamp / 1000000), (long long)(log[i].timestamp % 1000000),
+                   (unsigned long)log[i].block, log[i].type == XRUN_UNDERRUN ? "UNDERRUN" : "LATE");
+            if (log[i].type == XRUN_LATE_BLOCK) {
+                printf(" margin=%ldus", (long)log[i].margin);
+            }
+            printf("\n");
+        }
+    }
+
+private:
+    int64_t blockStart = 0;
+    int64_t sinkWaitUs = 0;
+    bool sinkPresent = false;
+    volatile bool armed = false;
+
+    xrun_event_t xrunLog[XRUN_LOG_SIZE];
+    int xrunHead = 0;
+    int xrunCount = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void logXrun(xrun_type_t type, int32_t margin) {
+        portENTER_CRITICAL(&lock);
+        pushXrun(type, margin);
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // 调用前需持有 lock
+    void IRAM_ATTR pushXrun(xrun_type_t type, int32_t margin) {
+        xrun_event_t& ev = xrunLog[xrunHead];
+        ev.timestamp = esp_timer_get_time();
+        ev.block = blocks;
+        ev.margin = margin;
+        ev.type = type;
+        xrunHead = (xrunHead + 1) % XRUN_LOG_SIZE;
+        if (xrunCount < XRUN_LOG_SIZE) xrunCount++;
+    }
+};
+
+AudioHealth audio_health;
+
+#endif
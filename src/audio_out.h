@@ -1,67 +1,92 @@
 #ifndef AUDIO_OUT_H
 #define AUDIO_OUT_H
 
-#include "driver/i2s_std.h"
+#include <memory>
 #include "module_manager.hpp"
+#include "audio_backend.h"
+#include "audio_health.h"
+#include "master_limiter.h"
+#include "bench.h"
 #include "src_config.h"
-#include "FreeRTOS.h"
 
-const int BUFF_SIZE = 2048;
+#ifdef ESP_PLATFORM
+#define AUDIO_DEFAULT_BACKEND AUDIO_BACKEND_I2S
+#define AUDIO_WAV_PATH "/spiffs/audio_out.wav"
+#else
+#define AUDIO_DEFAULT_BACKEND AUDIO_BACKEND_NULL
+#define AUDIO_WAV_PATH "audio_out.wav"
+#endif
 
 class i2s_audio_out: public Module_t {
 public:
 
-    i2s_audio_out() { module_info = {"ESP32 I2S Audio Out", "libchara-dev", "Audio signal output using ESP32's I2S", false, false}; }
+    i2s_audio_out() { module_info = {"ESP32 I2S Audio Out", "libchara-dev", "Audio signal output using ESP32's I2S, WAV file, null sink or raw pipe", false, false}; }
 
-    size_t writed;
+    int16_t data[AUDIO_BLOCK_SIZE] = {};
 
-    int16_t buffer[BUFF_SIZE];
-    int16_t data = 0;
-    int16_t bufferPoint = 0;
-
-    i2s_chan_handle_t tx_handle;
-
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
-
-    i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SMP_RATE),
-        .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
-        .gpio_cfg = {
-            .mclk = I2S_GPIO_UNUSED,
-            .bclk = GPIO_NUM_42,
-            .ws = GPIO_NUM_40,
-            .dout = GPIO_NUM_41,
-            .din = I2S_GPIO_UNUSED,
-            .invert_flags = {
-                .mclk_inv = false,
-                .bclk_inv = false,
-                .ws_inv = false,
-            },
-        },
-    };
+    int backendType = AUDIO_DEFAULT_BACKEND;
+    int activeBackendType = -1;
+    std::unique_ptr<AudioBackend> backend;
+    MasterLimiter master;   // 参数直接绑定到主控级成员
 
     void start() {
-        registerPort(&data, PORT_AIN, "AUDIO OUTPUT", "audio output");
-        i2s_new_channel(&chan_cfg, &tx_handle, NULL);
-        i2s_channel_init_std_mode(tx_handle, &std_cfg);
-        i2s_channel_enable(tx_handle);
-        printf("i2s start!\n");
+        registerPort(data, PORT_AIN, "AUDIO OUTPUT", "audio output");
+        registerParam(&backendType, PARAM_INT, "Backend", "0:I2S 1:WAV 2:NULL 3:PIPE");
+        registerParam(&master.mode, PARAM_INT, "Master", "0:off 1:soft clip 2:limiter");
+        registerParam(&master.drive, PARAM_INT, "Drive", "Q8 (256 = 0 dB, max 8x)");
+        registerParam(&master.ceiling, PARAM_INT, "Ceiling", "Q15");
+        registerParam(&master.releaseMs, PARAM_INT, "Release", "ms");
+        registerParam(&master.dither, PARAM_INT, "Dither", "0:off 1:TPDF");
+        master.begin(sampleRate);
+        selectBackend(backendType);
     }
     void stop() {
-        i2s_channel_disable(tx_handle);
-        i2s_del_channel(tx_handle);
-        printf("i2s is disable\n");
+        if (backend) backend->end();
+        backend.reset();
+        activeBackendType = -1;
+    }
+    // 切换后端, 在音频线程的块边界上执行; 失败时退回 null 后端
+    void selectBackend(int type) {
+        if (backend) backend->end();
+        backend.reset(createAudioBackend((audio_backend_t)type, AUDIO_WAV_PATH));
+        if (!backend || !backend->begin()) {
+            printf("Audio backend %d unavailable, using null sink\n", type);
+            backend.reset(new NullAudioBackend());
+            backend->begin();
+        }
+        backendType = type;
+        activeBackendType = type;
     }
     void process() {
-        buffer[bufferPoint] = data;
-        // printf("buffer[%d] = %d;\n", bufferPoint, buffer[bufferPoint]);
-        bufferPoint++;
-        if (bufferPoint > BUFF_SIZE) {
-            i2s_channel_write(tx_handle, buffer, sizeof(buffer), &writed, portMAX_DELAY);
-            // printf("I2S: writed->%dBytes\n", writed);
-            bufferPoint = 0;
+        if (backendType != activeBackendType) {
+            selectBackend(backendType);
+        }
+        const int16_t* block = data;
+        int16_t mastered[AUDIO_BLOCK_SIZE];
+        if (master.mode != MASTER_OFF) {
+            master.process(data, mastered);
+            block = mastered;
+        } else {
+            master.bypass();
+        }
+        if (backend->isRealtime()) {
+            int64_t waitStart = esp_timer_get_time();
+            backend->write(block, AUDIO_BLOCK_SIZE);
+            audio_health.addSinkWait(esp_timer_get_time() - waitStart);
+        } else {
+            backend->write(block, AUDIO_BLOCK_SIZE);
         }
     }
+    // 主控级遥测: 增益衰减 (当前 / 自上次重置以来的最大值) 与软削波采样数
+    void printProfileDetail() {
+        if (master.mode == MASTER_OFF) return;
+        printf("    master: GR %4.1f dB (max %4.1f dB), soft clipped %u\n",
+               master.currentReductionDb(), master.maxReductionDb(), (unsigned)master.clippedSamples);
+    }
+    void resetProfile() {
+        Module_t::resetProfile();
+        master.resetTelemetry();
+    }
     void customSettingPage() {
 
     }
@@ -70,4 +95,33 @@ public:
     }
 };
 
-#endif
\ No newline at end of file
+// 测量各非实时后端的吞吐量 (I2S 由采样率决定, 不参与)
+inline void benchAudioBackends(uint32_t blocks) {
+    int16_t block[AUDIO_BLOCK_SIZE];
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        block[i] = i * 512;
+    }
+    // pipe 后端写到 /dev/null, 避免原始 PCM 冲掉终端
+    FILE* savedPipe = audio_pipe_stream;
+    FILE* devNull = fopen("/dev/null", "wb");
+    audio_pipe_stream = devNull;
+    for (int type = AUDIO_BACKEND_WAV; type < AUDIO_BACKEND_COUNT; type++) {
+        if (type == AUDIO_BACKEND_PIPE && !devNull) {
+            printf("%-24s unavailable (no /dev/null)\n", audio_backend_name[type]);
+            continue;
+        }
+        std::unique_ptr<AudioBackend> backend(createAudioBackend((audio_backend_t)type, AUDIO_WAV_PATH));
+        if (!backend || !backend->begin()) {
+            printf("%-24s unavailable\n", audio_backend_name[type]);
+            continue;
+        }
+        benchPrint(benchRun(audio_backend_name[type], blocks, AUDIO_BLOCK_SIZE, [&]() {
+            backend->write(block, AUDIO_BLOCK_SIZE);
+        }));
+        backend->end();
+    }
+    audio_pipe_stream = savedPipe;
+    if (devNull) fclose(devNull);
+}
+
+#endif
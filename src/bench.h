@@ -0,0 +1,50 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "platform_compat.h"
+#include "src_config.h"
+
+// 简单的基准测试工具, 目标板 (终端命令) 与主机 (native 环境) 通用
+typedef struct {
+    const char* name;
+    uint32_t iterations;
+    uint32_t samplesPerIteration;
+    int64_t totalUs;
+} bench_result_t;
+
+template<typename F>
+bench_result_t benchRun(const char* name, uint32_t iterations, uint32_t samplesPerIteration, F&& fn) {
+    fn(); // 预热, 填充缓存
+    int64_t start = esp_timer_get_time();
+    for (uint32_t i = 0; i < iterations; i++) {
+        fn();
+    }
+    bench_result_t r = {name, iterations, samplesPerIteration, esp_timer_get_time() - start};
+    return r;
+}
+
+// 每采样耗时, 相对实时的倍数, 以及单核可运行的实例数
+inline void benchPrint(const bench_result_t& r) {
+    double samples = (double)r.iterations * r.samplesPerIteration;
+    double nsPerSample = r.totalUs * 1000.0 / samples;
+    double realtime = nsPerSample > 0 ? 1e9 / SMP_RATE / nsPerSample : 0;
+    printf("%-24s %8.1f ns/smp %8.2f Msmp/s  x%.1f realtime (~%d per core)\n",
+           r.name, nsPerSample, samples / (r.totalUs > 0 ? r.totalUs : 1), realtime, (int)realtime);
+}
+
+// 对单个模块做基准测试: setup 负责填充输入端口与参数
+template<typename T, typename S>
+void benchModule(const char* name, uint32_t blocks, S&& setup) {
+    T* module = new T();
+    module->start();
+    setup(*module);
+    benchPrint(benchRun(name, blocks, AUDIO_BLOCK_SIZE, [&]() {
+        module->process();
+    }));
+    module->stop();
+    delete module;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef BLEP_OSC_H
+#define BLEP_OSC_H
+
+#include <stdint.h>
+#include "module_manager.hpp"
+#include "simple_osc.h"
+#include "bench.h"
+#include "src_config.h"
+
+typedef enum {
+    BLEP_SAW,
+    BLEP_PULSE,
+    BLEP_TRIANGLE,
+    BLEP_WAVE_COUNT
+} blep_wave_t;
+
+// PolyBLEP / PolyBLAMP 带限振荡器
+// 相位为 32 位累加器 (2^32 = 一个周期), 输出与修正量均为 Q15, 每采样无浮点运算
+class BlepOsc: public Module_t {
+public:
+    static const int32_t PWM_HALF = 16384; // PWM 端口 Q15, 16384 = 50%
+
+    BlepOsc() { module_info = {"blep osc", "libchara-dev", "Band-limited saw/pulse/triangle oscillator (PolyBLEP)", false, false}; }
+
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t pwm[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int wave = BLEP_SAW;
+
+    uint32_t phase = 0;
+
+    void start() {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            pwm[i] = PWM_HALF;
+        }
+        registerPort(freq, PORT_AIN, "FREQ IN", "frequency input (Hz)");
+        registerPort(pwm, PORT_AIN, "PWM", "pulse width, Q15 (16384 = 50%)");
+        registerPort(gate, PORT_DIN, "GATE", "gate");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
+        registerParam(&wave, PARAM_INT, "Wave type", "0:saw 1:pulse 2:triangle");
+        incPerHz = (uint32_t)(4294967296.0 / sampleRate);
+        printf("BlepOsc Start\n");
+    }
+    void stop() {
+        printf("BlepOsc Stop\n");
+    }
+    void process() {
+        switch (wave) {
+            case BLEP_PULSE:
+                renderLoop<BLEP_PULSE>();
+                break;
+            case BLEP_TRIANGLE:
+                renderLoop<BLEP_TRIANGLE>();
+                break;
+            default:
+                renderLoop<BLEP_SAW>();
+                break;
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+    // 跳变修正 (Q15): t 为距跳变的相位, dt 为每采样相位增量
+    // 跳变后一个采样内为 -(1-x)^2, 跳变前一个采样内为 (1-x)^2, x 为距跳变的采样数
+    static inline int32_t polyBlep(uint32_t t, uint32_t dt) {
+        if (t < dt) {
+            int32_t r = 32768 - (int32_t)(((uint64_t)t << 15) / dt);
+            return -((r * r) >> 15);
+        }
+        if (t > ~dt) {
+            int32_t r = 32768 - (int32_t)(((uint64_t)(0u - t) << 15) / dt);
+            return (r * r) >> 15;
+        }
+        return 0;
+    }
+
+    // 折点修正 (Q15), 单位斜率变化的积分形式: 两侧均为 (1-x)^3 / 3
+    static inline int32_t polyBlamp(uint32_t t, uint32_t dt) {
+        uint32_t d;
+        if (t < dt) {
+            d = t;
+        } else if (t > ~dt) {
+            d = 0u - t;
+        } else {
+            return 0;
+        }
+        int32_t r = 32768 - (int32_t)(((uint64_t)d << 15) / dt);
+        int32_t r3 = (((r * r) >> 15) * (int64_t)r) >> 15;
+        return (r3 * 10923) >> 15;
+    }
+
+private:
+    uint32_t incPerHz = 97391; // 2^32 / 44100
+
+    template<int WAVE>
+    void renderLoop() {
+        uint32_t p = phase;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            if (!gate[i]) {
+                out[i] = 0;
+                continue;
+            }
+            // 增量限制在奈奎斯特以下, 保证两侧修正区不重叠
+            uint32_t dt = freq[i] > 0 ? (uint32_t)freq[i] * incPerHz : 0;
+            if (dt > 0x7FFFFFFF) dt = 0x7FFFFFFF;
+            p += dt;
+            int32_t y;
+            if (dt == 0) {
+                y = WAVE == BLEP_SAW ? (int32_t)(p >> 16) - 32768 : 0;
+            } else if (WAVE == BLEP_SAW) {
+                y = (int32_t)(p >> 16) - 32768 - polyBlep(p, dt);
+            } else if (WAVE == BLEP_PULSE) {
+                // 占空比限制在 [dt, 1 - dt] 内
+                uint32_t pw = (uint32_t)(pwm[i] < 0 ? 0 : pwm[i]) << 17;
+                if (pw < dt) pw = dt;
+                if (pw > ~dt) pw = ~dt;
+                y = (p < pw ? 32767 : -32768) + polyBlep(p, dt) - polyBlep(p - pw, dt);
+            } else {
+                // 相位 0 处为最低点, 0.5 处为最高点, 斜率变化为每周期 8
+                y = p < 0x80000000u ? (int32_t)(p >> 15) - 32768 : 32767 - (int32_t)((p - 0x80000000u) >> 15);
+                int32_t k = dt >> 15; // 8 * dt 的一半, 由折点两侧的残差分摊, Q15
+                y += (int32_t)(((int64_t)k * (polyBlamp(p, dt) - polyBlamp(p - 0x80000000u, dt))) >> 15);
+            }
+            out[i] = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+        }
+        phase = p;
+    }
+};
+
+// 各波形单实例耗时 (440 Hz), 与旧的 SimpleOsc 对比
+inline void benchOscillators(uint32_t blocks) {
+    static const char* names[] = {"blep osc saw", "blep osc pulse", "blep osc triangle"};
+    for (int w = BLEP_SAW; w < BLEP_WAVE_COUNT; w++) {
+        benchModule<BlepOsc>(names[w], blocks, [w](BlepOsc& m) {
+            m.wave = w;
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m.freq[i] = 440;
+                m.gate[i] = 1;
+                m.pwm[i] = 8192;
+            }
+        });
+    }
+    benchModule<SimpleOsc>("simple osc", blocks, [](SimpleOsc& m) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            m.freq[i] = 440;
+            m.gate[i] = 1;
+        }
+    });
+}
+
+#endif
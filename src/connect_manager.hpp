@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 #include <vector>
+#include <array>
+#include <mutex>
 #include "src_config.h"
 #include "module_manager.hpp"
 
@@ -16,6 +18,9 @@ public:
     ModuleManager module_manager;
     std::vector<Module_t*> modules;
     std::vector<std::array<output_target_t, MAX_PORT>> connect_status;
+    // 保护 modules / connect_status 的增删: 终端任务增删模块, 界面任务遍历模块绘制视图
+    // 音频任务的 process_all 不取锁, 不能等待界面任务
+    std::mutex listMutex;
 
     size_t getSlotSize() {
         return modules.size();
@@ -38,11 +43,15 @@ public:
     }
 
     void createModule(const char* name) {
-        modules.push_back(module_manager.createModule(name));
+        std::lock_guard<std::mutex> lock(listMutex);
+        Module_t* module = module_manager.createModule(name);
+        if (!module) return;
+        modules.push_back(module);
         connect_status.push_back({});
     }
 
     int releaseModule(int slot) {
+        std::lock_guard<std::mutex> lock(listMutex);
         if (slot >= modules.size()) {printf("Slot Error\n");return -1;}
         module_manager.releaseModule(modules[slot]);
         // modules[slot] = nullptr;
@@ -59,10 +68,12 @@ public:
                     // printf("MODULE: %d, OUTPUT PORT: %d, INUM=%d ONUM=%d\n", i, p, connect_status[i][p].modules, connect_status[i][p].port);
                     if (connect_status[i][p].modules < 0 || connect_status[i][p].port < 0) continue;
                     // printf("MANAGER: PROCESS_F-> I=%d O=%d\n", *getInputPort(connect_status[i][p].modules, connect_status[i][p].port).data, *getOutputPort(i, p).data);
-                    *getInputPort(connect_status[i][p].modules, connect_status[i][p].port).data = *getOutputPort(i, p).data;
+                    memcpy(getInputPort(connect_status[i][p].modules, connect_status[i][p].port).data, getOutputPort(i, p).data, AUDIO_BLOCK_SIZE * sizeof(int16_t));
                     // printf("MANAGER: PROCESS_B-> I=%d O=%d\n", *getInputPort(connect_status[i][p].modules, connect_status[i][p].port).data, *getOutputPort(i, p).data);
                 }
+                uint32_t t0 = perf_ticks();
                 module->process();
+                module->profile.add(perf_ticks() - t0);
             } else {
                 printf("WARNING: MODULE #%d IS NULL!!\n", i);
             }
@@ -70,12 +81,45 @@ public:
     }
 
     int connect(int8_t sourceSlot, int8_t outputPort, int8_t targetSlot, int8_t inputPort) {
+        if (sourceSlot < 0 || sourceSlot >= (int)modules.size() || targetSlot < 0 || targetSlot >= (int)modules.size() ||
+            outputPort < 0 || outputPort >= getOutputPortCount(sourceSlot) || inputPort < 0 || inputPort >= getInputPortCount(targetSlot)) {
+            printf("Connect Error: no such port\n");
+            return -1;
+        }
+        // 事件端口与音频 / 数字端口的块布局不同, 只能同类相连
+        if (isEventPort(getOutputPort(sourceSlot, outputPort).type) != isEventPort(getInputPort(targetSlot, inputPort).type)) {
+            printf("Connect Error: cannot connect %s to %s (event / audio mismatch)\n",
+                   getOutputPort(sourceSlot, outputPort).name, getInputPort(targetSlot, inputPort).name);
+            return -1;
+        }
         connect_status[sourceSlot][outputPort] = {targetSlot, inputPort};
         // printf("connect[%d][%d] = {%d, %d};\n",sourceSlot ,outputPort ,connect_status[sourceSlot][outputPort].modules, connect_status[sourceSlot][outputPort].port);
         printf("Successfully connected output #%d of module #%d to input #%d of module #%d\n", outputPort, sourceSlot, inputPort, targetSlot);
         return 0;
     }
 
+    static bool isEventPort(port_type type) {
+        return type == PORT_EIN || type == PORT_EOUT;
+    }
+
+    // 打印各槽位模块的每块耗时及占块周期的比例
+    void printProfile() {
+        float deadline = (float)AUDIO_BLOCK_SIZE * 1000000 / SMP_RATE;
+        printf("Module profile (us/block, deadline %.0fus):\n", deadline);
+        for (size_t i = 0; i < modules.size(); i++) {
+            module_profile_t& p = modules[i]->profile;
+            printf(" #%d %-24s avg %6.1f peak %6.1f (%4.1f%%)\n", (int)i, modules[i]->module_info.name,
+                   p.averageUs(), p.peakUs(), p.averageUs() * 100 / deadline);
+            modules[i]->printProfileDetail();
+        }
+    }
+
+    void resetProfile() {
+        for (auto module : modules) {
+            module->resetProfile();
+        }
+    }
+
     void printModuleInfo() {
         for (uint8_t m = 0; m < getSlotSize(); m++) {
             module_info_t info = modules[m]->module_info;
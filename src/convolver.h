@@ -0,0 +1,572 @@
+#ifndef CONVOLVER_H
+#define CONVOLVER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "sample_source.h"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define CONV_MAX_MS 1000
+#define CONV_FFT_MAX_BITS 12                // 尾部分区最大 2048, FFT 4096
+#define CONV_FFT_MAX (1 << CONV_FFT_MAX_BITS)
+#define CONV_HEAD AUDIO_BLOCK_SIZE          // 直接型头部的长度
+#define CONV_NEAR_INTERNAL_MAX (96 * 1024)  // 音频线程分区放在内部 RAM 的上限 (字节), 超出 (如 Tail = 0 的长脉冲响应) 放 PSRAM
+
+// 浮点实数 FFT: n 点实数作为 n/2 点复数原地变换, 再拆分出 n/2 + 1 个频点
+// 定点 FixedFft 每级右移, 对 1 秒长的脉冲响应精度不够, 卷积用浮点
+class RealFft {
+public:
+    static void initTables() {
+        if (tablesReady) return;
+        for (int i = 0; i <= CONV_FFT_MAX / 2; i++) {
+            cosTable[i] = cosf(2.0f * (float)M_PI * i / CONV_FFT_MAX);
+            sinTable[i] = sinf(2.0f * (float)M_PI * i / CONV_FFT_MAX);
+        }
+        tablesReady = true;
+    }
+
+    // x: 2^bits 个实数, 作为工作区被改写; re / im 各 2^(bits-1) + 1 点, 不归一
+    static void forward(float* x, float* re, float* im, int bits) {
+        int m = 1 << (bits - 1);
+        complexFft(x, m, false);
+        int step = CONV_FFT_MAX >> bits;
+        re[0] = x[0] + x[1];
+        im[0] = 0;
+        re[m] = x[0] - x[1];
+        im[m] = 0;
+        for (int k = 1; k < m; k++) {
+            float zr = x[2 * k], zi = x[2 * k + 1];
+            float cr = x[2 * (m - k)], ci = -x[2 * (m - k) + 1];
+            // 偶数点谱 E = (Z[k] + Z*[m-k]) / 2, 奇数点谱 O = (Z[k] - Z*[m-k]) / 2j
+            float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+            float orr = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+            float c = cosTable[k * step], s = sinTable[k * step];
+            re[k] = er + c * orr + s * oi;
+            im[k] = ei + c * oi - s * orr;
+        }
+    }
+
+    // forward() 的逆变换, 结果为 m 倍 (m = 2^(bits-1))
+    static void inverse(const float* re, const float* im, float* x, int bits) {
+        int m = 1 << (bits - 1);
+        int step = CONV_FFT_MAX >> bits;
+        for (int k = 0; k < m; k++) {
+            float xr = re[k], xi = im[k];
+            float cr = re[m - k], ci = -im[m - k];
+            float er = 0.5f * (xr + cr), ei = 0.5f * (xi + ci);
+            float dr = 0.5f * (xr - cr), di = 0.5f * (xi - ci);
+            float c = cosTable[k * step], s = sinTable[k * step];
+            float orr = dr * c - di * s, oi = dr * s + di * c;
+            x[2 * k] = er - oi;
+            x[2 * k + 1] = ei + orr;
+        }
+        complexFft(x, m, true);
+    }
+
+private:
+    static float cosTable[CONV_FFT_MAX / 2 + 1];
+    static float sinTable[CONV_FFT_MAX / 2 + 1];
+    static bool tablesReady;
+
+    // 交错存放的 n 点复数基 2 FFT, 同一旋转因子的蝶形放在内层
+    static void complexFft(float* x, int n, bool inverse) {
+        for (int i = 1, j = 0; i < n; i++) {
+            int bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                float t = x[2 * i]; x[2 * i] = x[2 * j]; x[2 * j] = t;
+                t = x[2 * i + 1]; x[2 * i + 1] = x[2 * j + 1]; x[2 * j + 1] = t;
+            }
+        }
+        for (int size = 2; size <= n; size <<= 1) {
+            int half = size >> 1;
+            int step = CONV_FFT_MAX / size;
+            for (int k = 0; k < half; k++) {
+                float c = cosTable[k * step];
+                float s = inverse ? sinTable[k * step] : -sinTable[k * step];
+                for (int i = k; i < n; i += size) {
+                    float* a = x + 2 * i;
+                    float* b = a + 2 * half;
+                    float tr = b[0] * c - b[1] * s;
+                    float ti = b[0] * s + b[1] * c;
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+};
+
+float RealFft::cosTable[CONV_FFT_MAX / 2 + 1];
+float RealFft::sinTable[CONV_FFT_MAX / 2 + 1];
+bool RealFft::tablesReady = false;
+
+// 一组等长分区的 overlap-save 卷积 (频域延迟线)
+// 每次输入 size 个采样, 输出累加到 out; delay 个分区的固定延迟用于把本组放在脉冲响应的后段
+class ConvPartitions {
+public:
+    int size = 0;       // 分区长度 P, FFT 长度 2P
+    int count = 0;      // 分区数
+
+    // 分区频谱, 延迟线与工作区的总字节数
+    static size_t bytesFor(int taps, int partitionSize, int partitionDelay) {
+        size_t n = (taps + partitionSize - 1) / partitionSize;
+        size_t b = partitionSize + 1;
+        return (n * 2 * b + (n + partitionDelay) * 2 * b + 4 * partitionSize + 2 * b) * sizeof(float);
+    }
+
+    // h 为本组负责的一段脉冲响应
+    bool init(const float* h, int taps, int partitionSize, int partitionDelay, bool inPsram) {
+        size = partitionSize;
+        bits = 31 - __builtin_clz(2 * size);
+        bins = size + 1;
+        count = (taps + size - 1) / size;
+        delay = partitionDelay;
+        slots = count + delay;
+        psram = inPsram;
+        size_t bytes = bytesFor(taps, size, delay);
+        mem = (float*)(psram ? psram_malloc(bytes) : malloc(bytes));
+        if (!mem) return false;
+        memset(mem, 0, bytes);
+        spectra = mem;
+        fdl = spectra + (size_t)count * 2 * bins;
+        history = fdl + (size_t)slots * 2 * bins;
+        work = history + 2 * size;
+        accRe = work + 2 * size;
+        accIm = accRe + bins;
+        // 逆变换的 m 倍增益预先折算进分区频谱
+        float scale = 1.0f / size;
+        for (int j = 0; j < count; j++) {
+            int n = taps - j * size < size ? taps - j * size : size;
+            memset(work, 0, 2 * size * sizeof(float));
+            for (int i = 0; i < n; i++) {
+                work[i] = h[j * size + i] * scale;
+            }
+            float* H = spectra + (size_t)j * 2 * bins;
+            RealFft::forward(work, H, H + bins, bits);
+        }
+        return true;
+    }
+
+    ~ConvPartitions() {
+        if (psram) {
+            psram_free(mem);
+        } else {
+            free(mem);
+        }
+    }
+
+    bool valid() const {
+        return mem != nullptr;
+    }
+
+    void process(const float* in, float* out) {
+        memmove(history, history + size, size * sizeof(float));
+        memcpy(history + size, in, size * sizeof(float));
+        memcpy(work, history, 2 * size * sizeof(float));
+        float* X = fdl + (size_t)pos * 2 * bins;
+        RealFft::forward(work, X, X + bins, bits);
+
+        memset(accRe, 0, 2 * bins * sizeof(float));
+        for (int j = 0; j < count; j++) {
+            int s = pos - delay - j;
+            if (s < 0) s += slots;
+            const float* xr = fdl + (size_t)s * 2 * bins;
+            const float* xi = xr + bins;
+            const float* hr = spectra + (size_t)j * 2 * bins;
+            const float* hi = hr + bins;
+            for (int k = 0; k < bins; k++) {
+                accRe[k] += xr[k] * hr[k] - xi[k] * hi[k];
+                accIm[k] += xr[k] * hi[k] + xi[k] * hr[k];
+            }
+        }
+        RealFft::inverse(accRe, accIm, work, bits);
+        for (int i = 0; i < size; i++) {
+            out[i] += work[size + i];
+        }
+        pos = pos + 1 == slots ? 0 : pos + 1;
+    }
+
+private:
+    int bits = 0;
+    int bins = 0;
+    int delay = 0;
+    int slots = 0;
+    int pos = 0;
+    bool psram = false;
+    float* mem = nullptr;
+    float* spectra = nullptr;   // count 个分区, 每个为 re[bins] 后接 im[bins]
+    float* fdl = nullptr;       // 输入频谱环形队列, slots 个
+    float* history = nullptr;   // 最近 2P 个输入
+    float* work = nullptr;
+    float* accRe = nullptr;
+    float* accIm = nullptr;
+};
+
+class ConvKernel;
+
+// 尾部线程的任务: 卷积核与段号
+struct ConvTailJob {
+    ConvKernel* kernel;
+    uint32_t segment;
+};
+
+// 一条脉冲响应的卷积核与运行状态, 加载时整体创建, 音频线程在块边界切换
+// 非均匀分区: [0, B) 直接型, [B, 2T) 为 B 长分区 (音频线程), [2T, end) 为 T 长分区 (尾部线程)
+// 尾部第 c 段输入在 (c+1)T 时刻交出, 其结果从 (c+2)T 开始使用, 尾部线程有 T 个采样的时间完成
+// T = 0 时全部使用 B 长分区
+class ConvKernel {
+public:
+    int taps = 0;
+    int tailSize = 0;
+    ConvPartitions near;
+    ConvPartitions tail;
+
+    // 统计
+    uint32_t tailJobs = 0;
+    uint64_t tailTicks = 0;
+    uint32_t tailPeak = 0;
+    uint32_t late = 0;          // 尾部结果未按时完成的段数
+    std::atomic<int> pendingJobs{0};
+
+#ifdef ESP_PLATFORM
+    QueueHandle_t tailQueue = nullptr;
+#endif
+
+    // ir 为 Q15 采样, 按能量归一 (白噪声输入时湿声与输入同 RMS)
+    bool build(const int16_t* ir, int frames, int tailPartition) {
+        RealFft::initTables();
+        taps = frames;
+        tailSize = tailPartition;
+        if (tailSize && 2 * tailSize >= taps) tailSize = 0;
+        float* h = (float*)psram_malloc((taps + CONV_HEAD) * sizeof(float));
+        if (!h) return false;
+        double energy = 0;
+        for (int i = 0; i < taps; i++) {
+            energy += (double)ir[i] * ir[i];
+        }
+        float scale = energy > 0 ? (float)(1.0 / sqrt(energy)) : 0.0f;
+        for (int i = 0; i < taps; i++) {
+            h[i] = ir[i] * scale;
+        }
+        memset(h + taps, 0, CONV_HEAD * sizeof(float));
+
+        for (int j = 0; j < CONV_HEAD; j++) {
+            headRev[j] = h[CONV_HEAD - 1 - j];
+        }
+        int nearEnd = tailSize ? 2 * tailSize : taps;
+        bool ok = true;
+        if (nearEnd > CONV_HEAD) {
+            bool nearPsram = ConvPartitions::bytesFor(nearEnd - CONV_HEAD, AUDIO_BLOCK_SIZE, 1) > CONV_NEAR_INTERNAL_MAX;
+            ok = near.init(h + CONV_HEAD, nearEnd - CONV_HEAD, AUDIO_BLOCK_SIZE, 1, nearPsram);
+        }
+        if (ok && tailSize) {
+            ok = tail.init(h + nearEnd, taps - nearEnd, tailSize, 0, true);
+            tailMem = (float*)psram_malloc(4 * tailSize * sizeof(float));
+            ok = ok && tailMem;
+            if (ok) {
+                memset(tailMem, 0, 4 * tailSize * sizeof(float));
+                tailIn[0] = tailMem;
+                tailIn[1] = tailMem + tailSize;
+                tailOut[0] = tailMem + 2 * tailSize;
+                tailOut[1] = tailMem + 3 * tailSize;
+            }
+        }
+        psram_free(h);
+        return ok;
+    }
+
+    ~ConvKernel() {
+        psram_free(tailMem);
+    }
+
+    // 音频线程: x 为一块输入, y 为湿声
+    void processBlock(const float* x, float* y) {
+        memcpy(headHist + CONV_HEAD, x, CONV_HEAD * sizeof(float));
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            const float* hist = headHist + i + 1;
+            float acc = 0;
+            for (int j = 0; j < CONV_HEAD; j++) {
+                acc += headRev[j] * hist[j];
+            }
+            y[i] = acc;
+        }
+        memcpy(headHist, headHist + CONV_HEAD, CONV_HEAD * sizeof(float));
+        if (near.count) near.process(x, y);
+        if (tailSize) processTail(x, y);
+    }
+
+    // 尾部线程: 计算第 s 段; 完成后在该段的缓冲位置记下 s + 1
+    void runTail(uint32_t s) {
+        uint32_t t0 = perf_ticks();
+        float* out = tailOut[s & 1];
+        memset(out, 0, tailSize * sizeof(float));
+        tail.process(tailIn[s & 1], out);
+        done[s & 1].store(s + 1, std::memory_order_release);
+        uint32_t t = perf_ticks() - t0;
+        tailJobs++;
+        tailTicks += t;
+        if (t > tailPeak) tailPeak = t;
+        pendingJobs.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    float headRev[CONV_HEAD];           // 头部系数倒序
+    float headHist[2 * CONV_HEAD] = {};
+    float* tailMem = nullptr;
+    float* tailIn[2] = {};
+    float* tailOut[2] = {};
+    int fill = 0;                       // 当前段已收集的采样
+    uint32_t posted = 0;
+    std::atomic<uint32_t> done[2] = {{0}, {0}};  // 每个缓冲位置最近完成的段号 + 1
+    bool tailValid = false;
+
+    void processTail(const float* x, float* y) {
+        uint32_t c = posted;
+        if (fill == 0) {
+            // 新的一段开始: 需要第 c - 2 段的结果, 同时它的输入缓冲将被本段覆盖
+            // 按段号检查, 某一段的任务没有交出时只影响这一段
+            tailValid = c >= 2 && done[c & 1].load(std::memory_order_acquire) == c - 1;
+            if (c >= 2 && !tailValid) late++;
+        }
+        if (tailValid) {
+            const float* r = tailOut[c & 1] + fill;
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                y[i] += r[i];
+            }
+        }
+        memcpy(tailIn[c & 1] + fill, x, AUDIO_BLOCK_SIZE * sizeof(float));
+        fill += AUDIO_BLOCK_SIZE;
+        if (fill < tailSize) return;
+        fill = 0;
+        posted = c + 1;
+        pendingJobs.fetch_add(1, std::memory_order_acq_rel);
+#ifdef ESP_PLATFORM
+        // 队列满说明尾部线程已经落后, 这一段放弃 (两段之后记为 late), 之后的段不受影响
+        ConvTailJob job = {this, c};
+        if (xQueueSend(tailQueue, &job, 0) != pdTRUE) {
+            pendingJobs.fetch_sub(1, std::memory_order_release);
+        }
+#else
+        // 主机上离线渲染, 就地计算以保证结果确定
+        runTail(c);
+#endif
+    }
+};
+
+// 脉冲响应内置示例: 指数衰减的噪声, 约 0.8 秒 RT60
+inline int16_t* makeBuiltinIr(int frames) {
+    int16_t* ir = (int16_t*)psram_malloc(frames * sizeof(int16_t));
+    uint32_t seed = 0x1234567;
+    float k = -6.9f / (0.8f * SMP_RATE);
+    for (int i = 0; i < frames; i++) {
+        seed = seed * 1664525 + 1013904223;
+        ir[i] = (int16_t)((int16_t)(seed >> 16) * expf(k * i));
+    }
+    ir[0] = 32767;
+    return ir;
+}
+
+// 卷积模块: 箱体 / 房间脉冲响应, 最长 CONV_MAX_MS
+// 脉冲响应从 flash 分区或文件读入 PSRAM 后建立分区频谱, 尾部分区频谱与延迟线也在 PSRAM
+// Tail 为尾部分区长度 (0 / 512 / 1024 / 2048), 下一次加载时生效
+class ConvolverModule: public Module_t {
+public:
+    ConvolverModule() { module_info = {"convolver", "libchara-dev", "Partitioned convolution for cabinet and room IRs", false, false}; }
+
+    DSP_ALIGN int16_t in[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int mix = 32767;    // Q15
+    int level = 4096;   // Q12
+    int tailPartition = 1024;
+
+    void start() {
+        RealFft::initTables();
+#ifdef ESP_PLATFORM
+        tailQueue = xQueueCreate(4, sizeof(ConvTailJob));
+        // 音频引擎在核 0, 尾部放在核 1 以低优先级计算, 不与音频线程争同一个核
+        xTaskCreatePinnedToCore(tailTask, "Conv tail", 4096, this, 1, &tailWorker, 1);
+#endif
+        registerPort(in, PORT_AIN, "IN", "signal input");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
+        registerParam(&mix, PARAM_INT, "Mix", "wet level, Q15");
+        registerParam(&level, PARAM_INT, "Level", "wet gain, Q12 (4096 = 1.0)");
+        registerParam(&tailPartition, PARAM_INT, "Tail", "tail partition 0 / 512 / 1024 / 2048, applied on load");
+        printf("Convolver Start\n");
+    }
+    void stop() {
+        releaseKernel(pending.exchange(nullptr));
+        releaseKernel(retired.exchange(nullptr));
+        releaseKernel(kernel);
+        kernel = nullptr;
+#ifdef ESP_PLATFORM
+        vTaskDelete(tailWorker);
+        vQueueDelete(tailQueue);
+#endif
+        printf("Convolver Stop\n");
+    }
+
+    // 任意非音频线程调用: "builtin" 为内置示例, 其余同 loadSample
+    bool loadIr(const char* spec) {
+        int maxFrames = (int)((uint64_t)CONV_MAX_MS * sampleRate / 1000);
+        int16_t* ir = nullptr;
+        int frames = 0;
+        if (strcmp(spec, "builtin") == 0) {
+            frames = maxFrames;
+            ir = makeBuiltinIr(frames);
+        } else {
+            SampleSource* source = createSampleSource(spec);
+            if (source->open()) {
+                frames = source->frames() < (size_t)maxFrames ? (int)source->frames() : maxFrames;
+                ir = (int16_t*)psram_malloc(frames * sizeof(int16_t) + 1);
+                frames = ir ? (int)source->read(0, ir, frames) : 0;
+            }
+            delete source;
+        }
+        if (!ir || frames == 0) {
+            psram_free(ir);
+            return false;
+        }
+        int t = tailPartition;
+        t = t >= 2048 ? 2048 : (t >= 1024 ? 1024 : (t >= 512 ? 512 : 0));
+        ConvKernel* k = new ConvKernel();
+#ifdef ESP_PLATFORM
+        k->tailQueue = tailQueue;
+#endif
+        bool ok = k->build(ir, frames, t);
+        psram_free(ir);
+        if (!ok) {
+            printf("Convolver: allocation failed\n");
+            delete k;
+            return false;
+        }
+        printf("Convolver: %s loaded, %d taps, %d x %d + %d x %d partitions\n", spec, frames, k->near.count,
+               AUDIO_BLOCK_SIZE, k->tail.count, k->tailSize);
+        releaseKernel(pending.exchange(k, std::memory_order_acq_rel));
+        releaseKernel(retired.exchange(nullptr, std::memory_order_acq_rel));
+        return true;
+    }
+
+    void process() {
+        if (!retired.load(std::memory_order_acquire)) {
+            ConvKernel* loaded = pending.exchange(nullptr, std::memory_order_acquire);
+            if (loaded) {
+                retired.store(kernel, std::memory_order_release);
+                kernel = loaded;
+            }
+        }
+        if (!kernel) {
+            memcpy(out, in, sizeof(out));
+            return;
+        }
+        Dsp::toFloat(in, dry, AUDIO_BLOCK_SIZE);
+        kernel->processBlock(dry, wet);
+        float w = mix * (1.0f / 32768) * level * (1.0f / 4096);
+        float d = 1.0f - mix * (1.0f / 32768);
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            wet[i] = wet[i] * w + dry[i] * d;
+        }
+        Dsp::fromFloat(wet, out, AUDIO_BLOCK_SIZE);
+    }
+
+    void printProfileDetail() {
+        if (!kernel) return;
+        printf("    conv: %d taps, tail %d x %d, tail avg %.1fus peak %.1fus, %lu late\n", kernel->taps,
+               kernel->tail.count, kernel->tailSize,
+               kernel->tailJobs ? (float)kernel->tailTicks / kernel->tailJobs / PERF_TICKS_PER_US : 0.0f,
+               (float)kernel->tailPeak / PERF_TICKS_PER_US, (unsigned long)kernel->late);
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    ConvKernel* kernel = nullptr;
+    std::atomic<ConvKernel*> pending{nullptr};
+    std::atomic<ConvKernel*> retired{nullptr};
+    DSP_ALIGN float dry[AUDIO_BLOCK_SIZE];
+    DSP_ALIGN float wet[AUDIO_BLOCK_SIZE];
+
+    // 等尾部线程处理完该核已交出的段再释放
+    static void releaseKernel(ConvKernel* k) {
+        if (!k) return;
+#ifdef ESP_PLATFORM
+        while (k->pendingJobs.load(std::memory_order_acquire) > 0) {
+            vTaskDelay(1);
+        }
+#endif
+        delete k;
+    }
+
+#ifdef ESP_PLATFORM
+    QueueHandle_t tailQueue = nullptr;
+    TaskHandle_t tailWorker = nullptr;
+
+    static void tailTask(void* arg) {
+        ConvolverModule* self = (ConvolverModule*)arg;
+        for (;;) {
+            ConvTailJob job;
+            if (xQueueReceive(self->tailQueue, &job, portMAX_DELAY) == pdTRUE) {
+                job.kernel->runTail(job.segment);
+            }
+        }
+    }
+#endif
+};
+
+// 1 秒脉冲响应下各分区方案的耗时, 分别计入音频线程与尾部线程
+inline void benchConvolver(uint32_t blocks) {
+    RealFft::initTables();
+    int frames = SMP_RATE * CONV_MAX_MS / 1000;
+    int16_t* ir = makeBuiltinIr(frames);
+    struct Scheme {
+        const char* name;
+        int tail;
+    } schemes[] = {
+        {"conv uniform 64", 0},
+        {"conv 64 + tail 512", 512},
+        {"conv 64 + tail 1024", 1024},
+        {"conv 64 + tail 2048", 2048},
+    };
+    DSP_ALIGN float x[AUDIO_BLOCK_SIZE];
+    DSP_ALIGN float y[AUDIO_BLOCK_SIZE];
+    uint32_t seed = 1;
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        seed = seed * 1664525 + 1013904223;
+        x[i] = (int16_t)(seed >> 16) * (1.0f / 32768);
+    }
+    for (const Scheme& s : schemes) {
+        ConvKernel* k = new ConvKernel();
+        if (!k->build(ir, frames, s.tail)) {
+            printf("%-24s allocation failed\n", s.name);
+            delete k;
+            continue;
+        }
+        bench_result_t r = benchRun(s.name, blocks, AUDIO_BLOCK_SIZE, [&]() {
+            k->processBlock(x, y);
+        });
+        double samples = (double)(blocks + 1) * AUDIO_BLOCK_SIZE;
+        double tailNs = k->tailTicks * 1000.0 / PERF_TICKS_PER_US / samples;
+        double totalNs = r.totalUs * 1000.0 / ((double)blocks * AUDIO_BLOCK_SIZE);
+        printf("%-24s %8.1f ns/smp audio %8.1f ns/smp tail, %d x %d + %d x %d, tail peak %.0fus of %.0fus\n", s.name,
+               totalNs - tailNs, tailNs, k->near.count, AUDIO_BLOCK_SIZE, k->tail.count, k->tailSize,
+               (float)k->tailPeak / PERF_TICKS_PER_US, k->tailSize * 1e6f / SMP_RATE);
+        delete k;
+    }
+    psram_free(ir);
+}
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef DELAY_H
+#define DELAY_H
+
+#include <stdint.h>
+#include "module_manager.hpp"
+#include "delay_line.h"
+#include "resampler.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define DELAY_MAX_MS 4000
+#define DELAY_SCRATCH 1024  // 每块从 PSRAM 取回的最大窗口 (内部 SRAM)
+#define DELAY_MIN_SAMPLES (AUDIO_BLOCK_SIZE + 2) // 反馈按块计算, 延迟至少一块
+
+// 立体声延迟 / 回声: 延迟线在 PSRAM, 每块只做一次连续写入与一次窗口读取
+// 延迟时间可由 TIME 端口逐采样调制, Hermite 插值读取
+class StereoDelay: public Module_t {
+public:
+    static const int TIME_FRAC_BITS = 3; // TIME 端口 1 LSB = 1/8 采样
+
+    StereoDelay() { module_info = {"stereo delay", "libchara-dev", "PSRAM stereo delay with modulated time and ping-pong", false, false}; }
+
+    int16_t inL[AUDIO_BLOCK_SIZE] = {};
+    int16_t inR[AUDIO_BLOCK_SIZE] = {};
+    int16_t timeMod[AUDIO_BLOCK_SIZE] = {};
+    int16_t outL[AUDIO_BLOCK_SIZE] = {};
+    int16_t outR[AUDIO_BLOCK_SIZE] = {};
+    int timeMs = 350;
+    int feedback = 16384;   // Q15
+    int damping = 8192;     // Q15, 反馈路径低通
+    int mix = 12000;        // Q15, 湿声比例
+    int pingPong = 0;
+
+    void start() {
+        FracResampler::initTables();
+        uint32_t samples = (uint32_t)((uint64_t)DELAY_MAX_MS * sampleRate / 1000) + DELAY_SCRATCH;
+        lineL = new PsramDelayLine(samples);
+        lineR = new PsramDelayLine(samples);
+        if (!lineL->valid() || !lineR->valid()) {
+            printf("StereoDelay: PSRAM allocation failed\n");
+        }
+        registerPort(inL, PORT_AIN, "IN L", "left input");
+        registerPort(inR, PORT_AIN, "IN R", "right input");
+        registerPort(timeMod, PORT_AIN, "TIME", "delay modulation, 1/8 sample");
+        registerPort(outL, PORT_AOUT, "OUT L", "left output");
+        registerPort(outR, PORT_AOUT, "OUT R", "right output");
+        registerParam(&timeMs, PARAM_INT, "Time", "delay time (ms)");
+        registerParam(&feedback, PARAM_INT, "Feedback", "Q15");
+        registerParam(&damping, PARAM_INT, "Damping", "feedback lowpass, Q15");
+        registerParam(&mix, PARAM_INT, "Mix", "wet level, Q15");
+        registerParam(&pingPong, PARAM_INT, "Ping-pong", "0:off 1:cross feedback");
+        smoothed = targetDelay();
+        printf("StereoDelay Start\n");
+    }
+    void stop() {
+        delete lineL;
+        delete lineR;
+        lineL = lineR = nullptr;
+        printf("StereoDelay Stop\n");
+    }
+    void process() {
+        if (!lineL->valid() || !lineR->valid()) {
+            memcpy(outL, inL, sizeof(outL));
+            memcpy(outR, inR, sizeof(outR));
+            return;
+        }
+        // 基础延迟按块平滑 (Q16 采样), 块内线性过渡, 再叠加 TIME 端口调制
+        int64_t from = smoothed;
+        int64_t to = from + (targetDelay() - from) / 8;
+        smoothed = to;
+        int64_t step = (to - from) / AUDIO_BLOCK_SIZE;
+        int64_t maxDelay = (int64_t)(lineL->getSize() - DELAY_SCRATCH) << 16;
+        int64_t lo = INT64_MAX, hi = 0;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int64_t d = from + step * i + ((int64_t)timeMod[i] << (16 - TIME_FRAC_BITS));
+            d = d < ((int64_t)DELAY_MIN_SAMPLES << 16) ? ((int64_t)DELAY_MIN_SAMPLES << 16) : (d > maxDelay ? maxDelay : d);
+            delay[i] = d;
+            // 读位置 = 写位置 + i - d, 按块内最小/最大读位置确定取回窗口
+            int64_t r = ((int64_t)i << 16) - d;
+            if (r < lo) lo = r;
+            if (r > hi) hi = r;
+        }
+        // 调制过快时压缩到窗口内
+        int64_t span = (int64_t)(DELAY_SCRATCH - 4) << 16;
+        if (hi - lo > span) {
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                int64_t r = ((int64_t)i << 16) - delay[i];
+                if (r > lo + span) delay[i] = ((int64_t)i << 16) - (lo + span);
+            }
+            hi = lo + span;
+        }
+        int32_t base = (int32_t)(lo >> 16) - 1; // 相对写位置, Hermite 需要前 1 后 2 个采样
+        uint32_t count = (uint32_t)((hi >> 16) - (lo >> 16)) + 4;
+        uint32_t w = lineL->position();
+        lineL->fetch(w + base, scratchL, count);
+        lineR->fetch(w + base, scratchR, count);
+
+        int16_t yL[AUDIO_BLOCK_SIZE], yR[AUDIO_BLOCK_SIZE];
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int64_t r = ((int64_t)i << 16) - delay[i];
+            int32_t idx = (int32_t)(r >> 16) - base;
+            uint32_t frac = (uint32_t)(r & 0xFFFF) << 16;
+            yL[i] = FracResampler::hermite(scratchL + idx, frac);
+            yR[i] = FracResampler::hermite(scratchR + idx, frac);
+        }
+
+        int32_t fb = clampQ15(feedback), damp = 32767 - clampQ15(damping), wet = clampQ15(mix), dry = 32767 - wet;
+        int16_t wL[AUDIO_BLOCK_SIZE], wR[AUDIO_BLOCK_SIZE];
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int32_t fl = pingPong ? yR[i] : yL[i];
+            int32_t fr = pingPong ? yL[i] : yR[i];
+            lpL += ((fl - lpL) * damp) >> 15;
+            lpR += ((fr - lpR) * damp) >> 15;
+            wL[i] = FracResampler::saturate(inL[i] + ((lpL * fb) >> 15));
+            wR[i] = FracResampler::saturate(inR[i] + ((lpR * fb) >> 15));
+            outL[i] = FracResampler::saturate((inL[i] * dry + yL[i] * wet) >> 15);
+            outR[i] = FracResampler::saturate((inR[i] * dry + yR[i] * wet) >> 15);
+        }
+        lineL->write(wL, AUDIO_BLOCK_SIZE);
+        lineR->write(wR, AUDIO_BLOCK_SIZE);
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    PsramDelayLine* lineL = nullptr;
+    PsramDelayLine* lineR = nullptr;
+    int16_t scratchL[DELAY_SCRATCH];
+    int16_t scratchR[DELAY_SCRATCH];
+    int64_t delay[AUDIO_BLOCK_SIZE];
+    int64_t smoothed = 0;
+    int32_t lpL = 0, lpR = 0;
+
+    static int32_t clampQ15(int v) {
+        return v < 0 ? 0 : (v > 32767 ? 32767 : v);
+    }
+
+    int64_t targetDelay() {
+        int ms = timeMs < 0 ? 0 : (timeMs > DELAY_MAX_MS ? DELAY_MAX_MS : timeMs);
+        return ((int64_t)ms * sampleRate << 16) / 1000;
+    }
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef DELAY_LINE_H
+#define DELAY_LINE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "platform_compat.h"
+
+// PSRAM 中的长延迟线, 长度为 2 的幂, 以绝对采样序号 (uint32 回绕) 寻址
+// PSRAM 经 cache 访问, 随机单样本读写代价高, 因此只提供按块的连续拷贝:
+// write() 追加一整块, fetch() 把一段连续历史拷进调用方的内部 SRAM 缓冲后再插值
+class PsramDelayLine {
+public:
+    PsramDelayLine(uint32_t minSamples) {
+        size = 1;
+        while (size < minSamples) size <<= 1;
+        mask = size - 1;
+        buffer = (int16_t*)psram_malloc(size * sizeof(int16_t));
+        clear();
+    }
+
+    ~PsramDelayLine() {
+        psram_free(buffer);
+    }
+
+    PsramDelayLine(const PsramDelayLine&) = delete;
+    PsramDelayLine& operator=(const PsramDelayLine&) = delete;
+
+    bool valid() const {
+        return buffer != nullptr;
+    }
+
+    uint32_t getSize() const {
+        return size;
+    }
+
+    // 下一个写入位置 (绝对序号)
+    uint32_t position() const {
+        return writeIndex;
+    }
+
+    void clear() {
+        if (buffer) memset(buffer, 0, size * sizeof(int16_t));
+        writeIndex = 0;
+    }
+
+    void write(const int16_t* data, uint32_t n) {
+        uint32_t w = writeIndex & mask;
+        uint32_t first = size - w < n ? size - w : n;
+        memcpy(buffer + w, data, first * sizeof(int16_t));
+        memcpy(buffer, data + first, (n - first) * sizeof(int16_t));
+        writeIndex += n;
+    }
+
+    // 拷贝从绝对序号 start 开始的 n 个采样, 调用方保证该段仍在缓冲内
+    void fetch(uint32_t start, int16_t* dst, uint32_t n) const {
+        uint32_t r = start & mask;
+        uint32_t first = size - r < n ? size - r : n;
+        memcpy(dst, buffer + r, first * sizeof(int16_t));
+        memcpy(dst + first, buffer, (n - first) * sizeof(int16_t));
+    }
+
+private:
+    int16_t* buffer;
+    uint32_t size;
+    uint32_t mask;
+    uint32_t writeIndex = 0;
+};
+
+#endif
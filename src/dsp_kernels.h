@@ -0,0 +1,668 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "bench.h"
+#include "src_config.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// 定点块运算内核 (Q15 采样, Q31 累加)
+// 每个内核有可移植实现与平台 SIMD 实现, 编译期选择, 二者结果逐位一致 (test/test_dsp_kernels 检查):
+//   ESP32-S3: PIE 指令, 见 dsp_kernels_pie.S (需 16 字节对齐, 否则退回可移植实现)
+//   x86: SSE2, ARM: NEON
+// 约定: 乘法结果向下取整 ((x * g) >> 15), 增益范围 [-32767, 32767]
+#if defined(ESP_PLATFORM) && defined(CONFIG_IDF_TARGET_ESP32S3)
+#define DSP_IMPL_PIE
+#define DSP_IMPL_NAME "esp32s3 pie"
+#elif !defined(ESP_PLATFORM) && defined(__SSE2__)
+#include <emmintrin.h>
+#define DSP_IMPL_SSE
+#define DSP_IMPL_NAME "sse2"
+#elif !defined(ESP_PLATFORM) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DSP_IMPL_NEON
+#define DSP_IMPL_NAME "neon"
+#else
+#define DSP_IMPL_NAME "portable"
+#endif
+
+// 模块的块缓冲按此对齐后, S3 上可走 PIE 路径
+#define DSP_ALIGN alignas(16)
+
+class DspPortable {
+public:
+    static inline int16_t sat16(int32_t v) {
+        return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+
+    static inline int16_t clampGain(int32_t g) {
+        return g > 32767 ? 32767 : (g < -32767 ? -32767 : g);
+    }
+
+    // out = in * gain
+    static void gain(const int16_t* in, int16_t g, int16_t* out, int n) {
+        g = clampGain(g);
+        for (int i = 0; i < n; i++) {
+            out[i] = (in[i] * g) >> 15;
+        }
+    }
+
+    // out = a + b (饱和)
+    static void add(const int16_t* a, const int16_t* b, int16_t* out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = sat16(a[i] + b[i]);
+        }
+    }
+
+    // out = a * ga + b * gb (饱和)
+    static void mix(const int16_t* a, int16_t ga, const int16_t* b, int16_t gb, int16_t* out, int n) {
+        ga = clampGain(ga);
+        gb = clampGain(gb);
+        for (int i = 0; i < n; i++) {
+            out[i] = sat16(((a[i] * ga) >> 15) + ((b[i] * gb) >> 15));
+        }
+    }
+
+    // acc += in * gain, 16 位饱和累加
+    static void mac(const int16_t* in, int16_t g, int16_t* acc, int n) {
+        g = clampGain(g);
+        for (int i = 0; i < n; i++) {
+            acc[i] = sat16(acc[i] + ((in[i] * g) >> 15));
+        }
+    }
+
+    static inline int32_t sat32(int64_t v) {
+        return v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : v);
+    }
+
+    // acc += in * gain, 32 位饱和累加 (Q30), 用 saturate() 收尾
+    static void mac32(const int16_t* in, int16_t g, int32_t* acc, int n) {
+        for (int i = 0; i < n; i++) {
+            acc[i] = sat32((int64_t)acc[i] + in[i] * g);
+        }
+    }
+
+    // out = in >> shift (饱和到 16 位)
+    static void saturate(const int32_t* in, int shift, int16_t* out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = sat16(in[i] >> shift);
+        }
+    }
+
+    static void clip(const int16_t* in, int16_t lo, int16_t hi, int16_t* out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = in[i] < lo ? lo : (in[i] > hi ? hi : in[i]);
+        }
+    }
+
+    // out = a * (1 - m) + b * m, m 为 Q15 [0, 32767]
+    static void crossfade(const int16_t* a, const int16_t* b, int16_t m, int16_t* out, int n) {
+        m = m < 0 ? 0 : m;
+        int16_t im = 32767 - m;
+        for (int i = 0; i < n; i++) {
+            out[i] = sat16(((a[i] * im) >> 15) + ((b[i] * m) >> 15));
+        }
+    }
+
+    // 点积, 返回完整精度的 Q30 和
+    static int64_t dot(const int16_t* a, const int16_t* b, int n) {
+        int64_t acc = 0;
+        for (int i = 0; i < n; i++) {
+            acc += a[i] * b[i];
+        }
+        return acc;
+    }
+
+    // 峰值 (最大绝对值), -32768 的峰值为 32768
+    static int32_t peak(const int16_t* in, int n) {
+        int32_t hi = 0, lo = 0;
+        for (int i = 0; i < n; i++) {
+            hi = in[i] > hi ? in[i] : hi;
+            lo = in[i] < lo ? in[i] : lo;
+        }
+        return hi > -lo ? hi : -lo;
+    }
+
+    static void toFloat(const int16_t* in, float* out, int n) {
+        for (int i = 0; i < n; i++) {
+            out[i] = in[i] * (1.0f / 32768);
+        }
+    }
+
+    // 就近舍入 (偶数优先), 超出范围饱和
+    static void fromFloat(const float* in, int16_t* out, int n) {
+        for (int i = 0; i < n; i++) {
+            float v = in[i] * 32768.0f;
+            v = v > 32767.0f ? 32767.0f : (v < -32768.0f ? -32768.0f : v);
+            out[i] = (int16_t)lrintf(v);
+        }
+    }
+};
+
+// SIMD peak 的收尾: lanes[0..7] 为各通道最大值, lanes[8..15] 为最小值, tail 为剩余样本的峰值
+static inline int32_t peakOfLanes(const int16_t* lanes, int32_t tail) {
+    int32_t p = tail;
+    for (int k = 0; k < 8; k++) {
+        p = lanes[k] > p ? lanes[k] : p;
+        p = -lanes[k + 8] > p ? -lanes[k + 8] : p;
+    }
+    return p;
+}
+
+#if defined(DSP_IMPL_SSE)
+class DspSimd {
+public:
+    static void gain(const int16_t* in, int16_t g, int16_t* out, int n) {
+        g = DspPortable::clampGain(g);
+        __m128i vg = _mm_set1_epi16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128((__m128i*)(out + i), mulQ15(load(in + i), vg));
+        }
+        DspPortable::gain(in + i, g, out + i, n - i);
+    }
+
+    static void add(const int16_t* a, const int16_t* b, int16_t* out, int n) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128((__m128i*)(out + i), _mm_adds_epi16(load(a + i), load(b + i)));
+        }
+        DspPortable::add(a + i, b + i, out + i, n - i);
+    }
+
+    static void mix(const int16_t* a, int16_t ga, const int16_t* b, int16_t gb, int16_t* out, int n) {
+        ga = DspPortable::clampGain(ga);
+        gb = DspPortable::clampGain(gb);
+        __m128i vga = _mm_set1_epi16(ga);
+        __m128i vgb = _mm_set1_epi16(gb);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i y = _mm_adds_epi16(mulQ15(load(a + i), vga), mulQ15(load(b + i), vgb));
+            _mm_storeu_si128((__m128i*)(out + i), y);
+        }
+        DspPortable::mix(a + i, ga, b + i, gb, out + i, n - i);
+    }
+
+    static void mac(const int16_t* in, int16_t g, int16_t* acc, int n) {
+        g = DspPortable::clampGain(g);
+        __m128i vg = _mm_set1_epi16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128((__m128i*)(acc + i), _mm_adds_epi16(load(acc + i), mulQ15(load(in + i), vg)));
+        }
+        DspPortable::mac(in + i, g, acc + i, n - i);
+    }
+
+    static void mac32(const int16_t* in, int16_t g, int32_t* acc, int n) {
+        __m128i vg = _mm_set1_epi16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i x = load(in + i);
+            __m128i lo = _mm_mullo_epi16(x, vg);
+            __m128i hi = _mm_mulhi_epi16(x, vg);
+            __m128i* p = (__m128i*)(acc + i);
+            _mm_storeu_si128(p, addSat32(_mm_loadu_si128(p), _mm_unpacklo_epi16(lo, hi)));
+            _mm_storeu_si128(p + 1, addSat32(_mm_loadu_si128(p + 1), _mm_unpackhi_epi16(lo, hi)));
+        }
+        DspPortable::mac32(in + i, g, acc + i, n - i);
+    }
+
+    static void saturate(const int32_t* in, int shift, int16_t* out, int n) {
+        __m128i s = _mm_cvtsi32_si128(shift);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i a = _mm_sra_epi32(_mm_loadu_si128((const __m128i*)(in + i)), s);
+            __m128i b = _mm_sra_epi32(_mm_loadu_si128((const __m128i*)(in + i + 4)), s);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+        }
+        DspPortable::saturate(in + i, shift, out + i, n - i);
+    }
+
+    static void clip(const int16_t* in, int16_t lo, int16_t hi, int16_t* out, int n) {
+        __m128i vlo = _mm_set1_epi16(lo);
+        __m128i vhi = _mm_set1_epi16(hi);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            _mm_storeu_si128((__m128i*)(out + i), _mm_max_epi16(_mm_min_epi16(load(in + i), vhi), vlo));
+        }
+        DspPortable::clip(in + i, lo, hi, out + i, n - i);
+    }
+
+    static void crossfade(const int16_t* a, const int16_t* b, int16_t m, int16_t* out, int n) {
+        m = m < 0 ? 0 : m;
+        __m128i vm = _mm_set1_epi16(m);
+        __m128i vim = _mm_set1_epi16(32767 - m);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i y = _mm_adds_epi16(mulQ15(load(a + i), vim), mulQ15(load(b + i), vm));
+            _mm_storeu_si128((__m128i*)(out + i), y);
+        }
+        DspPortable::crossfade(a + i, b + i, m, out + i, n - i);
+    }
+
+    static int64_t dot(const int16_t* a, const int16_t* b, int n) {
+        __m128i acc = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i x = load(a + i);
+            __m128i y = load(b + i);
+            __m128i lo = _mm_mullo_epi16(x, y);
+            __m128i hi = _mm_mulhi_epi16(x, y);
+            // 单个乘积不超过 2^30, 符号扩展到 64 位后累加
+            acc = _mm_add_epi64(acc, widen(_mm_unpacklo_epi16(lo, hi)));
+            acc = _mm_add_epi64(acc, widen(_mm_unpackhi_epi16(lo, hi)));
+        }
+        int64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, acc);
+        return lanes[0] + lanes[1] + DspPortable::dot(a + i, b + i, n - i);
+    }
+
+    static int32_t peak(const int16_t* in, int n) {
+        __m128i hi = _mm_setzero_si128();
+        __m128i lo = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i x = load(in + i);
+            hi = _mm_max_epi16(hi, x);
+            lo = _mm_min_epi16(lo, x);
+        }
+        DSP_ALIGN int16_t lanes[16];
+        _mm_store_si128((__m128i*)lanes, hi);
+        _mm_store_si128((__m128i*)(lanes + 8), lo);
+        return peakOfLanes(lanes, DspPortable::peak(in + i, n - i));
+    }
+
+    static void toFloat(const int16_t* in, float* out, int n) {
+        __m128 scale = _mm_set1_ps(1.0f / 32768);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128i x = load(in + i);
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+        DspPortable::toFloat(in + i, out + i, n - i);
+    }
+
+    static void fromFloat(const float* in, int16_t* out, int n) {
+        __m128 scale = _mm_set1_ps(32768.0f);
+        __m128 hi = _mm_set1_ps(32767.0f);
+        __m128 lo = _mm_set1_ps(-32768.0f);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), hi), lo);
+            __m128 b = _mm_max_ps(_mm_min_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), hi), lo);
+            _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b)));
+        }
+        DspPortable::fromFloat(in + i, out + i, n - i);
+    }
+
+private:
+    static inline __m128i load(const int16_t* p) {
+        return _mm_loadu_si128((const __m128i*)p);
+    }
+
+    // (x * g) >> 15 向下取整: 拼接 32 位乘积的高低半字
+    static inline __m128i mulQ15(__m128i x, __m128i g) {
+        __m128i lo = _mm_mullo_epi16(x, g);
+        __m128i hi = _mm_mulhi_epi16(x, g);
+        return _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+    }
+
+    // SSE2 没有 32 位饱和加: 两个加数同号而和变号时取对应的极值
+    static inline __m128i addSat32(__m128i a, __m128i b) {
+        __m128i sum = _mm_add_epi32(a, b);
+        __m128i overflow = _mm_srai_epi32(_mm_and_si128(_mm_xor_si128(a, sum), _mm_xor_si128(b, sum)), 31);
+        __m128i limit = _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT32_MAX));
+        return _mm_or_si128(_mm_and_si128(overflow, limit), _mm_andnot_si128(overflow, sum));
+    }
+
+    static inline __m128i widen(__m128i p) {
+        __m128i sign = _mm_srai_epi32(p, 31);
+        return _mm_add_epi64(_mm_unpacklo_epi32(p, sign), _mm_unpackhi_epi32(p, sign));
+    }
+};
+#elif defined(DSP_IMPL_NEON)
+class DspSimd {
+public:
+    // vqdmulh: (2 * x * g) >> 16, 增益不含 -32768 时与 (x * g) >> 15 一致
+    static void gain(const int16_t* in, int16_t g, int16_t* out, int n) {
+        g = DspPortable::clampGain(g);
+        int16x8_t vg = vdupq_n_s16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(out + i, vqdmulhq_s16(vld1q_s16(in + i), vg));
+        }
+        DspPortable::gain(in + i, g, out + i, n - i);
+    }
+
+    static void add(const int16_t* a, const int16_t* b, int16_t* out, int n) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(out + i, vqaddq_s16(vld1q_s16(a + i), vld1q_s16(b + i)));
+        }
+        DspPortable::add(a + i, b + i, out + i, n - i);
+    }
+
+    static void mix(const int16_t* a, int16_t ga, const int16_t* b, int16_t gb, int16_t* out, int n) {
+        ga = DspPortable::clampGain(ga);
+        gb = DspPortable::clampGain(gb);
+        int16x8_t vga = vdupq_n_s16(ga);
+        int16x8_t vgb = vdupq_n_s16(gb);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(out + i, vqaddq_s16(vqdmulhq_s16(vld1q_s16(a + i), vga), vqdmulhq_s16(vld1q_s16(b + i), vgb)));
+        }
+        DspPortable::mix(a + i, ga, b + i, gb, out + i, n - i);
+    }
+
+    static void mac(const int16_t* in, int16_t g, int16_t* acc, int n) {
+        g = DspPortable::clampGain(g);
+        int16x8_t vg = vdupq_n_s16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(acc + i, vqaddq_s16(vld1q_s16(acc + i), vqdmulhq_s16(vld1q_s16(in + i), vg)));
+        }
+        DspPortable::mac(in + i, g, acc + i, n - i);
+    }
+
+    static void mac32(const int16_t* in, int16_t g, int32_t* acc, int n) {
+        int16x4_t vg = vdup_n_s16(g);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t x = vld1q_s16(in + i);
+            vst1q_s32(acc + i, vqaddq_s32(vld1q_s32(acc + i), vmull_s16(vget_low_s16(x), vg)));
+            vst1q_s32(acc + i + 4, vqaddq_s32(vld1q_s32(acc + i + 4), vmull_s16(vget_high_s16(x), vg)));
+        }
+        DspPortable::mac32(in + i, g, acc + i, n - i);
+    }
+
+    static void saturate(const int32_t* in, int shift, int16_t* out, int n) {
+        int32x4_t s = vdupq_n_s32(-shift);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x4_t a = vqmovn_s32(vshlq_s32(vld1q_s32(in + i), s));
+            int16x4_t b = vqmovn_s32(vshlq_s32(vld1q_s32(in + i + 4), s));
+            vst1q_s16(out + i, vcombine_s16(a, b));
+        }
+        DspPortable::saturate(in + i, shift, out + i, n - i);
+    }
+
+    static void clip(const int16_t* in, int16_t lo, int16_t hi, int16_t* out, int n) {
+        int16x8_t vlo = vdupq_n_s16(lo);
+        int16x8_t vhi = vdupq_n_s16(hi);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(out + i, vmaxq_s16(vminq_s16(vld1q_s16(in + i), vhi), vlo));
+        }
+        DspPortable::clip(in + i, lo, hi, out + i, n - i);
+    }
+
+    static void crossfade(const int16_t* a, const int16_t* b, int16_t m, int16_t* out, int n) {
+        m = m < 0 ? 0 : m;
+        int16x8_t vm = vdupq_n_s16(m);
+        int16x8_t vim = vdupq_n_s16(32767 - m);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            vst1q_s16(out + i, vqaddq_s16(vqdmulhq_s16(vld1q_s16(a + i), vim), vqdmulhq_s16(vld1q_s16(b + i), vm)));
+        }
+        DspPortable::crossfade(a + i, b + i, m, out + i, n - i);
+    }
+
+    static int64_t dot(const int16_t* a, const int16_t* b, int n) {
+        int64x2_t acc = vdupq_n_s64(0);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t x = vld1q_s16(a + i);
+            int16x8_t y = vld1q_s16(b + i);
+            acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(y)));
+            acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(y)));
+        }
+        return vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1) + DspPortable::dot(a + i, b + i, n - i);
+    }
+
+    static int32_t peak(const int16_t* in, int n) {
+        int16x8_t hi = vdupq_n_s16(0);
+        int16x8_t lo = vdupq_n_s16(0);
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t x = vld1q_s16(in + i);
+            hi = vmaxq_s16(hi, x);
+            lo = vminq_s16(lo, x);
+        }
+        int16_t lanes[16];
+        vst1q_s16(lanes, hi);
+        vst1q_s16(lanes + 8, lo);
+        return peakOfLanes(lanes, DspPortable::peak(in + i, n - i));
+    }
+
+    static void toFloat(const int16_t* in, float* out, int n) {
+        int i = 0;
+        for (; i + 8 <= n; i += 8) {
+            int16x8_t x = vld1q_s16(in + i);
+            vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32768));
+            vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32768));
+        }
+        DspPortable::toFloat(in + i, out + i, n - i);
+    }
+
+    static void fromFloat(const float* in, int16_t* out, int n) {
+        int i = 0;
+#ifdef __aarch64__
+        float32x4_t hi = vdupq_n_f32(32767.0f);
+        float32x4_t lo = vdupq_n_f32(-32768.0f);
+        for (; i + 8 <= n; i += 8) {
+            float32x4_t a = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i), 32768.0f), hi), lo);
+            float32x4_t b = vmaxq_f32(vminq_f32(vmulq_n_f32(vld1q_f32(in + i + 4), 32768.0f), hi), lo);
+            vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b))));
+        }
+#endif
+        DspPortable::fromFloat(in + i, out + i, n - i);
+    }
+};
+#elif defined(DSP_IMPL_PIE)
+// 汇编实现见 dsp_kernels_pie.S, 参数中的 count 为 8 个样本一组的组数
+extern "C" {
+void dsp_pie_gain(const int16_t* in, int16_t* out, int count, const int16_t* g);
+void dsp_pie_add(const int16_t* a, const int16_t* b, int16_t* out, int count);
+void dsp_pie_mix(const int16_t* a, const int16_t* b, int16_t* out, int count, const int16_t* ga, const int16_t* gb);
+void dsp_pie_mac(const int16_t* in, int16_t* acc, int count, const int16_t* g);
+void dsp_pie_mac32(const int16_t* in, int32_t* acc, int count, const int16_t* g);
+void dsp_pie_saturate(const int32_t* in, int16_t* out, int count, int shift, const int32_t* limits);
+void dsp_pie_clip(const int16_t* in, int16_t* out, int count, const int16_t* lo, const int16_t* hi);
+int64_t dsp_pie_dot(const int16_t* a, const int16_t* b, int count);
+void dsp_pie_peak(const int16_t* in, int count, int16_t* lanes);
+void dsp_pie_to_float(const int16_t* in, float* out, int n);
+void dsp_pie_from_float(const float* in, int16_t* out, int n);
+}
+
+// 一次 dsp_pie_dot 最多处理的组数: 256 个乘积之和不超过 2^38, 40 位 ACCX 不会溢出
+#define DSP_PIE_DOT_CHUNK 32
+
+// PIE 每次处理 8 个 16 位样本, ee.vld/ee.vst 忽略地址低 4 位, 未对齐时退回可移植实现
+// 浮点转换没有向量指令, 使用带 2^15 缩放的 FLOAT.S / ROUND.S
+class DspSimd {
+public:
+    static void gain(const int16_t* in, int16_t g, int16_t* out, int n) {
+        g = DspPortable::clampGain(g);
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, out)) {
+            DspPortable::gain(in, g, out, n);
+            return;
+        }
+        dsp_pie_gain(in, out, count, &g);
+        int done = count << 3;
+        DspPortable::gain(in + done, g, out + done, n - done);
+    }
+
+    static void add(const int16_t* a, const int16_t* b, int16_t* out, int n) {
+        int count = n >> 3;
+        if (count == 0 || !aligned(a, b, out)) {
+            DspPortable::add(a, b, out, n);
+            return;
+        }
+        dsp_pie_add(a, b, out, count);
+        int done = count << 3;
+        DspPortable::add(a + done, b + done, out + done, n - done);
+    }
+
+    static void mix(const int16_t* a, int16_t ga, const int16_t* b, int16_t gb, int16_t* out, int n) {
+        ga = DspPortable::clampGain(ga);
+        gb = DspPortable::clampGain(gb);
+        int count = n >> 3;
+        if (count == 0 || !aligned(a, b, out)) {
+            DspPortable::mix(a, ga, b, gb, out, n);
+            return;
+        }
+        dsp_pie_mix(a, b, out, count, &ga, &gb);
+        int done = count << 3;
+        DspPortable::mix(a + done, ga, b + done, gb, out + done, n - done);
+    }
+
+    static void mac(const int16_t* in, int16_t g, int16_t* acc, int n) {
+        g = DspPortable::clampGain(g);
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, acc)) {
+            DspPortable::mac(in, g, acc, n);
+            return;
+        }
+        dsp_pie_mac(in, acc, count, &g);
+        int done = count << 3;
+        DspPortable::mac(in + done, g, acc + done, n - done);
+    }
+
+    static void mac32(const int16_t* in, int16_t g, int32_t* acc, int n) {
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, acc)) {
+            DspPortable::mac32(in, g, acc, n);
+            return;
+        }
+        dsp_pie_mac32(in, acc, count, &g);
+        int done = count << 3;
+        DspPortable::mac32(in + done, g, acc + done, n - done);
+    }
+
+    static void saturate(const int32_t* in, int shift, int16_t* out, int n) {
+        static const int32_t limits[2] = {32767, -32768};
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, out)) {
+            DspPortable::saturate(in, shift, out, n);
+            return;
+        }
+        dsp_pie_saturate(in, out, count, shift, limits);
+        int done = count << 3;
+        DspPortable::saturate(in + done, shift, out + done, n - done);
+    }
+
+    static void clip(const int16_t* in, int16_t lo, int16_t hi, int16_t* out, int n) {
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, out)) {
+            DspPortable::clip(in, lo, hi, out, n);
+            return;
+        }
+        dsp_pie_clip(in, out, count, &lo, &hi);
+        int done = count << 3;
+        DspPortable::clip(in + done, lo, hi, out + done, n - done);
+    }
+
+    static void crossfade(const int16_t* a, const int16_t* b, int16_t m, int16_t* out, int n) {
+        m = m < 0 ? 0 : m;
+        int16_t im = 32767 - m;
+        int count = n >> 3;
+        if (count == 0 || !aligned(a, b, out)) {
+            DspPortable::crossfade(a, b, m, out, n);
+            return;
+        }
+        // 与 mix 相同的运算, 增益为 (1 - m, m)
+        dsp_pie_mix(a, b, out, count, &im, &m);
+        int done = count << 3;
+        DspPortable::crossfade(a + done, b + done, m, out + done, n - done);
+    }
+
+    // 只要求 b (通常是系数) 对齐, a 可以是滑动窗口中的任意位置
+    static int64_t dot(const int16_t* a, const int16_t* b, int n) {
+        if (((uintptr_t)b & 15) != 0) {
+            return DspPortable::dot(a, b, n);
+        }
+        int64_t acc = 0;
+        int done = 0;
+        while (n - done >= 8) {
+            int count = (n - done) >> 3;
+            if (count > DSP_PIE_DOT_CHUNK) count = DSP_PIE_DOT_CHUNK;
+            acc += dsp_pie_dot(a + done, b + done, count);
+            done += count << 3;
+        }
+        return acc + DspPortable::dot(a + done, b + done, n - done);
+    }
+
+    static int32_t peak(const int16_t* in, int n) {
+        int count = n >> 3;
+        if (count == 0 || !aligned(in, nullptr)) {
+            return DspPortable::peak(in, n);
+        }
+        DSP_ALIGN int16_t lanes[16];
+        dsp_pie_peak(in, count, lanes);
+        int done = count << 3;
+        return peakOfLanes(lanes, DspPortable::peak(in + done, n - done));
+    }
+
+    static void toFloat(const int16_t* in, float* out, int n) {
+        dsp_pie_to_float(in, out, n);
+    }
+
+    static void fromFloat(const float* in, int16_t* out, int n) {
+        dsp_pie_from_float(in, out, n);
+    }
+
+private:
+    static inline bool aligned(const void* a, const void* b, const void* c = nullptr) {
+        return (((uintptr_t)a | (uintptr_t)b | (uintptr_t)c) & 15) == 0;
+    }
+};
+#else
+class DspSimd: public DspPortable {};
+#endif
+
+// 模块使用的内核集合
+typedef DspSimd Dsp;
+
+// 每个内核对比可移植实现与 SIMD 实现的吞吐量 (每次处理一个块)
+inline void benchDspKernels(uint32_t blocks) {
+    DSP_ALIGN int16_t a[AUDIO_BLOCK_SIZE], b[AUDIO_BLOCK_SIZE], out[AUDIO_BLOCK_SIZE];
+    DSP_ALIGN int32_t acc[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN float f[AUDIO_BLOCK_SIZE];
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        a[i] = i * 997;
+        b[i] = -i * 531;
+        f[i] = i / (float)AUDIO_BLOCK_SIZE - 0.5f;
+    }
+    volatile int64_t sink = 0;
+    printf("DSP kernels: portable vs %s\n", DSP_IMPL_NAME);
+#define DSP_BENCH(name, call) \
+    benchPrint(benchRun(name " portable", blocks, AUDIO_BLOCK_SIZE, [&]() { DspPortable::call; })); \
+    benchPrint(benchRun(name " simd", blocks, AUDIO_BLOCK_SIZE, [&]() { Dsp::call; }))
+    DSP_BENCH("gain", gain(a, 12345, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("add", add(a, b, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("mix", mix(a, 12345, b, 23456, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("mac", mac(a, 12345, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("mac32", mac32(a, 12345, acc, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("saturate", saturate(acc, 15, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("clip", clip(a, -16384, 16384, out, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("crossfade", crossfade(a, b, 8192, out, AUDIO_BLOCK_SIZE));
+    benchPrint(benchRun("dot portable", blocks, AUDIO_BLOCK_SIZE, [&]() { sink = sink + DspPortable::dot(a, b, AUDIO_BLOCK_SIZE); }));
+    benchPrint(benchRun("dot simd", blocks, AUDIO_BLOCK_SIZE, [&]() { sink = sink + Dsp::dot(a, b, AUDIO_BLOCK_SIZE); }));
+    benchPrint(benchRun("peak portable", blocks, AUDIO_BLOCK_SIZE, [&]() { sink = sink + DspPortable::peak(a, AUDIO_BLOCK_SIZE); }));
+    benchPrint(benchRun("peak simd", blocks, AUDIO_BLOCK_SIZE, [&]() { sink = sink + Dsp::peak(a, AUDIO_BLOCK_SIZE); }));
+    DSP_BENCH("toFloat", toFloat(a, f, AUDIO_BLOCK_SIZE));
+    DSP_BENCH("fromFloat", fromFloat(f, out, AUDIO_BLOCK_SIZE));
+#undef DSP_BENCH
+}
+
+#endif
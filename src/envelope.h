@@ -0,0 +1,268 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <stdint.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "bench.h"
+#include "src_config.h"
+
+#define ENV_CURVE_BITS 8
+#define ENV_CURVE_SIZE (1 << ENV_CURVE_BITS)
+#define ENV_PHASE_BITS 24   // 段内进度, 1 << 24 = 段结束
+#define ENV_LEVEL_SHIFT 8   // 电平内部比 Q15 多 8 位, 块内斜坡更平滑
+
+typedef enum {
+    ENV_IDLE,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE
+} env_stage_t;
+
+typedef enum {
+    ENV_CURVE_LINEAR,
+    ENV_CURVE_EXP
+} env_curve_t;
+
+// 指数曲线表 (Q15), 启动时生成一次: y = (1 - e^(-k x)) / (1 - e^(-k))
+// 起音用较缓的曲线, 衰减与释放用较陡的曲线 (模拟 RC 充放电)
+class EnvelopeTables {
+public:
+    static void init() {
+        if (ready) return;
+        build(attackCurve, 2.0f);
+        build(decayCurve, 5.0f);
+        for (int i = 0; i <= ENV_CURVE_SIZE; i++) {
+            linearCurve[i] = (int32_t)i * 32768 / ENV_CURVE_SIZE;
+        }
+        ready = true;
+    }
+
+    // phase 为 Q24 段内进度, 返回 Q15 曲线值
+    static inline int32_t lookup(const int16_t* table, uint32_t phase) {
+        uint32_t i = phase >> (ENV_PHASE_BITS - ENV_CURVE_BITS);
+        if (i >= ENV_CURVE_SIZE) return table[ENV_CURVE_SIZE];
+        int32_t frac = (phase >> (ENV_PHASE_BITS - ENV_CURVE_BITS - 15)) & 0x7FFF;
+        return table[i] + (((table[i + 1] - table[i]) * frac) >> 15);
+    }
+
+    static int16_t attackCurve[ENV_CURVE_SIZE + 1];
+    static int16_t decayCurve[ENV_CURVE_SIZE + 1];
+    static int16_t linearCurve[ENV_CURVE_SIZE + 1];
+
+private:
+    static bool ready;
+
+    static void build(int16_t* table, float k) {
+        float norm = 1.0f / (1.0f - expf(-k));
+        for (int i = 0; i <= ENV_CURVE_SIZE; i++) {
+            float x = (float)i / ENV_CURVE_SIZE;
+            table[i] = (int16_t)lrintf((1.0f - expf(-k * x)) * norm * 32767);
+        }
+    }
+};
+
+int16_t EnvelopeTables::attackCurve[ENV_CURVE_SIZE + 1];
+int16_t EnvelopeTables::decayCurve[ENV_CURVE_SIZE + 1];
+int16_t EnvelopeTables::linearCurve[ENV_CURVE_SIZE + 1];
+bool EnvelopeTables::ready = false;
+
+// ADSR 包络: 每段从当前电平走向目标电平, 电平 = 起点 + (目标 - 起点) * 曲线(进度)
+// 每次只在段的起止处查表, 中间按固定增量线性插值, 门限沿处把块拆开处理
+class Envelope: public Module_t {
+public:
+    Envelope() { module_info = {"envelope", "libchara-dev", "ADSR envelope generator with exponential curves", false, false}; }
+
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t retrig[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int attack = 10;        // ms
+    int decay = 200;        // ms
+    int sustain = 24576;    // Q15
+    int release = 300;      // ms
+    int curve = ENV_CURVE_EXP;
+
+    env_stage_t stage = ENV_IDLE;
+
+    void start() {
+        EnvelopeTables::init();
+        registerPort(gate, PORT_DIN, "GATE", "gate input");
+        registerPort(retrig, PORT_DIN, "RETRIG", "rising edge restarts attack");
+        registerPort(out, PORT_AOUT, "OUTPUT", "envelope output, Q15");
+        registerParam(&attack, PARAM_INT, "Attack", "attack time (ms)");
+        registerParam(&decay, PARAM_INT, "Decay", "decay time (ms)");
+        registerParam(&sustain, PARAM_INT, "Sustain", "sustain level, Q15");
+        registerParam(&release, PARAM_INT, "Release", "release time (ms)");
+        registerParam(&curve, PARAM_INT, "Curve", "0:linear 1:exponential");
+        printf("Envelope Start\n");
+    }
+    void stop() {
+        printf("Envelope Stop\n");
+    }
+    void process() {
+        updateRates();
+        int i = 0;
+        while (i < AUDIO_BLOCK_SIZE) {
+            // 找到下一个门限或重触发沿
+            int end = i;
+            bool g = lastGate, r = lastRetrig;
+            for (; end < AUDIO_BLOCK_SIZE; end++) {
+                g = gate[end] != 0;
+                r = retrig[end] != 0;
+                if (g != lastGate || (r && !lastRetrig)) break;
+                lastRetrig = r;
+            }
+            render(i, end);
+            if (end < AUDIO_BLOCK_SIZE) {
+                if (g && (!lastGate || (r && !lastRetrig))) {
+                    enterStage(ENV_ATTACK);
+                } else if (!g && lastGate) {
+                    enterStage(ENV_RELEASE);
+                }
+                lastGate = g;
+                lastRetrig = r;
+                // 沿所在的采样属于新段
+                render(end, end + 1);
+                end++;
+            }
+            i = end;
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    int32_t level = 0;          // Q15 << ENV_LEVEL_SHIFT
+    int32_t segStart = 0;
+    int32_t segTarget = 0;
+    uint32_t phase = 0;         // Q24
+    uint32_t inc = 0;           // 当前段每采样的进度增量
+    uint32_t attackInc = 0, decayInc = 0, releaseInc = 0;
+    int cachedAttack = -1, cachedDecay = -1, cachedRelease = -1;
+    uint32_t cachedRate = 0;
+    bool lastGate = false;
+    bool lastRetrig = false;
+
+    // 只有参数变化时才做除法
+    uint32_t msToInc(int ms) {
+        uint32_t samples = (uint32_t)((uint64_t)(ms < 0 ? 0 : ms) * sampleRate / 1000);
+        return samples ? (1u << ENV_PHASE_BITS) / samples : (1u << ENV_PHASE_BITS);
+    }
+
+    void updateRates() {
+        if (attack == cachedAttack && decay == cachedDecay && release == cachedRelease && sampleRate == cachedRate) return;
+        cachedAttack = attack;
+        cachedDecay = decay;
+        cachedRelease = release;
+        cachedRate = sampleRate;
+        attackInc = msToInc(attack);
+        decayInc = msToInc(decay);
+        releaseInc = msToInc(release);
+        if (stage == ENV_ATTACK) inc = attackInc;
+        if (stage == ENV_DECAY) inc = decayInc;
+        if (stage == ENV_RELEASE) inc = releaseInc;
+    }
+
+    int32_t sustainLevel() {
+        int32_t s = sustain < 0 ? 0 : (sustain > 32767 ? 32767 : sustain);
+        return s << ENV_LEVEL_SHIFT;
+    }
+
+    // 新段从当前电平出发 (重触发与提前释放都不跳变)
+    void enterStage(env_stage_t next) {
+        stage = next;
+        phase = 0;
+        segStart = level;
+        switch (next) {
+            case ENV_ATTACK:
+                segTarget = 32767 << ENV_LEVEL_SHIFT;
+                inc = attackInc;
+                break;
+            case ENV_DECAY:
+                segTarget = sustainLevel();
+                inc = decayInc;
+                break;
+            case ENV_RELEASE:
+                segTarget = 0;
+                inc = releaseInc;
+                break;
+            default:
+                inc = 0;
+                break;
+        }
+    }
+
+    const int16_t* curveTable() {
+        if (curve == ENV_CURVE_LINEAR) return EnvelopeTables::linearCurve;
+        return stage == ENV_ATTACK ? EnvelopeTables::attackCurve : EnvelopeTables::decayCurve;
+    }
+
+    int32_t levelAt(uint32_t p) {
+        int32_t c = EnvelopeTables::lookup(curveTable(), p);
+        return segStart + (int32_t)(((int64_t)(segTarget - segStart) * c) >> 15);
+    }
+
+    // 输出 [from, to) 区间: 只计算区间终点电平, 中间等增量插值
+    void render(int from, int to) {
+        int n = to - from;
+        if (n <= 0) return;
+        int32_t target;
+        if (stage == ENV_SUSTAIN) {
+            target = sustainLevel(); // 持续段跟随参数变化
+        } else if (stage == ENV_IDLE) {
+            target = 0;
+        } else {
+            phase += inc * n;
+            target = levelAt(phase);
+        }
+        int32_t step = (target - level) / n;
+        int32_t l = level;
+        for (int i = from; i < to; i++) {
+            l += step;
+            out[i] = l >> ENV_LEVEL_SHIFT;
+        }
+        out[to - 1] = target >> ENV_LEVEL_SHIFT;
+        level = target;
+        if (stage != ENV_SUSTAIN && stage != ENV_IDLE && phase >= (1u << ENV_PHASE_BITS)) {
+            // 段结束, 衔接下一段
+            if (stage == ENV_ATTACK) {
+                enterStage(ENV_DECAY);
+            } else if (stage == ENV_DECAY) {
+                stage = ENV_SUSTAIN;
+            } else {
+                stage = ENV_IDLE;
+                level = 0;
+            }
+        }
+    }
+};
+
+// 单实例耗时, 以及 32 个实例占单核的比例
+inline void benchEnvelope(uint32_t blocks) {
+    Envelope* env = new Envelope();
+    env->start();
+    env->attack = 5;
+    env->decay = 50;
+    env->release = 80;
+    uint32_t count = 0;
+    bench_result_t r = benchRun("envelope", blocks, AUDIO_BLOCK_SIZE, [&]() {
+        // 每 128 个块切换一次门限, 覆盖各段
+        int16_t g = (count++ >> 7) & 1;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            env->gate[i] = g;
+        }
+        env->process();
+    });
+    benchPrint(r);
+    double nsPerSample = r.totalUs * 1000.0 / ((double)r.iterations * r.samplesPerIteration);
+    printf("32 envelopes: %.3f%% of one core\n", 32 * nsPerSample * SMP_RATE / 1e9 * 100);
+    env->stop();
+    delete env;
+}
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stdint.h>
+#include <math.h>
+#include "platform_compat.h"
+#include "src_config.h"
+
+// 事件端口: 与音频端口相同的 AUDIO_BLOCK_SIZE 个 int16, 由 ConnectionManager 照常整块复制
+// 布局: [0] = 事件数, 之后每个事件占 3 个字:
+//   [0] 块内采样偏移 (低 6 位) | 类型 << 6 | 通道 << 10
+//   [1] data1 (音符号 / 控制器号)
+//   [2] data2 (力度 / 控制值 / 弯音 -8192 ~ 8191)
+// 事件按偏移升序排列; 空块只需检查第一个字, 事件模块空闲时几乎没有开销
+#define EVENT_WORDS 3
+#define EVENT_MAX_PER_BLOCK ((AUDIO_BLOCK_SIZE - 1) / EVENT_WORDS)
+
+typedef enum {
+    EVENT_NOTE_OFF,
+    EVENT_NOTE_ON,
+    EVENT_CONTROL,
+    EVENT_PITCH_BEND,
+    EVENT_PROGRAM,
+    EVENT_CLOCK,        // MIDI 时钟, 每四分音符 24 个
+    EVENT_START,
+    EVENT_STOP
+} event_type_t;
+
+typedef struct {
+    uint8_t offset;     // 块内采样偏移
+    uint8_t type;       // event_type_t
+    uint8_t channel;
+    uint8_t data1;
+    int16_t data2;
+} note_event_t;
+
+class EventBlock {
+public:
+    static inline void clear(int16_t* port) {
+        port[0] = 0;
+    }
+
+    // 计数夹到 [0, EVENT_MAX_PER_BLOCK], 误接的音频数据也不会越界读取
+    static inline int count(const int16_t* port) {
+        int n = port[0];
+        return n < 0 ? 0 : (n > EVENT_MAX_PER_BLOCK ? EVENT_MAX_PER_BLOCK : n);
+    }
+
+    // 消费方读取输入: 返回事件数并把计数清零, 事件内容仍可用 get() 读取
+    // 已连接的输入每块由 ConnectionManager 重新写入, 断开后不会重放最后一块
+    static inline int take(int16_t* port) {
+        int n = count(port);
+        port[0] = 0;
+        return n;
+    }
+
+    // 按偏移顺序追加, 块满时丢弃并返回 false
+    static inline bool push(int16_t* port, const note_event_t& e) {
+        int n = count(port);
+        if (n >= EVENT_MAX_PER_BLOCK) return false;
+        int16_t* w = port + 1 + n * EVENT_WORDS;
+        w[0] = (int16_t)((e.offset & 0x3F) | ((e.type & 0xF) << 6) | ((e.channel & 0xF) << 10));
+        w[1] = e.data1;
+        w[2] = e.data2;
+        port[0] = n + 1;
+        return true;
+    }
+
+    static inline note_event_t get(const int16_t* port, int index) {
+        const int16_t* w = port + 1 + index * EVENT_WORDS;
+        note_event_t e;
+        e.offset = w[0] & 0x3F;
+        e.type = (w[0] >> 6) & 0xF;
+        e.channel = (w[0] >> 10) & 0xF;
+        e.data1 = (uint8_t)w[1];
+        e.data2 = w[2];
+        return e;
+    }
+};
+
+// 事件到单音控制信号 (门 / 频率 / 力度) 的转换, 最后音符优先
+// 在事件之间整段填充, 没有事件的块只是一次填充
+class MonoNoteCv {
+public:
+    void begin() {
+        for (int n = 0; n < 128; n++) {
+            float hz = 440.0f * powf(2.0f, (n - 69) / 12.0f);
+            noteHz[n] = (int16_t)(hz > 32767 ? 32767 : lrintf(hz));
+        }
+    }
+
+    void apply(const note_event_t& e) {
+        if (e.type == EVENT_NOTE_ON) {
+            currentNote = e.data1;
+            gateLevel = 1;
+            freqLevel = noteHz[e.data1 & 0x7F];
+            velocityLevel = (int16_t)(e.data2 * 258);
+        } else if (e.type == EVENT_NOTE_OFF && e.data1 == currentNote) {
+            currentNote = -1;
+            gateLevel = 0;
+        }
+    }
+
+    void fill(int16_t* gate, int16_t* freq, int16_t* velocity, int from, int to) {
+        for (int i = from; i < to; i++) {
+            gate[i] = gateLevel;
+            freq[i] = freqLevel;
+            velocity[i] = velocityLevel;
+        }
+    }
+
+private:
+    int16_t noteHz[128];
+    int currentNote = -1;
+    int16_t gateLevel = 0, freqLevel = 0, velocityLevel = 0;
+};
+
+// 音频采样时钟: 引擎在每块开始时记录块首采样号与当时的 esp_timer 时间,
+// 输入线程据此把到达时间 (us) 换算为采样位置
+class AudioClock {
+public:
+    void beginBlock() {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&lock);
+        blockUs = now;
+        blockSample = nextSample;
+        nextSample += AUDIO_BLOCK_SIZE;
+        portEXIT_CRITICAL(&lock);
+    }
+
+    // 当前块首个采样的位置 (仅音频线程调用)
+    int64_t blockStart() const {
+        return blockSample;
+    }
+
+    // 任意线程调用
+    int64_t sampleAt(int64_t us) {
+        portENTER_CRITICAL(&lock);
+        int64_t s = blockSample;
+        int64_t t = blockUs;
+        portEXIT_CRITICAL(&lock);
+        return s + (us - t) * SMP_RATE / 1000000;
+    }
+
+private:
+    int64_t blockSample = 0;
+    int64_t nextSample = 0;
+    int64_t blockUs = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
+
+AudioClock audio_clock;
+
+#endif
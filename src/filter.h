@@ -0,0 +1,353 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stdint.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "bench.h"
+#include "src_config.h"
+
+#define FILTER_CTRL_INTERVAL 16 // 系数更新间隔 (控制率), 需整除 AUDIO_BLOCK_SIZE
+#define FILTER_MAX_STAGES 4
+
+typedef enum {
+    FILTER_LOWPASS,
+    FILTER_HIGHPASS,
+    FILTER_BANDPASS,
+    FILTER_NOTCH
+} filter_mode_t;
+
+typedef enum {
+    FILTER_SVF,
+    FILTER_BIQUAD
+} filter_type_t;
+
+// 控制率下使用的查表近似: 2^x 与 tan(pi * x)
+class FilterTables {
+public:
+    static const int EXP_SIZE = 64;
+    static const int SIN_SIZE = 256; // 四分之一周期
+
+    static void init() {
+        if (ready) return;
+        for (int i = 0; i <= EXP_SIZE; i++) {
+            expTable[i] = exp2f((float)i / EXP_SIZE);
+        }
+        for (int i = 0; i <= SIN_SIZE; i++) {
+            sinTable[i] = sinf((float)M_PI / 2 * i / SIN_SIZE);
+        }
+        ready = true;
+    }
+
+    static float exp2(float x) {
+        float fl = floorf(x);
+        float pos = (x - fl) * EXP_SIZE;
+        int i = (int)pos;
+        float y = expTable[i] + (expTable[i + 1] - expTable[i]) * (pos - i);
+        return ldexpf(y, (int)fl);
+    }
+
+    // x 为归一化频率 (fc / fs), 范围 [0, 0.5)
+    static float tanPi(float x) {
+        return sinQuarter(x * 2) / sinQuarter(1 - x * 2);
+    }
+
+    // sin(pi / 2 * x), x 范围 [0, 1]
+    static float sinQuarter(float x) {
+        float pos = x * SIN_SIZE;
+        int i = (int)pos;
+        if (i >= SIN_SIZE) return 1.0f;
+        return sinTable[i] + (sinTable[i + 1] - sinTable[i]) * (pos - i);
+    }
+
+private:
+    static float expTable[EXP_SIZE + 1];
+    static float sinTable[SIN_SIZE + 1];
+    static bool ready;
+};
+
+float FilterTables::expTable[FilterTables::EXP_SIZE + 1];
+float FilterTables::sinTable[FilterTables::SIN_SIZE + 1];
+bool FilterTables::ready = false;
+
+// 多模式滤波器: 梯形积分 SVF 或级联双二阶, 定点 / 浮点两种精度
+// 截止频率与共振可由端口以音频率调制, 系数每 FILTER_CTRL_INTERVAL 个采样更新一次
+class FilterModule: public Module_t {
+public:
+    static const int OCTAVE = 4096;     // CUTOFF 端口 Q12, 4096 = 1 个八度
+    static const int COEF_SHIFT = 28;   // 定点系数 Q28
+    static const int STATE_SHIFT = 8;   // 定点状态比采样多 8 位精度
+    static const int32_t STAGE_LIMIT = 1 << 30;
+
+    FilterModule() { module_info = {"filter", "libchara-dev", "Multimode SVF / cascaded biquad filter", false, false}; }
+
+    int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int16_t cutoffMod[AUDIO_BLOCK_SIZE] = {};
+    int16_t resMod[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int type = FILTER_SVF;
+    int mode = FILTER_LOWPASS;
+    int cutoff = 1000;      // Hz
+    int resonance = 8192;   // Q15
+    int stages = 2;
+    int useFloat = 0;
+
+    void start() {
+        FilterTables::init();
+        registerPort(in, PORT_AIN, "INPUT", "signal input");
+        registerPort(cutoffMod, PORT_AIN, "CUTOFF", "cutoff modulation, Q12 octaves");
+        registerPort(resMod, PORT_AIN, "RES", "resonance modulation, Q15");
+        registerPort(out, PORT_AOUT, "OUTPUT", "filter output");
+        registerParam(&type, PARAM_INT, "Type", "0:svf 1:biquad cascade");
+        registerParam(&mode, PARAM_INT, "Mode", "0:lp 1:hp 2:bp 3:notch");
+        registerParam(&cutoff, PARAM_INT, "Cutoff", "cutoff frequency (Hz)");
+        registerParam(&resonance, PARAM_INT, "Resonance", "Q15, 0 ~ 32767");
+        registerParam(&stages, PARAM_INT, "Stages", "biquad stages, 1 ~ 4");
+        registerParam(&useFloat, PARAM_INT, "Float", "0:fixed point 1:float");
+        printf("Filter Start\n");
+    }
+    void stop() {
+        printf("Filter Stop\n");
+    }
+    void process() {
+        // 切换结构或精度时清空状态
+        int layout = type * 2 + (useFloat != 0);
+        if (layout != lastLayout) {
+            reset();
+            lastLayout = layout;
+        }
+        filter_mode_t m = (filter_mode_t)(mode < 0 ? 0 : (mode > FILTER_NOTCH ? FILTER_NOTCH : mode));
+        int n = stages < 1 ? 1 : (stages > FILTER_MAX_STAGES ? FILTER_MAX_STAGES : stages);
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i += FILTER_CTRL_INTERVAL) {
+            float g, k;
+            controlRate(cutoffMod[i], resMod[i], &g, &k);
+            if (type == FILTER_BIQUAD) {
+                biquadCoefs(m, g, k);
+                for (int s = 0; s < n; s++) {
+                    if (useFloat) {
+                        biquadFloat(fstage[s], s == 0, i);
+                    } else {
+                        biquadFixed(istage[s], s == 0, i);
+                    }
+                }
+                for (int j = 0; j < FILTER_CTRL_INTERVAL; j++) {
+                    out[i + j] = useFloat ? sat16((int32_t)lrintf(fwork[j] * 32768)) : sat16(work[j] >> STATE_SHIFT);
+                }
+            } else {
+                svfCoefs(g, k);
+                if (useFloat) {
+                    svfFloat(m, i);
+                } else {
+                    svfFixed(m, i);
+                }
+            }
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+    void reset() {
+        fic1 = fic2 = 0;
+        ic1 = ic2 = 0;
+        for (int s = 0; s < FILTER_MAX_STAGES; s++) {
+            fstage[s] = {};
+            istage[s] = {};
+        }
+    }
+
+private:
+    struct float_stage_t {
+        float z1, z2;
+    };
+    struct fixed_stage_t {
+        int32_t x1, x2, y1, y2;
+    };
+
+    int lastLayout = -1;
+
+    // SVF 系数与状态
+    float fa1 = 0, fa2 = 0, fa3 = 0, fk = 2;
+    float fic1 = 0, fic2 = 0;
+    int32_t a1 = 0, a2 = 0, a3 = 0, k28 = 0;
+    int32_t ic1 = 0, ic2 = 0;
+
+    // 双二阶系数 (所有级共用) 与各级状态
+    float fb0 = 0, fb1 = 0, fb2 = 0, fb3 = 0, fb4 = 0;
+    int32_t ib0 = 0, ib1 = 0, ib2 = 0, ib3 = 0, ib4 = 0;
+    float_stage_t fstage[FILTER_MAX_STAGES] = {};
+    fixed_stage_t istage[FILTER_MAX_STAGES] = {};
+    int32_t work[FILTER_CTRL_INTERVAL];
+    float fwork[FILTER_CTRL_INTERVAL];
+
+    static inline int16_t sat16(int32_t v) {
+        return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+
+    static inline int32_t toFixed(float c) {
+        return (int32_t)lrintf(c * (1 << COEF_SHIFT));
+    }
+
+    // g = tan(pi * fc / fs), k = 1 / Q
+    void controlRate(int16_t cutMod, int16_t rMod, float* g, float* k) {
+        float fc = cutoff * FilterTables::exp2((float)cutMod / OCTAVE);
+        float x = fc / sampleRate;
+        x = x < 0.0001f ? 0.0001f : (x > 0.45f ? 0.45f : x);
+        *g = FilterTables::tanPi(x);
+        int32_t r = resonance + rMod;
+        r = r < 0 ? 0 : (r > 32767 ? 32767 : r);
+        *k = 2.0f - 2.0f * r / 32768;
+        if (*k < 0.02f) *k = 0.02f;
+    }
+
+    void svfCoefs(float g, float k) {
+        fa1 = 1.0f / (1.0f + g * (g + k));
+        fa2 = g * fa1;
+        fa3 = g * fa2;
+        fk = k;
+        if (!useFloat) {
+            a1 = toFixed(fa1);
+            a2 = toFixed(fa2);
+            a3 = toFixed(fa3);
+            k28 = toFixed(fk);
+        }
+    }
+
+    // RBJ 双二阶, 由 g = tan(w0 / 2) 推出 cos(w0) 与 sin(w0)
+    void biquadCoefs(filter_mode_t m, float g, float k) {
+        float g2 = g * g;
+        float cw = (1 - g2) / (1 + g2);
+        float sw = 2 * g / (1 + g2);
+        float alpha = sw * k / 2;
+        float a0 = 1 + alpha;
+        float b0, b1, b2;
+        switch (m) {
+            case FILTER_HIGHPASS:
+                b0 = (1 + cw) / 2; b1 = -(1 + cw); b2 = b0;
+                break;
+            case FILTER_BANDPASS:
+                b0 = alpha; b1 = 0; b2 = -alpha;
+                break;
+            case FILTER_NOTCH:
+                b0 = 1; b1 = -2 * cw; b2 = 1;
+                break;
+            default:
+                b0 = (1 - cw) / 2; b1 = 1 - cw; b2 = b0;
+                break;
+        }
+        fb0 = b0 / a0;
+        fb1 = b1 / a0;
+        fb2 = b2 / a0;
+        fb3 = -2 * cw / a0;
+        fb4 = (1 - alpha) / a0;
+        if (!useFloat) {
+            ib0 = toFixed(fb0);
+            ib1 = toFixed(fb1);
+            ib2 = toFixed(fb2);
+            ib3 = toFixed(fb3);
+            ib4 = toFixed(fb4);
+        }
+    }
+
+    // 以下内层循环先把系数与状态读入局部变量, 循环中只做乘加
+
+    void svfFloat(filter_mode_t m, int offset) {
+        const float c1 = fa1, c2 = fa2, c3 = fa3, k = fk;
+        float s1 = fic1, s2 = fic2;
+        for (int j = offset; j < offset + FILTER_CTRL_INTERVAL; j++) {
+            float v0 = in[j] * (1.0f / 32768);
+            float v3 = v0 - s2;
+            float v1 = c1 * s1 + c2 * v3;
+            float v2 = s2 + c2 * s1 + c3 * v3;
+            s1 = 2 * v1 - s1;
+            s2 = 2 * v2 - s2;
+            float y;
+            switch (m) {
+                case FILTER_HIGHPASS: y = v0 - k * v1 - v2; break;
+                case FILTER_BANDPASS: y = v1; break;
+                case FILTER_NOTCH: y = v0 - k * v1; break;
+                default: y = v2; break;
+            }
+            out[j] = sat16((int32_t)lrintf(y * 32768));
+        }
+        fic1 = s1;
+        fic2 = s2;
+    }
+
+    void svfFixed(filter_mode_t m, int offset) {
+        const int32_t c1 = a1, c2 = a2, c3 = a3, k = k28;
+        int32_t s1 = ic1, s2 = ic2;
+        for (int j = offset; j < offset + FILTER_CTRL_INTERVAL; j++) {
+            int32_t v0 = in[j] << STATE_SHIFT;
+            int32_t v3 = v0 - s2;
+            int32_t v1 = ((int64_t)c1 * s1 + (int64_t)c2 * v3) >> COEF_SHIFT;
+            int32_t v2 = s2 + (int32_t)(((int64_t)c2 * s1 + (int64_t)c3 * v3) >> COEF_SHIFT);
+            s1 = 2 * v1 - s1;
+            s2 = 2 * v2 - s2;
+            int32_t y;
+            switch (m) {
+                case FILTER_HIGHPASS: y = v0 - (int32_t)(((int64_t)k * v1) >> COEF_SHIFT) - v2; break;
+                case FILTER_BANDPASS: y = v1; break;
+                case FILTER_NOTCH: y = v0 - (int32_t)(((int64_t)k * v1) >> COEF_SHIFT); break;
+                default: y = v2; break;
+            }
+            out[j] = sat16(y >> STATE_SHIFT);
+        }
+        ic1 = s1;
+        ic2 = s2;
+    }
+
+    // 转置直接 II 型, 级间以 fwork 传递
+    void biquadFloat(float_stage_t& st, bool first, int offset) {
+        const float b0 = fb0, b1 = fb1, b2 = fb2, c1 = fb3, c2 = fb4;
+        float z1 = st.z1, z2 = st.z2;
+        for (int j = 0; j < FILTER_CTRL_INTERVAL; j++) {
+            float x = first ? in[offset + j] * (1.0f / 32768) : fwork[j];
+            float y = b0 * x + z1;
+            z1 = b1 * x - c1 * y + z2;
+            z2 = b2 * x - c2 * y;
+            fwork[j] = y;
+        }
+        st.z1 = z1;
+        st.z2 = z2;
+    }
+
+    // 直接 I 型, 级间以 work 传递 (带 STATE_SHIFT 位额外精度)
+    void biquadFixed(fixed_stage_t& st, bool first, int offset) {
+        const int32_t b0 = ib0, b1 = ib1, b2 = ib2, c1 = ib3, c2 = ib4;
+        int32_t x1 = st.x1, x2 = st.x2, y1 = st.y1, y2 = st.y2;
+        for (int j = 0; j < FILTER_CTRL_INTERVAL; j++) {
+            int32_t x = first ? in[offset + j] << STATE_SHIFT : work[j];
+            int64_t acc = (int64_t)b0 * x + (int64_t)b1 * x1 + (int64_t)b2 * x2 - (int64_t)c1 * y1 - (int64_t)c2 * y2;
+            // 多级高共振时限幅, 防止状态溢出
+            acc >>= COEF_SHIFT;
+            int32_t y = acc > STAGE_LIMIT ? STAGE_LIMIT : (acc < -STAGE_LIMIT ? -STAGE_LIMIT : (int32_t)acc);
+            x2 = x1; x1 = x;
+            y2 = y1; y1 = y;
+            work[j] = y;
+        }
+        st.x1 = x1; st.x2 = x2; st.y1 = y1; st.y2 = y2;
+    }
+};
+
+// 各结构单实例耗时, 截止频率以音频率调制 (每个控制周期都重算系数)
+inline void benchFilters(uint32_t blocks) {
+    static const char* names[] = {"filter svf fixed", "filter svf float", "filter biquad x4 fixed", "filter biquad x4 float"};
+    for (int v = 0; v < 4; v++) {
+        benchModule<FilterModule>(names[v], blocks, [v](FilterModule& m) {
+            m.type = v < 2 ? FILTER_SVF : FILTER_BIQUAD;
+            m.useFloat = v & 1;
+            m.stages = 4;
+            m.resonance = 16384;
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m.in[i] = i * 1024 - 32768;
+                m.cutoffMod[i] = (i * 97) % FilterModule::OCTAVE;
+            }
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef FM_SYNTH_H
+#define FM_SYNTH_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define FM_OPS 6
+#define FM_ALGORITHMS 8
+#define FM_SINE_BITS 10
+#define FM_MOD_SHIFT 18     // 调制输入 Q15 满幅 = 2 周期 (4π) 相位偏移
+#define FM_RATIO_ONE 4096   // 频率比 Q12
+#define FM_MAX_SOURCES 2    // 每个算子最多两个调制源
+
+// 共享正弦表: 1024 点 Q15, 末尾多一个点, 线性插值
+class FmSine {
+public:
+    static void initTable() {
+        if (tableReady) return;
+        for (int i = 0; i <= (1 << FM_SINE_BITS); i++) {
+            table[i] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * i / (1 << FM_SINE_BITS)));
+        }
+        tableReady = true;
+    }
+
+    static inline int32_t lookup(uint32_t phase) {
+        uint32_t idx = phase >> (32 - FM_SINE_BITS);
+        int32_t frac = (phase >> (32 - FM_SINE_BITS - 15)) & 0x7FFF;
+        int32_t a = table[idx];
+        return a + (((table[idx + 1] - a) * frac) >> 15);
+    }
+
+private:
+    static int16_t table[(1 << FM_SINE_BITS) + 1];
+    static bool tableReady;
+};
+
+int16_t FmSine::table[(1 << FM_SINE_BITS) + 1];
+bool FmSine::tableReady = false;
+
+// 算法以数据描述: 每个算子的调制源位掩码、载波掩码、反馈算子
+// 算子 0 ~ 5 对应 OP1 ~ OP6
+typedef struct {
+    uint8_t modulators[FM_OPS];
+    uint8_t carriers;
+    uint8_t feedback;
+} fm_algorithm_t;
+
+static const fm_algorithm_t fm_algorithms[FM_ALGORITHMS] = {
+    // 0: 6 -> 5 -> 4 -> 3 -> 2 -> 1
+    {{1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 0}, 1 << 0, 5},
+    // 1: 6 -> 5 -> 4 -> 3, 2 -> 1 (DX7 #1)
+    {{1 << 1, 0, 1 << 3, 1 << 4, 1 << 5, 0}, (1 << 0) | (1 << 2), 5},
+    // 2: 2 -> 1, 4 -> 3, 6 -> 5 (DX7 #5)
+    {{1 << 1, 0, 1 << 3, 0, 1 << 5, 0}, (1 << 0) | (1 << 2) | (1 << 4), 5},
+    // 3: 2 -> 1, (4 + 5) -> 3, 6 -> 5 (DX7 #7)
+    {{1 << 1, 0, (1 << 3) | (1 << 4), 0, 1 << 5, 0}, (1 << 0) | (1 << 2), 5},
+    // 4: 3 -> 2 -> 1, 6 -> 5 -> 4
+    {{1 << 1, 1 << 2, 0, 1 << 4, 1 << 5, 0}, (1 << 0) | (1 << 3), 5},
+    // 5: 2 -> 1, 6 -> 3 / 4 / 5 (DX7 #22)
+    {{1 << 1, 0, 1 << 5, 1 << 5, 1 << 5, 0}, (1 << 0) | (1 << 2) | (1 << 3) | (1 << 4), 5},
+    // 6: 6 -> 5, 其余为载波 (DX7 #31)
+    {{0, 0, 0, 0, 1 << 5, 0}, 0x1F, 5},
+    // 7: 全部为载波 (加法合成)
+    {{0, 0, 0, 0, 0, 0}, 0x3F, 5},
+};
+
+// 6 算子 FM (相位调制) 振荡器, 单声部
+// 算子状态按字段成组存放 (SoA), 每个采样对全部算子做同一组运算, 不按算法分支:
+// 所有调制源取上一个采样的算子输出, 调制链上每级多一个采样的延迟 (相当于恒定相移)
+class FmSynth: public Module_t {
+public:
+    FmSynth() { module_info = {"fm synth", "libchara-dev", "6-operator FM synth with selectable algorithms", false, false}; }
+
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t index[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int algorithm = 1;
+    int ratio[FM_OPS] = {FM_RATIO_ONE, FM_RATIO_ONE, FM_RATIO_ONE, FM_RATIO_ONE, FM_RATIO_ONE, FM_RATIO_ONE};
+    int level[FM_OPS] = {32767, 16384, 32767, 8192, 8192, 8192};
+    int feedback = 0;   // Q15
+
+    void start() {
+        FmSine::initTable();
+        registerPort(freq, PORT_AIN, "FREQ IN", "frequency input (Hz)");
+        registerPort(gate, PORT_DIN, "GATE", "gate, rising edge resets phases");
+        registerPort(index, PORT_AIN, "INDEX", "modulator level offset, Q15");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
+        registerParam(&algorithm, PARAM_INT, "Algorithm", "0 ~ 7");
+        registerParam(ratio, PARAM_ARY, "Ratio", "int[6], Q12 (4096 = 1.0)");
+        registerParam(level, PARAM_ARY, "Level", "int[6], Q15");
+        registerParam(&feedback, PARAM_INT, "Feedback", "Q15");
+        incPerHz = (uint32_t)(4294967296.0 / sampleRate);
+        printf("FmSynth Start\n");
+    }
+    void stop() {
+        printf("FmSynth Stop\n");
+    }
+    void process() {
+        updateAlgorithm();
+        int32_t lastFreq = -1;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            if (!gate[i]) {
+                out[i] = 0;
+                lastGate = false;
+                continue;
+            }
+            if (!lastGate) {
+                resetVoice();
+                lastGate = true;
+            }
+            if (freq[i] != lastFreq) {
+                lastFreq = freq[i];
+                uint32_t base = freq[i] > 0 ? (uint32_t)freq[i] * incPerHz : 0;
+                for (int k = 0; k < FM_OPS; k++) {
+                    op.inc[k] = (uint32_t)(((uint64_t)base * op.ratio[k]) >> 12);
+                }
+            }
+
+            // 调制输入: 反馈取最近两个输出的平均, 再加上调制源上一采样的输出
+            // 没有调制源的槽指向恒为 0 的 prev[FM_OPS]
+            int32_t m[FM_OPS], y[FM_OPS];
+            for (int k = 0; k < FM_OPS; k++) {
+                m[k] = ((op.feedback[k] * ((op.prev[k] + op.prev2[k]) >> 1)) >> 15) +
+                       op.prev[op.source[0][k]] + op.prev[op.source[1][k]];
+            }
+            int32_t acc = 0;
+            for (int k = 0; k < FM_OPS; k++) {
+                int32_t lvl = op.level[k] + (index[i] & op.modMask[k]);
+                lvl = lvl < 0 ? 0 : (lvl > 32767 ? 32767 : lvl);
+                y[k] = (FmSine::lookup(op.phase[k] + ((uint32_t)m[k] << FM_MOD_SHIFT)) * lvl) >> 15;
+                op.phase[k] += op.inc[k];
+                acc += y[k] & op.carrierMask[k];
+                op.prev2[k] = op.prev[k];
+                op.prev[k] = y[k];
+            }
+            acc = (acc * carrierGain) >> 15;
+            out[i] = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    // 单声部全部算子状态, 各字段按算子连续存放
+    struct {
+        DSP_ALIGN uint32_t phase[FM_OPS];
+        DSP_ALIGN uint32_t inc[FM_OPS];
+        DSP_ALIGN int32_t ratio[FM_OPS];
+        DSP_ALIGN int32_t level[FM_OPS];
+        DSP_ALIGN int32_t feedback[FM_OPS];
+        DSP_ALIGN int32_t prev[FM_OPS + 1];
+        DSP_ALIGN int32_t prev2[FM_OPS];
+        DSP_ALIGN int32_t modMask[FM_OPS];       // -1 = 调制器 (受 INDEX 影响)
+        DSP_ALIGN int32_t carrierMask[FM_OPS];   // -1 = 载波
+        DSP_ALIGN uint8_t source[FM_MAX_SOURCES][FM_OPS]; // 调制源算子序号, FM_OPS = 无
+    } op = {};
+
+    uint32_t incPerHz = 97391; // 2^32 / 44100
+    int32_t carrierGain = 32767;
+    bool lastGate = false;
+
+    void resetVoice() {
+        for (int k = 0; k < FM_OPS; k++) {
+            op.phase[k] = 0;
+            op.prev[k] = 0;
+            op.prev2[k] = 0;
+        }
+    }
+
+    // 每块把算法与参数展开为掩码, 采样循环内不再查表或分支
+    void updateAlgorithm() {
+        const fm_algorithm_t& alg = fm_algorithms[algorithm < 0 ? 0 : (algorithm >= FM_ALGORITHMS ? FM_ALGORITHMS - 1 : algorithm)];
+        int carriers = 0;
+        int32_t fb = feedback < 0 ? 0 : (feedback > 32767 ? 32767 : feedback);
+        for (int k = 0; k < FM_OPS; k++) {
+            bool carrier = alg.carriers & (1 << k);
+            carriers += carrier;
+            op.carrierMask[k] = carrier ? -1 : 0;
+            op.modMask[k] = carrier ? 0 : -1;
+            op.ratio[k] = ratio[k] < 0 ? 0 : ratio[k];
+            op.level[k] = level[k] < 0 ? 0 : (level[k] > 32767 ? 32767 : level[k]);
+            op.feedback[k] = k == alg.feedback ? fb : 0;
+            int n = 0;
+            for (int j = 0; j < FM_OPS; j++) {
+                if ((alg.modulators[k] & (1 << j)) && n < FM_MAX_SOURCES) op.source[n++][k] = j;
+            }
+            while (n < FM_MAX_SOURCES) op.source[n++][k] = FM_OPS;
+        }
+        carrierGain = 32767 / (carriers ? carriers : 1);
+    }
+};
+
+// 单声部耗时; 目标板上 "per core" 即单核可承载的声部数
+inline void benchFm(uint32_t blocks) {
+    static const char* names[] = {"fm synth alg 0", "fm synth alg 1", "fm synth alg 7"};
+    static const int algs[] = {0, 1, 7};
+    for (int v = 0; v < 3; v++) {
+        benchModule<FmSynth>(names[v], blocks, [v](FmSynth& m) {
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m.freq[i] = 220;
+                m.gate[i] = 1;
+                m.index[i] = 4096;
+            }
+            m.algorithm = algs[v];
+            m.feedback = 8192;
+            m.ratio[1] = 2 * FM_RATIO_ONE;
+            m.ratio[3] = 3 * FM_RATIO_ONE;
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,424 @@
+#ifndef GRANULAR_H
+#define GRANULAR_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "sample_source.h"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define GRAIN_MAX 64
+#define GRAIN_BUFFER_BITS 18        // 2^18 帧, 约 6 秒 (PSRAM 512 KB)
+#define GRAIN_BUFFER_FRAMES (1u << GRAIN_BUFFER_BITS)
+#define GRAIN_BUFFER_MASK (GRAIN_BUFFER_FRAMES - 1)
+#define GRAIN_POS_FRAC 14           // 读位置 18.14 定点
+#define GRAIN_WINDOW_BITS 10
+#define GRAIN_WINDOWS 3
+#define GRAIN_MAX_RATIO 4           // 音高上限 +2 八度
+#define GRAIN_FETCH (AUDIO_BLOCK_SIZE * GRAIN_MAX_RATIO + 2)
+
+typedef enum {
+    GRAIN_WINDOW_HANN,
+    GRAIN_WINDOW_TUKEY,     // 两端各 25% 的余弦过渡, 中间平坦
+    GRAIN_WINDOW_EXPODEC    // 快起音指数衰减, 适合打击感
+} grain_window_t;
+
+// 颗粒源缓冲 (PSRAM), 长度固定为 GRAIN_BUFFER_FRAMES, frames 为有效长度
+// 有效数据总在 [0, frames): 载入的采样从 0 开始, 录入时写位置与 frames 一同增长直到写满
+struct GrainBuffer {
+    int16_t* data = nullptr;
+    size_t frames = 0;
+
+    GrainBuffer() {
+        data = (int16_t*)psram_malloc(GRAIN_BUFFER_FRAMES * sizeof(int16_t));
+        if (data) memset(data, 0, GRAIN_BUFFER_FRAMES * sizeof(int16_t));
+    }
+    ~GrainBuffer() {
+        psram_free(data);
+    }
+};
+
+// 颗粒合成: 最多 64 个并发颗粒, 源为实时录入或从 flash / 文件载入的 PSRAM 缓冲
+// 颗粒状态按数组分开存放 (SoA), 活动颗粒始终紧凑排列在 [0, active)
+// 每个颗粒每块从 PSRAM 连续取回一段到内部 SRAM, 插值加窗后经 Dsp::mac32 累加
+// GATE 为高时按 Density 产生颗粒; Record 打开时 IN 持续写入环形缓冲, Position 0 为最近的音频
+class GranularModule: public Module_t {
+public:
+    GranularModule() { module_info = {"granular", "libchara-dev", "Granular synthesis over a PSRAM sample buffer", false, false}; }
+
+    int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t posMod[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int position = 0;       // Q15
+    int sizeMs = 80;
+    int density = 40;       // 每秒颗粒数
+    int pitch = 0;          // 音分, -2400 ~ 2400
+    int spray = 0;          // Q15, 起点随机偏移范围 (占缓冲长度)
+    int window = GRAIN_WINDOW_HANN;
+    int record = 0;
+
+    // 统计
+    uint32_t spawned = 0;
+    uint32_t skipped = 0;   // 颗粒已满时丢弃的次数
+    int peakActive = 0;
+
+    void start() {
+        initTables();
+        buffer = new GrainBuffer();
+        if (!buffer->data) {
+            printf("Granular: PSRAM allocation failed\n");
+        }
+        registerPort(in, PORT_AIN, "IN", "record input");
+        registerPort(gate, PORT_DIN, "GATE", "grains are spawned while high");
+        registerPort(posMod, PORT_AIN, "POSITION", "position offset, Q15");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
+        registerParam(&position, PARAM_INT, "Position", "Q15 of the buffer");
+        registerParam(&sizeMs, PARAM_INT, "Size", "grain length (ms)");
+        registerParam(&density, PARAM_INT, "Density", "grains per second");
+        registerParam(&pitch, PARAM_INT, "Pitch", "cents, -2400 ~ 2400");
+        registerParam(&spray, PARAM_INT, "Spray", "random start offset, Q15");
+        registerParam(&window, PARAM_INT, "Window", "0:hann 1:tukey 2:expodec");
+        registerParam(&record, PARAM_INT, "Record", "1: write IN into the buffer");
+        printf("Granular Start\n");
+    }
+    void stop() {
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        delete buffer;
+        buffer = nullptr;
+        active = 0;
+        printf("Granular Stop\n");
+    }
+
+    // 任意非音频线程调用: 读入整段采样 (超出缓冲的部分截断), 音频线程在块边界切换
+    bool loadBuffer(const char* spec) {
+        SampleSource* source = createSampleSource(spec);
+        if (!source->open()) {
+            delete source;
+            return false;
+        }
+        GrainBuffer* b = new GrainBuffer();
+        if (!b->data) {
+            printf("Granular: PSRAM allocation failed\n");
+            delete b;
+            delete source;
+            return false;
+        }
+        size_t frames = source->frames();
+        if (frames > GRAIN_BUFFER_FRAMES) frames = GRAIN_BUFFER_FRAMES;
+        b->frames = source->read(0, b->data, frames);
+        delete source;
+        printf("Granular: %s loaded, %u frames\n", spec, (unsigned)b->frames);
+        delete pending.exchange(b, std::memory_order_acq_rel);
+        delete retired.exchange(nullptr, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void process() {
+        // retired 被释放之前不切换, 保证音频线程不持有已释放的缓冲
+        if (!retired.load(std::memory_order_acquire)) {
+            GrainBuffer* loaded = pending.exchange(nullptr, std::memory_order_acquire);
+            if (loaded) {
+                retired.store(buffer, std::memory_order_release);
+                buffer = loaded;
+                writePos = loaded->frames & GRAIN_BUFFER_MASK;
+                active = 0;
+            }
+        }
+        if (!buffer || !buffer->data) {
+            memset(out, 0, sizeof(out));
+            return;
+        }
+        if (record) writeInput();
+
+        memset(acc, 0, sizeof(acc));
+        if (buffer->frames > 0) {
+            updateGrainParams();
+            spawnGrains();
+            mixGrains();
+        } else {
+            active = 0;
+        }
+        Dsp::saturate(acc, 15, out, AUDIO_BLOCK_SIZE);
+    }
+
+    int activeGrains() const {
+        return active;
+    }
+
+    // 当前缓冲的有效长度 (帧)
+    size_t bufferFrames() const {
+        return buffer ? buffer->frames : 0;
+    }
+
+    void printProfileDetail() {
+        printf("    grains: %d active, peak %d, %lu spawned, %lu skipped, buffer %u frames\n", active, peakActive,
+               (unsigned long)spawned, (unsigned long)skipped, (unsigned)bufferFrames());
+    }
+    void resetProfile() {
+        Module_t::resetProfile();
+        spawned = skipped = 0;
+        peakActive = active;
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    static int16_t windows[GRAIN_WINDOWS][1 << GRAIN_WINDOW_BITS];
+    static bool ready;
+
+    static void initTables() {
+        if (ready) return;
+        const int n = 1 << GRAIN_WINDOW_BITS;
+        for (int i = 0; i < n; i++) {
+            float x = (i + 0.5f) / n;
+            float hann = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * x);
+            float edge = x < 0.25f ? x / 0.25f : (x > 0.75f ? (1.0f - x) / 0.25f : 1.0f);
+            float tukey = 0.5f - 0.5f * cosf((float)M_PI * edge);
+            float attack = x < 0.02f ? x / 0.02f : 1.0f;
+            float expodec = attack * expf(-5.0f * x) * (1.0f - x);
+            windows[GRAIN_WINDOW_HANN][i] = (int16_t)lrintf(hann * 32767);
+            windows[GRAIN_WINDOW_TUKEY][i] = (int16_t)lrintf(tukey * 32767);
+            windows[GRAIN_WINDOW_EXPODEC][i] = (int16_t)lrintf(expodec * 32767);
+        }
+        ready = true;
+    }
+
+    GrainBuffer* buffer = nullptr;
+    std::atomic<GrainBuffer*> pending{nullptr};
+    std::atomic<GrainBuffer*> retired{nullptr};
+    uint32_t writePos = 0;
+
+    // 颗粒状态 (SoA), 只有 [0, active) 有效
+    uint32_t grainPos[GRAIN_MAX];       // 18.14 读位置
+    uint32_t grainInc[GRAIN_MAX];       // Q14 每采样步进
+    uint32_t grainPhase[GRAIN_MAX];     // 窗相位, 走完 2^32 结束
+    uint32_t grainPhaseInc[GRAIN_MAX];
+    uint8_t grainDelay[GRAIN_MAX];      // 首块中的起始采样
+    uint8_t grainWindow[GRAIN_MAX];
+    int active = 0;
+
+    // 当前块的颗粒参数
+    uint32_t grainLength = 0;
+    uint32_t pitchInc = 1 << GRAIN_POS_FRAC;
+    int16_t normGain = 32767;
+    int builtPitch = 1 << 30;
+    uint64_t nextSpawn = 0;             // Q16 采样, 相对本块起点
+    uint32_t rng = 0x9E3779B9;
+
+    DSP_ALIGN int32_t acc[AUDIO_BLOCK_SIZE];
+    DSP_ALIGN int16_t grainOut[AUDIO_BLOCK_SIZE];
+    int16_t fetch[GRAIN_FETCH];
+
+    void writeInput() {
+        uint32_t first = GRAIN_BUFFER_FRAMES - writePos;
+        if (first >= AUDIO_BLOCK_SIZE) {
+            memcpy(buffer->data + writePos, in, sizeof(in));
+        } else {
+            memcpy(buffer->data + writePos, in, first * sizeof(int16_t));
+            memcpy(buffer->data, in + first, (AUDIO_BLOCK_SIZE - first) * sizeof(int16_t));
+        }
+        writePos = (writePos + AUDIO_BLOCK_SIZE) & GRAIN_BUFFER_MASK;
+        // 载入的采样长度不一定是块长的整数倍, 增长到缓冲长度为止
+        size_t frames = buffer->frames + AUDIO_BLOCK_SIZE;
+        buffer->frames = frames < GRAIN_BUFFER_FRAMES ? frames : GRAIN_BUFFER_FRAMES;
+    }
+
+    uint32_t nextRandom() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    void updateGrainParams() {
+        int ms = sizeMs < 1 ? 1 : (sizeMs > 2000 ? 2000 : sizeMs);
+        grainLength = (uint32_t)((uint64_t)ms * sampleRate / 1000);
+        if (grainLength < 16) grainLength = 16;
+        if (pitch != builtPitch) {
+            builtPitch = pitch;
+            int cents = pitch < -2400 ? -2400 : (pitch > 2400 ? 2400 : pitch);
+            pitchInc = (uint32_t)lrintf(exp2f(cents / 1200.0f) * (1 << GRAIN_POS_FRAC));
+        }
+        // 不相关颗粒叠加按平均重叠数的平方根归一
+        float overlap = (float)(density < 0 ? 0 : density) * ms / 1000.0f;
+        normGain = overlap > 1.0f ? (int16_t)(32767 / sqrtf(overlap)) : 32767;
+    }
+
+    void spawnGrains() {
+        int d = density < 1 ? 1 : (density > 2000 ? 2000 : density);
+        uint64_t interval = ((uint64_t)sampleRate << 16) / d;
+        const uint64_t blockEnd = (uint64_t)AUDIO_BLOCK_SIZE << 16;
+        // 密度调高时不必等完旧的间隔
+        if (nextSpawn > interval) nextSpawn = interval;
+        while (nextSpawn < blockEnd) {
+            int offset = (int)(nextSpawn >> 16);
+            nextSpawn += interval;
+            if (!gate[offset]) continue;
+            if (active >= GRAIN_MAX) {
+                skipped++;
+                continue;
+            }
+            spawn(offset);
+        }
+        nextSpawn -= blockEnd;
+    }
+
+    void spawn(int offset) {
+        uint32_t frames = buffer->frames;
+        uint32_t span = (uint32_t)(((uint64_t)grainLength * pitchInc) >> GRAIN_POS_FRAC);
+        int32_t pos = position + posMod[offset];
+        pos = pos < 0 ? 0 : (pos > 32767 ? 32767 : pos);
+        int32_t jitter = (int32_t)(((int64_t)(int16_t)nextRandom() * (spray < 0 ? 0 : (spray > 32767 ? 32767 : spray))) >> 15);
+        int64_t start;
+        if (record) {
+            // 读取始终落后于写位置: 0 为最近的一段, 随机偏移只向过去
+            uint32_t usable = frames > span ? frames - span : 0;
+            int64_t back = span + (((int64_t)pos * usable) >> 15) + ((int64_t)(jitter < 0 ? -jitter : jitter) * usable >> 15);
+            start = (int64_t)writePos - AUDIO_BLOCK_SIZE + offset - back;
+        } else {
+            start = (((int64_t)pos + jitter) * frames) >> 15;
+        }
+        int g = active++;
+        grainPos[g] = wrapFrame(start) << GRAIN_POS_FRAC;
+        grainInc[g] = pitchInc;
+        grainPhase[g] = 0;
+        grainPhaseInc[g] = (uint32_t)((0x100000000ull + grainLength - 1) / grainLength);
+        grainDelay[g] = offset;
+        grainWindow[g] = window < 0 || window >= GRAIN_WINDOWS ? GRAIN_WINDOW_HANN : window;
+        spawned++;
+        if (active > peakActive) peakActive = active;
+    }
+
+    // 读位置按有效长度回绕, 短于整个缓冲的采样不会读到后面的空白
+    uint32_t wrapFrame(int64_t frame) const {
+        int64_t frames = buffer->frames;
+        frame %= frames;
+        return (uint32_t)(frame < 0 ? frame + frames : frame);
+    }
+
+    // 从 first (< frames) 起连续取回 count 帧, 跨越有效长度的末尾时回到 0
+    void fetchFrames(uint32_t first, int count) {
+        uint32_t frames = buffer->frames;
+        int done = 0;
+        while (done < count) {
+            int n = (int)(frames - first);
+            if (n > count - done) n = count - done;
+            memcpy(fetch + done, buffer->data + first, n * sizeof(int16_t));
+            done += n;
+            first = 0;
+        }
+    }
+
+    void mixGrains() {
+        const int windowShift = 32 - GRAIN_WINDOW_BITS;
+        const uint32_t fracMask = (1 << GRAIN_POS_FRAC) - 1;
+        for (int g = 0; g < active; g++) {
+            int from = grainDelay[g];
+            grainDelay[g] = 0;
+            uint32_t phase = grainPhase[g];
+            uint32_t phaseInc = grainPhaseInc[g];
+            uint32_t remaining = (uint32_t)((0x100000000ull - phase + phaseInc - 1) / phaseInc);
+            int n = AUDIO_BLOCK_SIZE - from;
+            if ((uint32_t)n > remaining) n = remaining;
+
+            uint32_t pos = grainPos[g];
+            uint32_t inc = grainInc[g];
+            uint32_t frac = pos & fracMask;
+            fetchFrames(pos >> GRAIN_POS_FRAC, (int)(((frac + (uint32_t)(n - 1) * inc) >> GRAIN_POS_FRAC) + 2));
+
+            const int16_t* w = windows[grainWindow[g]];
+            if (from) memset(grainOut, 0, from * sizeof(int16_t));
+            uint32_t p = frac;
+            for (int i = 0; i < n; i++) {
+                int idx = p >> GRAIN_POS_FRAC;
+                int32_t f = p & fracMask;
+                int32_t s = fetch[idx] + (((fetch[idx + 1] - fetch[idx]) * f) >> GRAIN_POS_FRAC);
+                grainOut[from + i] = (int16_t)((s * w[phase >> windowShift]) >> 15);
+                p += inc;
+                phase += phaseInc;
+            }
+            if (from + n < AUDIO_BLOCK_SIZE) memset(grainOut + from + n, 0, (AUDIO_BLOCK_SIZE - from - n) * sizeof(int16_t));
+            Dsp::mac32(grainOut, normGain, acc, AUDIO_BLOCK_SIZE);
+
+            if ((uint32_t)n == remaining) {
+                // 结束: 用最后一个颗粒填补空位, 保持紧凑
+                active--;
+                grainPos[g] = grainPos[active];
+                grainInc[g] = grainInc[active];
+                grainPhase[g] = grainPhase[active];
+                grainPhaseInc[g] = grainPhaseInc[active];
+                grainDelay[g] = grainDelay[active];
+                grainWindow[g] = grainWindow[active];
+                g--;
+            } else {
+                uint64_t next = (uint64_t)pos + (uint64_t)n * inc;
+                grainPos[g] = (wrapFrame((int64_t)(next >> GRAIN_POS_FRAC)) << GRAIN_POS_FRAC) | (uint32_t)(next & fracMask);
+                grainPhase[g] = phase;
+            }
+        }
+    }
+};
+
+int16_t GranularModule::windows[GRAIN_WINDOWS][1 << GRAIN_WINDOW_BITS];
+bool GranularModule::ready = false;
+
+// 满载 (64 个颗粒) 时的耗时, 换算为单核可承载的颗粒数
+inline void benchGranular(uint32_t blocks) {
+    struct Case {
+        const char* name;
+        int pitch;
+    } cases[] = {
+        {"granular 64 grains", 0},
+        {"granular 64 grains +12", 1200},
+        {"granular 64 grains -12", -1200},
+    };
+    for (const Case& c : cases) {
+        GranularModule* m = new GranularModule();
+        m->start();
+        // 先录入一段锯齿波填满缓冲
+        m->record = 1;
+        for (uint32_t b = 0; b < GRAIN_BUFFER_FRAMES / AUDIO_BLOCK_SIZE; b++) {
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m->in[i] = (int16_t)((b * AUDIO_BLOCK_SIZE + i) * 373);
+            }
+            m->process();
+        }
+        m->record = 0;
+        m->sizeMs = 200;
+        m->density = 400;
+        m->spray = 16384;
+        m->pitch = c.pitch;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            m->gate[i] = 1;
+        }
+        // 颗粒数达到上限后再计时
+        for (int b = 0; b < 1024 && m->activeGrains() < GRAIN_MAX; b++) {
+            m->process();
+        }
+        uint64_t grainSum = 0;
+        bench_result_t r = benchRun(c.name, blocks, AUDIO_BLOCK_SIZE, [&]() {
+            m->process();
+            grainSum += m->activeGrains();
+        });
+        benchPrint(r);
+        double grains = (double)grainSum / (blocks + 1);
+        double nsPerGrain = r.totalUs * 1000.0 / ((double)blocks * AUDIO_BLOCK_SIZE) / (grains > 0 ? grains : 1);
+        printf("%-24s %8.2f ns/grain-smp, %.1f grains avg, ~%d grains per core\n", "", nsPerGrain, grains,
+               (int)(1e9 / SMP_RATE / nsPerGrain));
+        m->stop();
+        delete m;
+    }
+}
+
+#endif
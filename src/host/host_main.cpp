@@ -0,0 +1,171 @@
+// 主机端入口 (pio run -e native), 不依赖 Arduino/FreeRTOS
+// 用法:
+//   program [wav|null|pipe] [seconds]   渲染 440 Hz 带限锯齿波到指定后端
+//   program bench [blocks]              测量各后端吞吐量与模块耗时
+//   program wtconvert in.wav out.wt [frameSize]  生成带八度层的波表文件 (默认 2048 点/帧)
+//   program midi <pty | fifo | file> [seconds] [wav|null]  按实时节拍用 MIDI 输入演奏, 报告调度延迟与抖动
+// 例: program pipe 5 | aplay -f S16_LE -c 1 -r 44100
+// 单元测试 (pio test -e native) 链接 src 时由测试提供 main(), 跳过整个主机程序
+#ifndef PIO_UNIT_TESTING
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../connect_manager.hpp"
+#include "../audio_out.h"
+#include "../audio_health.h"
+#include "../blep_osc.h"
+#include "../resampler.h"
+#include "../dsp_kernels.h"
+#include "../filter.h"
+#include "../envelope.h"
+#include "../mixer.h"
+#include "../noise.h"
+#include "../reverb.h"
+#include "../convolver.h"
+#include "../wavetable.h"
+#include "../granular.h"
+#include "../fm_synth.h"
+#include "../sequencer.h"
+#include "../scope.h"
+#include "../midi_input.h"
+#include "../touch_keys.h"
+#include "../note_fx.h"
+#include "../keypad_input.h"
+#include "wavetable_convert.h"
+
+ConnectionManager manager;
+
+static int findBackend(const char* name) {
+    for (int i = 0; i < AUDIO_BACKEND_COUNT; i++) {
+        if (strcmp(name, audio_backend_name[i]) == 0) return i;
+    }
+    return -1;
+}
+
+// midi in -> blep osc -> 输出; 引擎按块周期休眠, 模拟 I2S 的节拍, 使到达时间与采样时钟对应
+static int runMidi(const char* path, float seconds, int backendType) {
+    if (!midi_input.beginFile(path)) return 1;
+    manager.module_manager.registerModule<MidiInModule>();
+    manager.module_manager.registerModule<BlepOsc>();
+    manager.module_manager.registerModule<i2s_audio_out>();
+    manager.createModule("midi in");
+    manager.createModule("blep osc");
+    manager.createModule("ESP32 I2S Audio Out");
+    manager.connect(0, 1, 1, 2);
+    manager.connect(0, 2, 1, 0);
+    manager.connect(1, 0, 2, 0);
+    static_cast<i2s_audio_out*>(manager.modules[2])->backendType = backendType;
+
+    long blocks = (long)(seconds * SMP_RATE / AUDIO_BLOCK_SIZE);
+    int64_t origin = esp_timer_get_time();
+    for (long b = 0; b < blocks; b++) {
+        int64_t due = origin + (int64_t)b * AUDIO_BLOCK_SIZE * 1000000 / SMP_RATE;
+        int64_t now = esp_timer_get_time();
+        if (due > now) usleep(due - now);
+        audio_health.beginBlock();
+        audio_clock.beginBlock();
+        manager.process_all();
+        audio_health.endBlock();
+    }
+    midi_input.end();
+    manager.printProfile();
+    printf("MIDI received %lu, dropped %lu\n", (unsigned long)midi_input.received, (unsigned long)midi_input.dropped);
+    manager.releaseModule(2);
+    manager.releaseModule(1);
+    manager.releaseModule(0);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* mode = argc > 1 ? argv[1] : "null";
+
+    if (strcmp(mode, "bench") == 0) {
+        uint32_t blocks = argc > 2 ? strtol(argv[2], NULL, 0) : 65536;
+        benchAudioBackends(blocks);
+        benchResampler(blocks / 16);
+        benchOscillators(blocks / 16);
+        benchFilters(blocks / 16);
+        benchEnvelope(blocks);
+        benchMixer(blocks / 16);
+        benchNoise(blocks);
+        benchDelayReverb(blocks / 16);
+        benchConvolver(blocks / 16);
+        benchWavetable(blocks / 16);
+        benchGranular(blocks / 16);
+        benchFm(blocks / 16);
+        benchSequencer(blocks);
+        benchViews(blocks / 16);
+        benchMasterLimiter(blocks);
+        benchTouchKeys(blocks);
+        benchKeypad(blocks);
+        benchNoteFx(blocks);
+        benchDspKernels(blocks);
+        return 0;
+    }
+
+    if (strcmp(mode, "wtconvert") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "Usage: %s wtconvert in.wav out.wt [frameSize]\n", argv[0]);
+            return 1;
+        }
+        return convertWavetable(argv[2], argv[3], argc > 4 ? strtol(argv[4], NULL, 0) : WT_MAX_FRAME_SIZE);
+    }
+
+    if (strcmp(mode, "midi") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: %s midi <pty | fifo | file> [seconds] [wav|null]\n", argv[0]);
+            return 1;
+        }
+        int backendType = argc > 4 ? findBackend(argv[4]) : AUDIO_BACKEND_NULL;
+        if (backendType != AUDIO_BACKEND_WAV && backendType != AUDIO_BACKEND_NULL) {
+            fprintf(stderr, "Unsupported backend for midi mode\n");
+            return 1;
+        }
+        return runMidi(argv[2], argc > 3 ? strtof(argv[3], NULL) : 5.0f, backendType);
+    }
+
+    int backendType = findBackend(mode);
+    if (backendType < 0 || backendType == AUDIO_BACKEND_I2S) {
+        fprintf(stderr, "Unknown or unsupported backend: %s\n", mode);
+        return 1;
+    }
+    float seconds = argc > 2 ? strtof(argv[2], NULL) : 2.0f;
+
+    // pipe 模式下 stdout 只输出 PCM, 日志转到 stderr
+    if (backendType == AUDIO_BACKEND_PIPE) {
+        audio_pipe_stream = fdopen(dup(STDOUT_FILENO), "wb");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+
+    manager.module_manager.registerModule<BlepOsc>();
+    manager.module_manager.registerModule<i2s_audio_out>();
+    manager.createModule("blep osc");
+    manager.createModule("ESP32 I2S Audio Out");
+    manager.connect(0, 0, 1, 0);
+
+    i2s_audio_out* out = static_cast<i2s_audio_out*>(manager.modules[1]);
+    out->backendType = backendType;
+
+    port_t& freq = manager.getInputPort(0, 0);
+    port_t& gate = manager.getInputPort(0, 2);
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        freq.data[i] = 440;
+        gate.data[i] = 1;
+    }
+
+    long blocks = (long)(seconds * SMP_RATE / AUDIO_BLOCK_SIZE);
+    for (long b = 0; b < blocks; b++) {
+        audio_health.beginBlock();
+        audio_clock.beginBlock();
+        manager.process_all();
+        audio_health.endBlock();
+    }
+
+    manager.releaseModule(1);
+    manager.releaseModule(0);
+    audio_health.printStatus();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef WAVETABLE_CONVERT_H
+#define WAVETABLE_CONVERT_H
+
+// 主机端波表转换: 单声道 16 位 WAV (首尾相接的单周期帧) -> 带八度层的波表文件
+// 每帧做一次 FFT, 各层去掉直流与超出该层谐波上限的分量后按层长逆变换
+#include <stdio.h>
+#include <math.h>
+#include <complex>
+#include <vector>
+#include "../wavetable.h"
+
+typedef std::complex<float> wt_complex_t;
+
+// 原位基 2 FFT, inverse 时不做 1/N 归一化
+static void wtFft(std::vector<wt_complex_t>& x, bool inverse) {
+    size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        float a = 2.0f * (float)M_PI / len * (inverse ? 1 : -1);
+        wt_complex_t w(cosf(a), sinf(a));
+        for (size_t i = 0; i < n; i += len) {
+            wt_complex_t wk(1, 0);
+            for (size_t k = 0; k < len / 2; k++) {
+                wt_complex_t u = x[i + k], v = x[i + k + len / 2] * wk;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                wk *= w;
+            }
+        }
+    }
+}
+
+static int convertWavetable(const char* inPath, const char* outPath, int frameSize) {
+    if (!WavetableData::validFrameSize(frameSize)) {
+        fprintf(stderr, "Frame size must be a power of two in %d ~ %d\n", WT_MIN_FRAME_SIZE, WT_MAX_FRAME_SIZE);
+        return 1;
+    }
+    MmapSampleSource source(inPath);
+    if (!source.open()) return 1;
+    int frames = source.frames() / frameSize;
+    if (frames < 1) {
+        fprintf(stderr, "%s is shorter than one frame\n", inPath);
+        return 1;
+    }
+    if (frames > WT_MAX_FRAMES) {
+        fprintf(stderr, "Using first %d of %d frames\n", WT_MAX_FRAMES, frames);
+        frames = WT_MAX_FRAMES;
+    }
+
+    int levels = WavetableData::levelCount(frameSize);
+    std::vector<std::vector<float>> data(levels);
+    std::vector<int16_t> pcm(frameSize);
+    std::vector<wt_complex_t> spectrum(frameSize);
+    float peak = 0;
+    for (int f = 0; f < frames; f++) {
+        source.read((size_t)f * frameSize, pcm.data(), frameSize);
+        for (int n = 0; n < frameSize; n++) {
+            spectrum[n] = wt_complex_t(pcm[n], 0);
+        }
+        wtFft(spectrum, false);
+        for (int l = 0; l < levels; l++) {
+            int len = WavetableData::levelLength(frameSize, l);
+            int harmonics = WavetableData::levelHarmonics(frameSize, l);
+            std::vector<wt_complex_t> bins(len);
+            for (int k = 1; k <= harmonics && k <= len / 2; k++) {
+                wt_complex_t c = spectrum[k] / (float)frameSize;
+                if (k == len / 2) {
+                    bins[k] = c.real();
+                } else {
+                    bins[k] = c;
+                    bins[len - k] = std::conj(c);
+                }
+            }
+            wtFft(bins, true);
+            for (int n = 0; n < len; n++) {
+                float y = bins[n].real();
+                data[l].push_back(y);
+                if (fabsf(y) > peak) peak = fabsf(y);
+            }
+        }
+    }
+
+    // 只在去掉高次谐波后的过冲超出范围时整体缩小, 各层使用同一增益
+    float scale = peak > 32767.0f ? 32767.0f / peak : 1.0f;
+    FILE* out = fopen(outPath, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot write %s\n", outPath);
+        return 1;
+    }
+    uint16_t header[WT_HEADER_WORDS] = {0, 0, (uint16_t)frameSize, (uint16_t)frames, (uint16_t)levels};
+    memcpy(header, "WTBL", 4);
+    fwrite(header, sizeof(header), 1, out);
+    size_t bytes = sizeof(header);
+    for (int l = 0; l < levels; l++) {
+        for (float y : data[l]) {
+            int16_t s = (int16_t)lrintf(y * scale);
+            fwrite(&s, sizeof(s), 1, out);
+            bytes += sizeof(s);
+        }
+    }
+    fclose(out);
+    fprintf(stderr, "%s: %d frames x %d, %d levels, %u bytes, gain %.3f\n", outPath, frames, frameSize, levels, (unsigned)bytes, scale);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef KEY_EVENT_H
+#define KEY_EVENT_H
+
+#include <stdint.h>
+
+// 按键事件状态枚举
+typedef enum {
+    KEY_IDLE,
+    KEY_ATTACK,
+    KEY_RELEASE,
+    KEY_LONG_PRESS,     // 按住超过长按时间, 每次按下只发一次
+    KEY_REPEAT,         // 长按后按固定间隔重复
+    KEY_CHORD           // 已有其他键按住时按下, mask 为此时按住的全部键
+} key_status_t;
+
+// 按键事件结构
+typedef struct {
+    uint8_t num;         // 按键编号
+    key_status_t status; // 按键状态
+    uint16_t mask;       // 事件发生时按住的键 (位图)
+    int64_t us;          // 事件时间 (esp_timer), 用于统计输入到画面的延迟
+} key_event_t;
+
+#endif
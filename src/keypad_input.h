@@ -0,0 +1,159 @@
+#ifndef KEYPAD_INPUT_H
+#define KEYPAD_INPUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "key_event.h"
+#include "bench.h"
+#include "platform_compat.h"
+
+#ifdef ESP_PLATFORM
+#include <Adafruit_Keypad.h>
+#include "WindowManager.h"
+#endif
+
+#define KEYPAD_KEYS 12
+#define KEYPAD_SCAN_MS 4            // 扫描周期
+#define KEYPAD_LONG_PRESS_MS 500
+#define KEYPAD_REPEAT_MS 100        // 长按之后的重复间隔
+
+// 由按住的键位图生成按键事件: 按下 / 松开 / 长按 / 重复 / 和弦
+// 与扫描方式无关, 每个扫描周期调用一次 update()
+class KeyEventGenerator {
+public:
+    // 生成的事件交给 sink(const key_event_t&), 返回生成数量
+    template<typename F>
+    int update(uint16_t held, int64_t nowUs, F&& sink) {
+        int count = 0;
+        uint16_t pressed = held & ~last;
+        uint16_t released = last & ~held;
+        while (released) {
+            int k = __builtin_ctz(released);
+            released &= released - 1;
+            sink(key_event_t{(uint8_t)k, KEY_RELEASE, held, nowUs});
+            count++;
+        }
+        while (pressed) {
+            int k = __builtin_ctz(pressed);
+            pressed &= pressed - 1;
+            // 已有其他键按住时为和弦; 同一次扫描里同时按下的键按顺序逐个计入
+            uint16_t others = (last | (held & ((1u << k) - 1) & ~last)) & ~(1u << k);
+            sink(key_event_t{(uint8_t)k, others ? KEY_CHORD : KEY_ATTACK, held, nowUs});
+            nextUs[k] = nowUs + KEYPAD_LONG_PRESS_MS * 1000;
+            longSent &= ~(1u << k);
+            count++;
+        }
+        // 只有单键按住时才产生长按与重复, 和弦不重复
+        if (held && !(held & (held - 1))) {
+            int k = __builtin_ctz(held);
+            // 和弦松开到只剩一个键: 从此刻重新计长按, 否则按住期间落下的时间会一次补发
+            if (last & (last - 1)) {
+                nextUs[k] = nowUs + KEYPAD_LONG_PRESS_MS * 1000;
+            }
+            if (nowUs >= nextUs[k]) {
+                bool first = !(longSent & (1u << k));
+                sink(key_event_t{(uint8_t)k, first ? KEY_LONG_PRESS : KEY_REPEAT, held, nowUs});
+                longSent |= 1u << k;
+                // 扫描迟到时不补发, 下一次重复至少在一个间隔之后
+                int64_t next = nextUs[k] + KEYPAD_REPEAT_MS * 1000;
+                nextUs[k] = next > nowUs + KEYPAD_REPEAT_MS * 1000 ? next : nowUs + KEYPAD_REPEAT_MS * 1000;
+                count++;
+            }
+        }
+        last = held;
+        return count;
+    }
+
+    uint16_t heldKeys() const {
+        return last;
+    }
+
+private:
+    uint16_t last = 0;
+    uint16_t longSent = 0;
+    int64_t nextUs[KEYPAD_KEYS] = {};
+};
+
+// 键盘矩阵输入: 固定周期的扫描任务调用 keypad.tick(), 生成的事件经无锁缓冲交给窗口管理器,
+// 扫描线程从不等待显示线程
+class KeypadInput {
+public:
+    KeyEventGenerator generator;
+
+    // 扫描耗时 (tick + 事件生成)
+    uint32_t scans = 0;
+    uint64_t scanTicks = 0;
+    uint32_t scanPeak = 0;
+    uint32_t events = 0;
+
+    void printStats() {
+        printf("Keypad: %lu scans, scan avg %.1fus peak %.1fus, %lu events\n", (unsigned long)scans,
+               scans ? (float)scanTicks / scans / PERF_TICKS_PER_US : 0.0f, (float)scanPeak / PERF_TICKS_PER_US,
+               (unsigned long)events);
+    }
+
+#ifdef ESP_PLATFORM
+    void begin(Adafruit_Keypad* pad, WindowManager* manager) {
+        keypad = pad;
+        windows = manager;
+        keypad->begin();
+        xTaskCreatePinnedToCore(scanTask, "Keypad", 3072, this, 3, NULL, 1);
+    }
+
+private:
+    Adafruit_Keypad* keypad = nullptr;
+    WindowManager* windows = nullptr;
+    uint16_t held = 0;
+
+    static void scanTask(void* arg) {
+        KeypadInput* self = (KeypadInput*)arg;
+        TickType_t wake = xTaskGetTickCount();
+        for (;;) {
+            uint32_t t0 = perf_ticks();
+            self->scan();
+            uint32_t t = perf_ticks() - t0;
+            self->scans++;
+            self->scanTicks += t;
+            if (t > self->scanPeak) self->scanPeak = t;
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(KEYPAD_SCAN_MS));
+        }
+    }
+
+    void scan() {
+        keypad->tick();
+        while (keypad->available()) {
+            keypadEvent e = keypad->read();
+            if (e.bit.KEY >= KEYPAD_KEYS) continue;
+            if (e.bit.EVENT == KEY_JUST_PRESSED) {
+                held |= 1u << e.bit.KEY;
+            } else if (e.bit.EVENT == KEY_JUST_RELEASED) {
+                held &= ~(1u << e.bit.KEY);
+            }
+        }
+        events += generator.update(held, esp_timer_get_time(), [this](const key_event_t& e) {
+            windows->postKeyEvent(e);
+        });
+    }
+#endif
+};
+
+KeypadInput keypad_input;
+
+// 事件生成的耗时: 合成的按下 / 按住 / 松开序列
+inline void benchKeypad(uint32_t scans) {
+    KeyEventGenerator generator;
+    uint32_t n = 0, events = 0;
+    int64_t us = 0;
+    bench_result_t r = benchRun("keypad event generator", scans, 1, [&]() {
+        // 每 256 次扫描: 按下一个键, 按住 (长按与重复), 再加一个键成和弦, 全部松开
+        uint32_t phase = n & 255;
+        uint16_t held = phase < 224 ? 1u << ((n >> 8) % KEYPAD_KEYS) : 0;
+        if (phase >= 200 && phase < 224) held |= 1u << ((((n >> 8) + 1) % KEYPAD_KEYS));
+        events += generator.update(held, us, [](const key_event_t&) {});
+        us += KEYPAD_SCAN_MS * 1000;
+        n++;
+    });
+    printf("%-24s %8.1f ns/scan (%lu events)\n", r.name, r.totalUs * 1000.0 / r.iterations, (unsigned long)events);
+}
+
+#endif
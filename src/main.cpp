@@ -4,18 +4,43 @@
 #include "SerialTerminal.h"
 #include "Adafruit_SSD1306.h"
 #include "connect_manager.hpp"
+#include "dsp_kernels.h"
 // #include "note_input.h"
 #include "audio_out.h"
+#include "audio_health.h"
 #include "simple_osc.h"
+#include "blep_osc.h"
+#include "oversampler.h"
+#include "resampler.h"
+#include "filter.h"
+#include "envelope.h"
+#include "mixer.h"
+#include "noise.h"
+#include "delay.h"
+#include "reverb.h"
+#include "wavetable.h"
+#include "fm_synth.h"
+#include "sequencer.h"
+#include "scope.h"
+#include "midi_input.h"
+#include "touch_keys.h"
+#include "note_fx.h"
+#include "sample_player.h"
+#include "granular.h"
+#include "convolver.h"
 
 #include "WindowManager.h"
 
+#include "keypad_input.h"
+
 #include "font3x5.h"
 
 #include "font4x5.h"
 
 #include <Adafruit_Keypad.h>
 
+#include <SPIFFS.h>
+
 #include "Adafruit_MPR121.h"
 
 #include "Adafruit_SSD1322.h"
@@ -50,7 +75,7 @@ const uint8_t colPins[COLS] = {38, 39, 48};
 
 Adafruit_Keypad keypad = Adafruit_Keypad(makeKeymap(key_map), (uint8_t*)rowPins, (uint8_t*)colPins, ROWS, COLS);
 
-Adafruit_SSD1306 display(128, 64, &SPI, 7, 15, 6, 10000000);
+RegionSSD1306 display(128, 64, &SPI, 7, 15, 6, 10000000);
 
 Adafruit_MPR121 touchPad0;
 Adafruit_MPR121 touchPad1;
@@ -58,59 +83,23 @@ Adafruit_MPR121 touchPad1;
 WindowManager window_manager(&display);
 ConnectionManager manager;
 
-class TestModule: public Module_t {
-public:
-    TestModule() { module_info = {"noise generator", "libchara-dev", "A simple noise generator", false, false}; }
-    int16_t out;
-
-    uint16_t lfsr = 0xACE1u;
-    unsigned period = 0;
-
-    int16_t generate_noise() {
-        unsigned lsb = lfsr & 1;
-        lfsr >>= 1;
-        if (lsb) {
-            lfsr ^= 0xB400u;
-        }
-        return lfsr;
-    }
-
-    void start() {
-        registerPort(&out, PORT_AOUT, "OUTPUT", "noise generator output");
-        printf("NoiseStart\n");
-    }
-    void stop() {
-        printf("NoiseStop\n");
-    }
-    void process() {
-        out = generate_noise();
-    }
-    void customSettingPage() {
-
-    }
-    void customViewPage() {
-
-    }
-    ~TestModule() {
-        printf("Releasing resources for %s\n", module_info.name);
-    }
-};
-
 class VolCtrl: public Module_t {
 public:
     VolCtrl() { module_info = {"volume control", "libchara-dev", "A simple volume control", false, false}; }
-    int16_t out;
-    int16_t in;
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int volume = 655; // Q15, 约 0.02
     void start() {
-        registerPort(&out, PORT_AOUT, "OUTPUT", "volume control output");
-        registerPort(&in, PORT_AIN, "INPUT", "volume control input");
+        registerPort(out, PORT_AOUT, "OUTPUT", "volume control output");
+        registerPort(in, PORT_AIN, "INPUT", "volume control input");
+        registerParam(&volume, PARAM_INT, "Volume", "gain, Q15 (32767 = 1.0)");
         printf("VolCtrl Start\n");
     }
     void stop() {
         printf("VolCtrl Start\n");
     }
     void process() {
-        out = in * 0.02;
+        Dsp::gain(in, DspPortable::clampGain(volume), out, AUDIO_BLOCK_SIZE);
     }
     void customSettingPage() {
 
@@ -154,6 +143,236 @@ void get_free_heap_cmd(int argc, const char* argv[]) {
     printf("Free heap size: %ld\n", esp_get_free_heap_size());
 }
 
+void audioHealthCmd(int argc, const char* argv[]) {
+    audio_health.printStatus();
+}
+
+void printXrunsCmd(int argc, const char* argv[]) {
+    audio_health.printXruns();
+}
+
+void resetHealthCmd(int argc, const char* argv[]) {
+    audio_health.reset();
+    printf("Audio health counters cleared\n");
+}
+
+void setParamCmd(int argc, const char* argv[]) {
+    if (argc < 4) {printf("%s <slot> <param index> <value>\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    int index = strtol(argv[2], NULL, 0);
+    if (slot >= manager.getSlotSize() || index < 0 || index >= manager.modules[slot]->paramManager.getParamCount()) {
+        printf("Slot or param index out of range\n");
+        return;
+    }
+    param_t& param = manager.modules[slot]->paramManager.params[index];
+    if (param.type == PARAM_INT) {
+        *(int*)param.data = strtol(argv[3], NULL, 0);
+    } else if (param.type == PARAM_FLOAT) {
+        *(float*)param.data = strtof(argv[3], NULL);
+    } else {
+        printf("Param %s is not a scalar\n", param.name);
+        return;
+    }
+    printf("Module #%d %s = %s\n", (int)slot, param.name, argv[3]);
+}
+
+void printProfileCmd(int argc, const char* argv[]) {
+    manager.printProfile();
+}
+
+void resetProfileCmd(int argc, const char* argv[]) {
+    manager.resetProfile();
+}
+
+void benchAudioBackendCmd(int argc, const char* argv[]) {
+    benchAudioBackends(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void benchResamplerCmd(int argc, const char* argv[]) {
+    benchResampler(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void benchOscCmd(int argc, const char* argv[]) {
+    benchOscillators(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void benchFilterCmd(int argc, const char* argv[]) {
+    benchFilters(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void benchEnvelopeCmd(int argc, const char* argv[]) {
+    benchEnvelope(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void benchMixerCmd(int argc, const char* argv[]) {
+    benchMixer(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+MixerModule* getMixer(const char* slotArg) {
+    size_t slot = strtol(slotArg, NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "mixer") != 0) {
+        printf("Slot %d is not a mixer\n", (int)slot);
+        return nullptr;
+    }
+    return static_cast<MixerModule*>(manager.modules[slot]);
+}
+
+void mixGainCmd(int argc, const char* argv[]) {
+    if (argc < 4) {printf("%s <slot> <channel 1-16> <gain Q12>\n", argv[0]);return;}
+    MixerModule* mixer = getMixer(argv[1]);
+    int ch = strtol(argv[2], NULL, 0) - 1;
+    if (!mixer || ch < 0 || ch >= MIXER_CHANNELS) return;
+    mixer->gain[ch] = strtol(argv[3], NULL, 0);
+    printf("Mixer #%s IN%d gain = %d\n", argv[1], ch + 1, mixer->gain[ch]);
+}
+
+void mixMuteCmd(int argc, const char* argv[]) {
+    if (argc < 4) {printf("%s <slot> <channel 1-16> <0|1>\n", argv[0]);return;}
+    MixerModule* mixer = getMixer(argv[1]);
+    int ch = strtol(argv[2], NULL, 0) - 1;
+    if (!mixer || ch < 0 || ch >= MIXER_CHANNELS) return;
+    mixer->mute[ch] = strtol(argv[3], NULL, 0) != 0;
+    printf("Mixer #%s IN%d %s\n", argv[1], ch + 1, mixer->mute[ch] ? "muted" : "unmuted");
+}
+
+void benchNoiseCmd(int argc, const char* argv[]) {
+    benchNoise(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void benchDelayCmd(int argc, const char* argv[]) {
+    benchDelayReverb(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void loadWavetableCmd(int argc, const char* argv[]) {
+    if (argc < 3) {printf("%s <slot> <file path | partition:label | builtin>\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "wavetable osc") != 0) {
+        printf("Slot %d is not a wavetable osc\n", (int)slot);
+        return;
+    }
+    static_cast<WavetableOsc*>(manager.modules[slot])->loadTable(argv[2]);
+}
+
+void printWavetablesCmd(int argc, const char* argv[]) {
+    WavetableCache::instance().printInfo();
+}
+
+void benchWavetableCmd(int argc, const char* argv[]) {
+    benchWavetable(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void benchFmCmd(int argc, const char* argv[]) {
+    benchFm(argc > 1 ? strtol(argv[1], NULL, 0) : 1024);
+}
+
+void seqStepCmd(int argc, const char* argv[]) {
+    if (argc < 4) {printf("%s <slot> <step 1-16> <note, 0 = rest> [gate %%]\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "sequencer") != 0) {
+        printf("Slot %d is not a sequencer\n", (int)slot);
+        return;
+    }
+    SequencerModule* seq = static_cast<SequencerModule*>(manager.modules[slot]);
+    int step = strtol(argv[2], NULL, 0) - 1;
+    seq->setStep(step, strtol(argv[3], NULL, 0), argc > 4 ? strtol(argv[4], NULL, 0) : 0);
+    printf("Sequencer #%d:", (int)slot);
+    for (int i = 0; i < SEQ_MAX_STEPS; i++) {
+        printf(" %d", (int)(seq->getStep(i) & 0x7F));
+    }
+    printf("\n");
+}
+
+void benchSequencerCmd(int argc, const char* argv[]) {
+    benchSequencer(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void benchViewsCmd(int argc, const char* argv[]) {
+    benchViews(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void touchStatsCmd(int argc, const char* argv[]) {
+    touch_keys.printStats();
+}
+
+void benchTouchCmd(int argc, const char* argv[]) {
+    benchTouchKeys(argc > 1 ? strtol(argv[1], NULL, 0) : 65536);
+}
+
+void keypadStatsCmd(int argc, const char* argv[]) {
+    keypad_input.printStats();
+    window_manager.printInputStats();
+}
+
+void displayStatsCmd(int argc, const char* argv[]) {
+    window_manager.printDisplayStats();
+    window_manager.resetDisplayStats();
+}
+
+void benchKeypadCmd(int argc, const char* argv[]) {
+    benchKeypad(argc > 1 ? strtol(argv[1], NULL, 0) : 65536);
+}
+
+void benchNoteFxCmd(int argc, const char* argv[]) {
+    benchNoteFx(argc > 1 ? strtol(argv[1], NULL, 0) : 16384);
+}
+
+void benchMasterCmd(int argc, const char* argv[]) {
+    benchMasterLimiter(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void benchDspCmd(int argc, const char* argv[]) {
+    benchDspKernels(argc > 1 ? strtol(argv[1], NULL, 0) : 4096);
+}
+
+void loadSampleCmd(int argc, const char* argv[]) {
+    if (argc < 3) {printf("%s <slot> <file path | partition:label>\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "sample player") != 0) {
+        printf("Slot %d is not a sample player\n", (int)slot);
+        return;
+    }
+    static_cast<SamplePlayer*>(manager.modules[slot])->requestLoad(argv[2]);
+}
+
+void loadGrainsCmd(int argc, const char* argv[]) {
+    if (argc < 3) {printf("%s <slot> <file path | partition:label>\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "granular") != 0) {
+        printf("Slot %d is not a granular module\n", (int)slot);
+        return;
+    }
+    static_cast<GranularModule*>(manager.modules[slot])->loadBuffer(argv[2]);
+}
+
+void benchGranularCmd(int argc, const char* argv[]) {
+    benchGranular(argc > 1 ? strtol(argv[1], NULL, 0) : 512);
+}
+
+void loadIrCmd(int argc, const char* argv[]) {
+    if (argc < 3) {printf("%s <slot> <file path | partition:label | builtin>\n", argv[0]);return;}
+    size_t slot = strtol(argv[1], NULL, 0);
+    if (slot >= manager.getSlotSize() || strcmp(manager.modules[slot]->module_info.name, "convolver") != 0) {
+        printf("Slot %d is not a convolver\n", (int)slot);
+        return;
+    }
+    static_cast<ConvolverModule*>(manager.modules[slot])->loadIr(argv[2]);
+}
+
+void benchConvCmd(int argc, const char* argv[]) {
+    benchConvolver(argc > 1 ? strtol(argv[1], NULL, 0) : 256);
+}
+
+// 格式化会清空分区内所有文件, 需要显式确认
+void formatSpiffsCmd(int argc, const char* argv[]) {
+    if (argc < 2 || strcmp(argv[1], "yes") != 0) {printf("%s yes  (erases every file under /spiffs)\n", argv[0]);return;}
+    SPIFFS.end();
+    if (!SPIFFS.format() || !SPIFFS.begin(false)) {
+        printf("SPIFFS format failed\n");
+        return;
+    }
+    printf("SPIFFS formatted, %u bytes free\n", (unsigned)(SPIFFS.totalBytes() - SPIFFS.usedBytes()));
+}
+
 /*
 void testProcessCmd(int argc, const char* argv[]) {
     printf("Test Process:\n");
@@ -177,6 +396,43 @@ void serialDebug(void *arg) {
     terminal.addCommand("printSlotInfo", printSlotInfoCmd);
     terminal.addCommand("printAllModInfo", printAllModInfoCmd);
     terminal.addCommand("get_free_heap", get_free_heap_cmd);
+    terminal.addCommand("audioHealth", audioHealthCmd);
+    terminal.addCommand("printXruns", printXrunsCmd);
+    terminal.addCommand("resetHealth", resetHealthCmd);
+    terminal.addCommand("setParam", setParamCmd);
+    terminal.addCommand("benchAudioBackend", benchAudioBackendCmd);
+    terminal.addCommand("benchResampler", benchResamplerCmd);
+    terminal.addCommand("benchOsc", benchOscCmd);
+    terminal.addCommand("benchFilter", benchFilterCmd);
+    terminal.addCommand("benchEnvelope", benchEnvelopeCmd);
+    terminal.addCommand("benchMixer", benchMixerCmd);
+    terminal.addCommand("mixGain", mixGainCmd);
+    terminal.addCommand("mixMute", mixMuteCmd);
+    terminal.addCommand("benchNoise", benchNoiseCmd);
+    terminal.addCommand("benchDelay", benchDelayCmd);
+    terminal.addCommand("benchWavetable", benchWavetableCmd);
+    terminal.addCommand("benchFm", benchFmCmd);
+    terminal.addCommand("benchSequencer", benchSequencerCmd);
+    terminal.addCommand("seqStep", seqStepCmd);
+    terminal.addCommand("benchViews", benchViewsCmd);
+    terminal.addCommand("benchMaster", benchMasterCmd);
+    terminal.addCommand("touchStats", touchStatsCmd);
+    terminal.addCommand("benchTouch", benchTouchCmd);
+    terminal.addCommand("keypadStats", keypadStatsCmd);
+    terminal.addCommand("benchKeypad", benchKeypadCmd);
+    terminal.addCommand("displayStats", displayStatsCmd);
+    terminal.addCommand("benchNoteFx", benchNoteFxCmd);
+    terminal.addCommand("benchDsp", benchDspCmd);
+    terminal.addCommand("printProfile", printProfileCmd);
+    terminal.addCommand("resetProfile", resetProfileCmd);
+    terminal.addCommand("loadSample", loadSampleCmd);
+    terminal.addCommand("loadGrains", loadGrainsCmd);
+    terminal.addCommand("benchGranular", benchGranularCmd);
+    terminal.addCommand("loadIr", loadIrCmd);
+    terminal.addCommand("benchConv", benchConvCmd);
+    terminal.addCommand("formatSpiffs", formatSpiffsCmd);
+    terminal.addCommand("loadWavetable", loadWavetableCmd);
+    terminal.addCommand("printWavetables", printWavetablesCmd);
     for (;;) {
         terminal.update();
         vTaskDelay(1);
@@ -185,8 +441,14 @@ void serialDebug(void *arg) {
 
 void soundEng(void *arg) {
     for (;;) {
+        audio_health.beginBlock();
+        audio_clock.beginBlock();
         manager.process_all();
-        vTaskDelay(1);
+        audio_health.endBlock();
+        // 没有输出模块时由自身让出 CPU, 否则由 I2S 写入阻塞控制节拍
+        if (!audio_health.blockHadSink()) {
+            vTaskDelay(1);
+        }
     }
 }
 
@@ -197,6 +459,47 @@ void refreshDisplay(void *arg) {
     }
 }
 
+// 音频健康状态窗口
+void drawAudioStatus(Window* window) {
+    window->fillScreen(0);
+    window->drawFastHLine(0, 0, window->getWidth(), 1);
+    window->setTextColor(1);
+    window->setCursor(0, 2);
+    window->printf("XRUN:%lu LATE:%lu\n", (unsigned long)audio_health.underruns, (unsigned long)audio_health.lateBlocks);
+    window->printf("LOAD:%d%% MIN MRG:%ldus", audio_health.getLoadPercent(), (long)audio_health.worstMarginUs);
+    window->display();
+}
+
+// 以显示帧率调用各模块的 customViewPage(), 第一个示波器 / 频谱模块绘制到视图窗口
+// 遍历期间持有模块列表锁, 终端任务不能在绘制中途释放模块
+void updateModuleViews(Window* viewWindow) {
+    std::lock_guard<std::mutex> lock(manager.listMutex);
+    bool attached = false;
+    for (size_t i = 0; i < manager.getSlotSize(); i++) {
+        Module_t* module = manager.modules[i];
+        const char* name = module->module_info.name;
+        if (strcmp(name, "scope") == 0 || strcmp(name, "spectrum") == 0) {
+            static_cast<TapViewModule*>(module)->attachView(attached ? nullptr : viewWindow);
+            attached = true;
+        }
+        module->customViewPage();
+    }
+}
+
+// 视图窗口的按键: OCT-/OCT+ 切换电容键盘的八度, 按住时重复
+void handleViewKeys(Window* viewWindow) {
+    for (;;) {
+        key_event_t e = viewWindow->getKeyEvent();
+        if (e.status == KEY_IDLE) break;
+        if (e.status != KEY_ATTACK && e.status != KEY_REPEAT) continue;
+        if (e.num == KEY_OCTU && touch_keys.baseNote + 12 + TOUCH_KEYS <= 128) {
+            touch_keys.baseNote += 12;
+        } else if (e.num == KEY_OCTD && touch_keys.baseNote >= 12) {
+            touch_keys.baseNote -= 12;
+        }
+    }
+}
+
 void GUI(void *arg) {
     window_manager.setShowFps(true);
     Window* backgroundWindow = window_manager.registerWindow(SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, FIXED_BOTTOM_WINDOW, false, NO_DITHERING);
@@ -205,18 +508,68 @@ void GUI(void *arg) {
     backgroundWindow->display();
     vTaskDelay(1024);
     window_manager.unregisterWindow(backgroundWindow);
-    for (;;) {
-        vTaskDelay(32);
+    Window* statusWindow = window_manager.registerWindow(SCREEN_WIDTH, 24, 0, SCREEN_HEIGHT - 24, FLOATING_WINDOW, false, NO_DITHERING);
+    Window* viewWindow = window_manager.registerWindow(SCREEN_WIDTH, SCREEN_HEIGHT - 24, 0, 0, NORMAL_WINDOW, false, ORDERED_DITHERING);
+    for (uint32_t frame = 0;; frame++) {
+        handleViewKeys(viewWindow);
+        updateModuleViews(viewWindow);
+        if ((frame & 15) == 0) {
+            drawAudioStatus(statusWindow);
+        }
+        vTaskDelay(REFRESH_DELAY_MS);
+    }
+}
+
+// 两片 MPR121 (0x5A / 0x5B) 由 Adafruit 驱动完成配置, 之后交给 IRQ 驱动的读取任务
+void beginTouchKeys() {
+    static const uint8_t addresses[TOUCH_CHIPS] = {0x5A, 0x5B};
+    static const int irqPins[TOUCH_CHIPS] = {TOUCH_IRQ_PIN0, TOUCH_IRQ_PIN1};
+    Wire.begin(TOUCH_SDA_PIN, TOUCH_SCL_PIN, 400000);
+    if (!touchPad0.begin(addresses[0], &Wire) || !touchPad1.begin(addresses[1], &Wire)) {
+        printf("MPR121 not found\n");
+        return;
     }
+    touch_keys.begin(&Wire, addresses, irqPins);
+    printf("Touch keys ready\n");
 }
 
+// 单元测试 (pio test) 链接 src 时由测试提供 setup() / loop()
+#ifndef PIO_UNIT_TESTING
 void setup() {
     // esp_restart();
     SPI.begin(17, -1, 16);
     SPI.setFrequency(60000000);
     display.begin(SSD1306_SWITCHCAPVCC);
+    // WAV 后端与文件采样源使用 /spiffs 下的路径; 挂载失败时不自动格式化, 以免抹掉用户的 WAV / IR 文件
+    if (!SPIFFS.begin(false)) {
+        printf("SPIFFS mount failed, files under /spiffs are unavailable (formatSpiffs yes to erase and format)\n");
+    }
     // xNoteQueue = xQueueCreate(8, sizeof(key_event_t));
     manager.module_manager.registerModule<SimpleOsc>();
+    manager.module_manager.registerModule<BlepOsc>();
+    manager.module_manager.registerModule<Oversampled<SimpleOsc, 4>>();
+    manager.module_manager.registerModule<ResamplerModule>();
+    manager.module_manager.registerModule<SamplePlayer>();
+    manager.module_manager.registerModule<GranularModule>();
+    manager.module_manager.registerModule<FilterModule>();
+    manager.module_manager.registerModule<Envelope>();
+    manager.module_manager.registerModule<MixerModule>();
+    manager.module_manager.registerModule<NoiseModule>();
+    manager.module_manager.registerModule<StereoDelay>();
+    manager.module_manager.registerModule<FdnReverb>();
+    manager.module_manager.registerModule<ConvolverModule>();
+    manager.module_manager.registerModule<WavetableOsc>();
+    manager.module_manager.registerModule<FmSynth>();
+    manager.module_manager.registerModule<SequencerModule>();
+    manager.module_manager.registerModule<ScopeModule>();
+    manager.module_manager.registerModule<SpectrumModule>();
+    manager.module_manager.registerModule<MidiInModule>();
+    manager.module_manager.registerModule<TouchKeysModule>();
+    manager.module_manager.registerModule<Arpeggiator>();
+    manager.module_manager.registerModule<ChordMemory>();
+    manager.module_manager.registerModule<NoteTranspose>();
+    manager.module_manager.registerModule<VelocityCurve>();
+    manager.module_manager.registerModule<NoteCvModule>();
     manager.module_manager.registerModule<VolCtrl>();
     manager.module_manager.registerModule<i2s_audio_out>();
     // manager.module_manager.registerModule<noteEventModule>();
@@ -229,13 +582,19 @@ void setup() {
 
     xTaskCreatePinnedToCore(serialDebug, "terminal", 4096, NULL, 3, NULL, 1);
     printf("Terminal Created\n");
-    xTaskCreate(soundEng, "Sound Eng", 4096, NULL, 2, NULL);
+    midi_input.beginUart();
+    beginTouchKeys();
+    keypad_input.begin(&keypad, &window_manager);
+    // 音频任务固定在核心 0: 性能计数用的周期计数器每个核心各自独立, 迁移核心会得到错误的差值
+    xTaskCreatePinnedToCore(soundEng, "Sound Eng", 4096, NULL, 2, NULL, 0);
     printf("Sound Eng Created\n");
     xTaskCreatePinnedToCore(refreshDisplay, "Display", 2048, NULL, 3, NULL, 1);
-    xTaskCreate(GUI, "GUI", 10240, NULL, 3, NULL);
+    // 界面任务 (含频谱 FFT) 与显示刷新同在核心 1, 不占用音频核心
+    xTaskCreatePinnedToCore(GUI, "GUI", 10240, NULL, 3, NULL, 1);
     printf("GUI Created\nSetup return\n");
 }
 
 void loop() {
     vTaskDelete(NULL);
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,177 @@
+#ifndef MASTER_LIMITER_H
+#define MASTER_LIMITER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "platform_compat.h"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define LIMITER_DRIVE_ONE 256       // 前级增益 Q8
+#define LIMITER_MAX_DRIVE (8 * LIMITER_DRIVE_ONE)
+#define LIMITER_FRAC_BITS 8         // 内部总线比 int16 多 8 位小数
+
+enum {
+    MASTER_OFF = 0,     // 直通
+    MASTER_CLIP,        // 仅软削波: 超过拐点 (上限 -6 dB) 后渐近上限
+    MASTER_LIMIT,       // 前瞻限制, 软削波只作为保护
+};
+
+// 输出前的主控级: 前级增益 -> 前瞻峰值限制 -> 软削波 -> TPDF 抖动并舍入到 int16
+// 前瞻为一个块: 输出上一块时已知下一块的峰值, 每块只做一次除法求目标增益,
+// 增益在块内线性过渡; 过渡两端都不超过本块所需增益, 因此块内任何采样都不会超出上限
+class MasterLimiter {
+public:
+    int mode = MASTER_OFF;
+    int drive = LIMITER_DRIVE_ONE;
+    int ceiling = 31129;        // Q15, 约 -0.45 dBFS
+    int releaseMs = 80;
+    int dither = 1;
+
+    // 遥测, 由音频线程写入, 终端读取 (Q15 增益, 32767 = 无压缩)
+    volatile int32_t currentGain = 32767;
+    volatile int32_t minGain = 32767;
+    volatile uint32_t clippedSamples = 0;
+
+    void begin(uint32_t sampleRate) {
+        rate = sampleRate;
+        memset(delayed, 0, sizeof(delayed));
+        delayedPeak = 0;
+        gain = 32767;
+        resetTelemetry();
+    }
+
+    // 音频线程在主控级被旁路 (MASTER_OFF) 的块调用, 重新启用时前瞻缓冲从空开始
+    // 否则第一块会输出关闭前遗留的旧数据; CLIP 与 LIMIT 之间切换时缓冲中是连续的上一块, 保留
+    void bypass() {
+        bypassed = true;
+    }
+
+    void resetTelemetry() {
+        minGain = 32767;
+        clippedSamples = 0;
+    }
+
+    void process(const int16_t* in, int16_t* out) {
+        int32_t d = drive < 0 ? 0 : (drive > LIMITER_MAX_DRIVE ? LIMITER_MAX_DRIVE : drive);
+        int32_t ceil15 = ceiling < 1024 ? 1024 : (ceiling > 32767 ? 32767 : ceiling);
+        if (bypassed) {
+            memset(delayed, 0, sizeof(delayed));
+            delayedPeak = 0;
+            gain = 32767;
+            bypassed = false;
+        }
+
+        // 增益计算: 本块与下一块 (刚输入的) 的峰值; d >= 0, 所以 |in * d| 的最大值就是 peak(in) * d
+        int32_t next[AUDIO_BLOCK_SIZE];
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            next[i] = in[i] * d;
+        }
+        int32_t peakNext = Dsp::peak(in, AUDIO_BLOCK_SIZE) * d;
+        int32_t peak = peakNext > delayedPeak ? peakNext : delayedPeak;
+        int64_t limit = (int64_t)ceil15 << LIMITER_FRAC_BITS;
+        int32_t target = (mode == MASTER_LIMIT && peak > limit) ? (int32_t)((limit << 15) / peak) : 32767;
+        // 释放: 每块最多回升 releaseStep, 压缩则立即到位
+        int32_t step = releaseStep();
+        if (target > gain + step) target = gain + step;
+        int32_t from = gain;
+        gain = target;
+        if (target < minGain) minGain = target;
+        currentGain = target;
+
+        int32_t ramp = (target - from) * 256 / AUDIO_BLOCK_SIZE;
+        int32_t g = from * 256;
+        int32_t top = ceil15 << LIMITER_FRAC_BITS;
+        int32_t knee = mode == MASTER_LIMIT ? top : top >> 1;
+        uint32_t clipped = 0;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i += 2) {
+            uint32_t r = dither ? nextRandom() : 0x80808080u;
+            for (int k = 0; k < 2; k++) {
+                g += ramp;
+                int32_t y = (int32_t)(((int64_t)delayed[i + k] * (g >> 8)) >> 15);
+                int32_t a = y < 0 ? -y : y;
+                if (a > knee) {
+                    y = softClip(y, knee, top);
+                    clipped++;
+                }
+                // TPDF: 两个 [-0.5, 0.5) LSB 的均匀分布相加, 再舍入
+                int32_t t = (int32_t)((r >> (16 * k)) & 0xFF) + (int32_t)((r >> (16 * k + 8)) & 0xFF) - 256;
+                y = (y + t + (1 << (LIMITER_FRAC_BITS - 1))) >> LIMITER_FRAC_BITS;
+                out[i + k] = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+            }
+        }
+        clippedSamples += clipped;
+
+        memcpy(delayed, next, sizeof(delayed));
+        delayedPeak = peakNext;
+    }
+
+    // 软削波: 拐点以上按 u / (1 + u) 渐近 top; 拐点等于 top 时即硬限幅
+    static int32_t softClip(int32_t y, int32_t knee, int32_t top) {
+        int32_t a = y < 0 ? -y : y;
+        int32_t room = top - knee;
+        if (room <= 0) return y < 0 ? -top : top;
+        int64_t over = a - knee;
+        int32_t c = knee + (int32_t)(over * room / (over + room));
+        return y < 0 ? -c : c;
+    }
+
+    // 当前与最大增益衰减 (dB, 正数)
+    float currentReductionDb() const {
+        return gainToDb(currentGain);
+    }
+    float maxReductionDb() const {
+        return gainToDb(minGain);
+    }
+
+private:
+    int32_t delayed[AUDIO_BLOCK_SIZE];
+    int32_t delayedPeak = 0;
+    int32_t gain = 32767;
+    bool bypassed = false;
+    uint32_t rate = SMP_RATE;
+    uint32_t random = 0x12345678;
+
+    static float gainToDb(int32_t g) {
+        return g >= 32767 ? 0.0f : -20.0f * log10f(g / 32767.0f);
+    }
+
+    // 每块的释放步长: releaseMs 内从 0 回到 1
+    int32_t releaseStep() {
+        int ms = releaseMs < 1 ? 1 : releaseMs;
+        int32_t blocks = (int32_t)((uint64_t)rate * ms / 1000 / AUDIO_BLOCK_SIZE);
+        return blocks > 0 ? 32767 / blocks : 32767;
+    }
+
+    inline uint32_t nextRandom() {
+        uint32_t x = random;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        random = x;
+        return x;
+    }
+};
+
+// 重载输入 (前级 +12 dB) 下的每采样耗时
+inline void benchMasterLimiter(uint32_t blocks) {
+    static const char* names[] = {"master soft clip", "master limiter"};
+    int16_t in[AUDIO_BLOCK_SIZE], out[AUDIO_BLOCK_SIZE];
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        in[i] = (int16_t)(30000 * sinf(2.0f * (float)M_PI * i / AUDIO_BLOCK_SIZE));
+    }
+    for (int mode = MASTER_CLIP; mode <= MASTER_LIMIT; mode++) {
+        MasterLimiter limiter;
+        limiter.begin(SMP_RATE);
+        limiter.mode = mode;
+        limiter.drive = 4 * LIMITER_DRIVE_ONE;
+        benchPrint(benchRun(names[mode - MASTER_CLIP], blocks, AUDIO_BLOCK_SIZE, [&]() {
+            limiter.process(in, out);
+        }));
+        printf("%-24s GR %.1f dB, clipped %u\n", "", limiter.maxReductionDb(), (unsigned)limiter.clippedSamples);
+    }
+}
+
+#endif
@@ -0,0 +1,369 @@
+#ifndef MIDI_INPUT_H
+#define MIDI_INPUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "event_bus.h"
+#include "spsc_ring.h"
+#include "platform_compat.h"
+#include "src_config.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include "driver/uart.h"
+#define MIDI_UART_NUM UART_NUM_1
+#define MIDI_RX_PIN GPIO_NUM_5
+#else
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <poll.h>
+#endif
+
+#define MIDI_BAUD 31250
+#define MIDI_BYTE_US 320        // 31250 波特, 每字节 10 位
+#define MIDI_RING_SIZE 256
+
+// 已解析并打上时间戳的 MIDI 消息
+typedef struct {
+    int64_t sample;     // 消息首字节到达时对应的采样位置
+    uint8_t type;       // event_type_t
+    uint8_t channel;
+    uint8_t data1;
+    int16_t data2;
+} midi_event_t;
+
+// MIDI 字节流解析: 支持运行状态, 实时消息可插在任意位置, 系统专用消息整段忽略
+class MidiParser {
+public:
+    // 输入一个字节, 组成完整消息时返回 true
+    bool feed(uint8_t b, midi_event_t& msg) {
+        if (b >= 0xF8) {
+            // 实时消息不打断运行状态
+            if (b == 0xF8) return make(msg, EVENT_CLOCK, 0, 0, 0);
+            if (b == 0xFA || b == 0xFB) return make(msg, EVENT_START, 0, 0, 0);
+            if (b == 0xFC) return make(msg, EVENT_STOP, 0, 0, 0);
+            return false;
+        }
+        if (b & 0x80) {
+            count = 0;
+            if (b >= 0xF0) {
+                // 系统公共消息清除运行状态, 其数据字节一并丢弃
+                status = 0;
+                return false;
+            }
+            status = b;
+            return false;
+        }
+        if (!status) return false;
+        data[count++] = b;
+        uint8_t kind = status & 0xF0;
+        int need = (kind == 0xC0 || kind == 0xD0) ? 1 : 2;
+        if (count < need) return false;
+        count = 0;
+        uint8_t ch = status & 0x0F;
+        switch (kind) {
+            case 0x80:
+                return make(msg, EVENT_NOTE_OFF, ch, data[0], data[1]);
+            case 0x90:
+                // 力度 0 的 note on 即 note off
+                return make(msg, data[1] ? EVENT_NOTE_ON : EVENT_NOTE_OFF, ch, data[0], data[1]);
+            case 0xB0:
+                return make(msg, EVENT_CONTROL, ch, data[0], data[1]);
+            case 0xC0:
+                return make(msg, EVENT_PROGRAM, ch, data[0], 0);
+            case 0xE0:
+                return make(msg, EVENT_PITCH_BEND, ch, 0, (int16_t)((data[0] | (data[1] << 7)) - 8192));
+            default:
+                return false; // 复音 / 通道触后
+        }
+    }
+
+    // 当前字节是否开始一条新消息 (用于取首字节时间戳)
+    bool atMessageStart() const {
+        return count == 0;
+    }
+
+private:
+    uint8_t status = 0;
+    uint8_t data[2] = {};
+    int count = 0;
+
+    static bool make(midi_event_t& msg, uint8_t type, uint8_t ch, uint8_t d1, int16_t d2) {
+        msg.type = type;
+        msg.channel = ch;
+        msg.data1 = d1;
+        msg.data2 = d2;
+        return true;
+    }
+};
+
+// MIDI 输入: 独立任务 (主机上为线程) 读取 UART / USB-CDC / 文件, 解析后按采样时钟打时间戳,
+// 经无锁环形缓冲交给音频线程; 音频线程是唯一的消费者
+class MidiInput {
+public:
+    SpscRing<midi_event_t> events{MIDI_RING_SIZE};
+    volatile uint32_t received = 0;
+    volatile uint32_t dropped = 0;
+
+    // 一次读到的字节, lastUs 为读取完成的时间, byteUs 为每字节传输时间 (USB 为 0)
+    // 逐字节倒推到达时间, 消息时间取其首字节
+    void receive(const uint8_t* bytes, int n, int64_t lastUs, int byteUs) {
+        for (int i = 0; i < n; i++) {
+            int64_t us = lastUs - (int64_t)(n - 1 - i) * byteUs;
+            if (parser.atMessageStart() && bytes[i] < 0xF8) messageUs = us;
+            midi_event_t msg;
+            if (!parser.feed(bytes[i], msg)) continue;
+            // 实时消息为单字节, 使用自身时间
+            msg.sample = audio_clock.sampleAt(msg.type >= EVENT_CLOCK ? us : messageUs);
+            if (events.push(msg)) {
+                received++;
+            } else {
+                dropped++;
+            }
+        }
+    }
+
+#ifdef ESP_PLATFORM
+    // DIN MIDI: UART 接收, FIFO 每收到一个字节即唤醒读取任务
+    bool beginUart(uart_port_t port = MIDI_UART_NUM, int rxPin = MIDI_RX_PIN) {
+        uart_config_t cfg = {};
+        cfg.baud_rate = MIDI_BAUD;
+        cfg.data_bits = UART_DATA_8_BITS;
+        cfg.parity = UART_PARITY_DISABLE;
+        cfg.stop_bits = UART_STOP_BITS_1;
+        cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+        cfg.source_clk = UART_SCLK_DEFAULT;
+        if (uart_driver_install(port, 256, 0, 0, NULL, 0) != ESP_OK) {
+            printf("MIDI: uart driver install failed\n");
+            return false;
+        }
+        uart_param_config(port, &cfg);
+        uart_set_pin(port, UART_PIN_NO_CHANGE, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+        uart_set_rx_full_threshold(port, 1);
+        uart_set_rx_timeout(port, 1);
+        uartPort = port;
+        xTaskCreatePinnedToCore(uartTask, "MIDI", 3072, this, 4, &task, 1);
+        printf("MIDI: uart %d rx pin %d\n", (int)port, rxPin);
+        return true;
+    }
+
+    // USB-CDC (或其他 Arduino Stream), 每个系统节拍轮询一次
+    void beginStream(Stream* s) {
+        stream = s;
+        xTaskCreatePinnedToCore(streamTask, "MIDI", 3072, this, 4, &task, 1);
+    }
+#else
+    // 主机: 从 pty / FIFO / 文件读取原始 MIDI 字节; 普通文件按 DIN 线速回放
+    bool beginFile(const char* path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            printf("MIDI: cannot open %s\n", path);
+            return false;
+        }
+        struct stat st;
+        paced = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+        running = true;
+        reader = std::thread([this]() { fileLoop(); });
+        return true;
+    }
+
+    void end() {
+        running = false;
+        if (reader.joinable()) reader.join();
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    ~MidiInput() {
+        end();
+    }
+#endif
+
+private:
+    MidiParser parser;
+    int64_t messageUs = 0;
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t task = nullptr;
+    uart_port_t uartPort = MIDI_UART_NUM;
+    Stream* stream = nullptr;
+
+    static void uartTask(void* arg) {
+        MidiInput* self = (MidiInput*)arg;
+        uint8_t buf[64];
+        for (;;) {
+            // 阻塞等待第一个字节, 再取走 FIFO 中已有的其余字节
+            int n = uart_read_bytes(self->uartPort, buf, 1, portMAX_DELAY);
+            if (n <= 0) continue;
+            size_t more = 0;
+            uart_get_buffered_data_len(self->uartPort, &more);
+            if (more > sizeof(buf) - 1) more = sizeof(buf) - 1;
+            if (more) n += uart_read_bytes(self->uartPort, buf + 1, more, 0);
+            self->receive(buf, n, esp_timer_get_time(), MIDI_BYTE_US);
+        }
+    }
+
+    static void streamTask(void* arg) {
+        MidiInput* self = (MidiInput*)arg;
+        uint8_t buf[64];
+        for (;;) {
+            int n = 0;
+            while (n < (int)sizeof(buf) && self->stream->available()) {
+                buf[n++] = self->stream->read();
+            }
+            if (n) self->receive(buf, n, esp_timer_get_time(), 0);
+            vTaskDelay(1);
+        }
+    }
+#else
+    int fd = -1;
+    bool paced = false;
+    std::atomic<bool> running{false};
+    std::thread reader;
+
+    void fileLoop() {
+        uint8_t buf[64];
+        while (running) {
+            if (!paced) {
+                // 带超时等待, 以便 end() 能结束线程
+                struct pollfd p = {fd, POLLIN, 0};
+                if (poll(&p, 1, 50) <= 0) continue;
+            }
+            int n = read(fd, buf, paced ? 1 : sizeof(buf));
+            if (n <= 0) break;
+            if (paced) usleep(MIDI_BYTE_US);
+            receive(buf, n, esp_timer_get_time(), 0);
+        }
+    }
+#endif
+};
+
+MidiInput midi_input;
+
+// 音符来源模块的公共部分: 从时间戳环形缓冲取出事件, 换算成块内偏移, 以事件端口输出,
+// 并给出单音的门 / 频率 / 力度
+// 所有事件固定延后 Latency 个块调度, 只要输入线程在这段时间内送达, 输出就没有抖动
+class NoteSourceModule: public Module_t {
+public:
+    NoteSourceModule(SpscRing<midi_event_t>& source): source(source) {}
+
+    int16_t events[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t velocity[AUDIO_BLOCK_SIZE] = {};
+    int channel = 0;    // 0 = 全部通道
+    int latency = 1;    // 调度延迟 (块)
+
+    // 调度延迟统计: 事件输出位置 - 到达位置 (采样)
+    uint32_t delivered = 0;
+    uint32_t late = 0;
+    int64_t delaySum = 0;
+    int32_t delayMin = INT32_MAX;
+    int32_t delayMax = 0;
+    uint32_t deferred = 0;  // 块内事件已满, 推迟到下一块的次数
+
+    void process() {
+        EventBlock::clear(events);
+        int64_t blockStart = audio_clock.blockStart();
+        int64_t end = blockStart + AUDIO_BLOCK_SIZE;
+        int64_t delay = (int64_t)(latency < 0 ? 0 : latency) * AUDIO_BLOCK_SIZE;
+        int pos = 0;
+        for (;;) {
+            if (!hasPending) {
+                if (!source.pop(pending)) break;
+                hasPending = true;
+            }
+            int64_t at = pending.sample + delay;
+            if (at >= end) break;
+            bool filtered = channel > 0 && pending.channel != channel - 1 && pending.type < EVENT_CLOCK;
+            // 块已满时留到下一块块首, 不丢弃: 丢掉 NOTE_OFF 会卡音
+            if (!filtered && EventBlock::count(events) >= EVENT_MAX_PER_BLOCK) {
+                deferred++;
+                break;
+            }
+            hasPending = false;
+            // 迟到的事件放在块首, 并保持偏移升序
+            int offset = at < blockStart ? 0 : (int)(at - blockStart);
+            if (offset < pos) offset = pos;
+            if (at < blockStart) late++;
+            addDelay(blockStart + offset - pending.sample);
+            if (filtered) continue;
+
+            note_event_t e = {(uint8_t)offset, pending.type, pending.channel, pending.data1, pending.data2};
+            EventBlock::push(events, e);
+            cv.fill(gate, freq, velocity, pos, offset);
+            pos = offset;
+            cv.apply(e);
+        }
+        cv.fill(gate, freq, velocity, pos, AUDIO_BLOCK_SIZE);
+    }
+    void printProfileDetail() {
+        printf("    events: %lu, %lu late, %lu deferred (block full), delay avg %.0fus min %.0fus max %.0fus\n",
+               (unsigned long)delivered, (unsigned long)late, (unsigned long)deferred,
+               delivered ? (float)delaySum / delivered * 1000000 / SMP_RATE : 0.0f,
+               delivered ? (float)delayMin * 1000000 / SMP_RATE : 0.0f, (float)delayMax * 1000000 / SMP_RATE);
+    }
+    void resetProfile() {
+        Module_t::resetProfile();
+        delivered = late = deferred = 0;
+        delaySum = 0;
+        delayMin = INT32_MAX;
+        delayMax = 0;
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+protected:
+    void registerNotePorts() {
+        cv.begin();
+        registerPort(events, PORT_EOUT, "EVENTS", "timestamped note events");
+        registerPort(gate, PORT_DOUT, "GATE", "gate of the last note");
+        registerPort(freq, PORT_AOUT, "FREQ", "pitch of the last note (Hz)");
+        registerPort(velocity, PORT_AOUT, "VELOCITY", "velocity of the last note, Q15");
+        registerParam(&channel, PARAM_INT, "Channel", "0:omni 1 ~ 16");
+        registerParam(&latency, PARAM_INT, "Latency", "scheduling delay (blocks)");
+    }
+
+private:
+    SpscRing<midi_event_t>& source;
+    MonoNoteCv cv;
+    midi_event_t pending;
+    bool hasPending = false;
+
+    void addDelay(int64_t d) {
+        delivered++;
+        delaySum += d;
+        if (d < delayMin) delayMin = (int32_t)d;
+        if (d > delayMax) delayMax = (int32_t)d;
+    }
+};
+
+// MIDI 输入模块, 读取 midi_input 的事件; 事件队列只有一个消费者, 因此只允许一个实例
+class MidiInModule: public NoteSourceModule {
+public:
+    MidiInModule(): NoteSourceModule(midi_input.events) { module_info = {"midi in", "libchara-dev", "MIDI input (UART / USB / file) with sample-accurate timing", false, false, true}; }
+
+    void start() {
+        registerNotePorts();
+        printf("MidiIn Start\n");
+    }
+    void stop() {
+        printf("MidiIn Stop\n");
+    }
+    void printProfileDetail() {
+        NoteSourceModule::printProfileDetail();
+        printf("    midi: %lu received, %lu dropped\n", (unsigned long)midi_input.received, (unsigned long)midi_input.dropped);
+    }
+};
+
+#endif
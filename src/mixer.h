@@ -0,0 +1,128 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "module_manager.hpp"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define MIXER_CHANNELS 16
+#define MIXER_UNITY 4096        // 通道增益 Q12, 16 路满幅相加仍不超出 32 位
+#define MIXER_RAMP_STEP 512     // 每块最大增益变化, 0 到 1 约 8 个块
+
+// 16 路混音器: 32 位总线累加, 每块只在输出处饱和一次
+// 增益变化在块内线性平滑; 静音、增益为 0 或输入整块为 0 (未连接) 的通道直接跳过
+// 输入在每块处理后清零, 断开连接的通道不会重复混入最后一块
+class MixerModule: public Module_t {
+public:
+    MixerModule() { module_info = {"mixer", "libchara-dev", "16-input mixer with smoothed gains and 32-bit bus", false, false}; }
+
+    DSP_ALIGN int16_t in[MIXER_CHANNELS][AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int gain[MIXER_CHANNELS];
+    int mute[MIXER_CHANNELS] = {};
+    int master = 32767; // Q15
+
+    uint32_t activeChannels = 0; // 上一块实际参与混音的通道数
+
+    void start() {
+        for (int ch = 0; ch < MIXER_CHANNELS; ch++) {
+            char name[8];
+            snprintf(name, sizeof(name), "IN%d", ch + 1);
+            registerPort(in[ch], PORT_AIN, name, "mixer input");
+            gain[ch] = MIXER_UNITY;
+            current[ch] = MIXER_UNITY;
+        }
+        registerPort(out, PORT_AOUT, "OUTPUT", "mix output");
+        registerParam(gain, PARAM_ARY, "Gain", "int[16], Q12 (4096 = 1.0)");
+        registerParam(mute, PARAM_ARY, "Mute", "int[16], 1 = muted");
+        registerParam(&master, PARAM_INT, "Master", "master gain, Q15");
+        printf("Mixer Start\n");
+    }
+    void stop() {
+        printf("Mixer Stop\n");
+    }
+    void process() {
+        memset(bus, 0, sizeof(bus));
+        activeChannels = 0;
+        for (int ch = 0; ch < MIXER_CHANNELS; ch++) {
+            int32_t target = mute[ch] ? 0 : (gain[ch] < 0 ? 0 : (gain[ch] > MIXER_UNITY ? MIXER_UNITY : gain[ch]));
+            int32_t from = current[ch];
+            int32_t to = target;
+            if (to - from > MIXER_RAMP_STEP) to = from + MIXER_RAMP_STEP;
+            if (from - to > MIXER_RAMP_STEP) to = from - MIXER_RAMP_STEP;
+            current[ch] = to;
+            if (isSilent(in[ch])) continue;
+            if (from != 0 || to != 0) {
+                activeChannels++;
+                if (from == to) {
+                    Dsp::mac32(in[ch], to, bus, AUDIO_BLOCK_SIZE);
+                } else {
+                    rampMac(in[ch], from, to);
+                }
+            }
+            // 读完即清零: 已连接的输入每块由 ConnectionManager 重新写入, 断开的输入从下一块起保持为 0
+            memset(in[ch], 0, sizeof(in[ch]));
+        }
+        Dsp::saturate(bus, 12, out, AUDIO_BLOCK_SIZE);
+        if (master < 32767) {
+            Dsp::gain(out, master, out, AUDIO_BLOCK_SIZE);
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    DSP_ALIGN int32_t bus[AUDIO_BLOCK_SIZE];
+    int32_t current[MIXER_CHANNELS]; // 平滑后的当前增益
+
+    static bool isSilent(const int16_t* x) {
+        int16_t acc = 0;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            acc |= x[i];
+        }
+        return acc == 0;
+    }
+
+    // 增益在块内从 from 线性过渡到 to (Q12, 内部多 6 位小数)
+    void rampMac(const int16_t* x, int32_t from, int32_t to) {
+        int32_t g = from << 6;
+        int32_t step = ((to - from) << 6) / AUDIO_BLOCK_SIZE;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            g += step;
+            bus[i] += x[i] * (g >> 6);
+        }
+    }
+};
+
+// 16 路满负载混音, 以及只有 4 路有信号时 (其余未连接) 的耗时
+// 输入每块处理后清零, 所以与 ConnectionManager 一样每块重新写入输入 (计入耗时)
+inline void benchMixer(uint32_t blocks) {
+    static const char* names[] = {"mixer 16 inputs", "mixer 4 of 16 inputs"};
+    for (int v = 0; v < 2; v++) {
+        int used = v == 0 ? MIXER_CHANNELS : 4;
+        MixerModule* m = new MixerModule();
+        m->start();
+        DSP_ALIGN static int16_t src[MIXER_CHANNELS][AUDIO_BLOCK_SIZE];
+        for (int ch = 0; ch < used; ch++) {
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                src[ch][i] = (i * (ch + 1) * 331) & 0x3FFF;
+            }
+            m->gain[ch] = MIXER_UNITY / 2;
+        }
+        benchPrint(benchRun(names[v], blocks, AUDIO_BLOCK_SIZE, [&]() {
+            memcpy(m->in, src, used * sizeof(src[0]));
+            m->process();
+        }));
+        m->stop();
+        delete m;
+    }
+}
+
+#endif
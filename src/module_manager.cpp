@@ -36,7 +36,7 @@ int ParamManager::getParamCount() {
 }
 
 bool PortManager::registerPort(int16_t* data, port_type type, const char* name, const char* profile) {
-    if (type == PORT_AIN || type == PORT_DIN) { // Input types
+    if (type == PORT_AIN || type == PORT_DIN || type == PORT_EIN) { // Input types
         if (inputPortCount >= MAX_PORT) {
             printf("Input port array is full. Cannot register %s.\n", name);
             return false;
@@ -48,7 +48,7 @@ bool PortManager::registerPort(int16_t* data, port_type type, const char* name,
         port.data = data;
         inputPortCount++;
         printf("Input port %s registered.\n", name);
-    } else if (type == PORT_AOUT || type == PORT_DOUT) { // Output types
+    } else if (type == PORT_AOUT || type == PORT_DOUT || type == PORT_EOUT) { // Output types
         if (outputPortCount >= MAX_PORT) {
             printf("Output port array is full. Cannot register %s.\n", name);
             return false;
@@ -114,6 +114,10 @@ Module_t* ModuleManager::createModule(const char* name) {
         printf("Module %s not found.\n", name);
         return nullptr;
     }
+    if (moduleInfoTable[name].singleInstance && moduleInstanceCount[name] > 0) {
+        printf("Module %s allows only one instance.\n", name);
+        return nullptr;
+    }
 
     // 创建一个新的模块实例
     ModulePtr newModule = moduleCreators[name]();
@@ -2,6 +2,7 @@
 #define MODULE_MANAGER_H
 
 #include "src_config.h"
+#include "platform_compat.h"
 #include <iostream>
 #include <unordered_map>
 #include <memory>
@@ -15,14 +16,16 @@ typedef enum {
     PORT_DIN,
     PORT_DOUT,
     PORT_AIN_FLOAT,
-    PORT_AOUT_FLOAT
+    PORT_AOUT_FLOAT,
+    PORT_EIN,   // 事件端口, 块内布局见 event_bus.h
+    PORT_EOUT
 } port_type;
 
 typedef struct {
     char name[32] = "NAME";
     char profile[64] = "PROFILE";
     port_type type = PORT_NONE;
-    int16_t *data;
+    int16_t *data; // 指向长度为 AUDIO_BLOCK_SIZE 的数据块
 } port_t;
 
 typedef enum {
@@ -45,8 +48,30 @@ typedef struct {
     char profile[128] = "PROFILE";
     bool customSetting = false;
     bool customView = false;
+    bool singleInstance = false;    // 只允许一个实例, 如读取单消费者事件队列的输入模块
 } module_info_t;
 
+// 模块处理耗时统计, 单位为 perf_ticks()
+typedef struct module_profile_t {
+    uint64_t ticks = 0;
+    uint32_t calls = 0;
+    uint32_t peak = 0;
+
+    void add(uint32_t t) {
+        ticks += t;
+        calls++;
+        if (t > peak) peak = t;
+    }
+
+    float averageUs() const {
+        return calls ? (float)ticks / calls / PERF_TICKS_PER_US : 0;
+    }
+
+    float peakUs() const {
+        return (float)peak / PERF_TICKS_PER_US;
+    }
+} module_profile_t;
+
 class ParamManager {
 public:
     param_t params[MAX_PARAM];
@@ -86,8 +111,20 @@ public:
     }
 
     module_info_t module_info;
+    // 模块运行的采样率, 被过采样包装时为 SMP_RATE 的倍数
+    uint32_t sampleRate = SMP_RATE;
+    // 由 ConnectionManager 统计的每块处理耗时
+    module_profile_t profile;
+
+    // 打印分项耗时 (如过采样滤波器), 默认无
+    virtual void printProfileDetail() {}
+    virtual void resetProfile() {
+        profile = {};
+    }
+
     virtual void start() = 0;
     virtual void stop() = 0;
+    // 处理一个块 (AUDIO_BLOCK_SIZE 个采样)
     virtual void process() = 0;
     virtual void customSettingPage() = 0;
     virtual void customViewPage() = 0;
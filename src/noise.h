@@ -0,0 +1,165 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define PINK_ROWS 12 // Voss-McCartney 行数, 最低约 fs / 2^13
+
+typedef enum {
+    NOISE_WHITE,
+    NOISE_PINK,
+    NOISE_SAMPLE_HOLD
+} noise_mode_t;
+
+// 噪声发生器: xorshift64 每步产生 4 个 16 位样本, 整块生成
+// Seed 非 0 时输出可复现 (离线渲染), 为 0 时以启动时间播种
+class NoiseModule: public Module_t {
+public:
+    NoiseModule() { module_info = {"noise generator", "libchara-dev", "White / pink / sample-and-hold noise", false, false}; }
+
+    int16_t clock[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int mode = NOISE_WHITE;
+    int level = 32767;  // Q15
+    int rate = 0;       // 采样保持内部时钟 (Hz), 0 = 仅由 CLOCK 端口触发
+    int seed = 0;
+
+    void start() {
+        registerPort(clock, PORT_DIN, "CLOCK", "sample-and-hold clock");
+        registerPort(out, PORT_AOUT, "OUTPUT", "noise output");
+        registerParam(&mode, PARAM_INT, "Mode", "0:white 1:pink 2:sample & hold");
+        registerParam(&level, PARAM_INT, "Level", "output level, Q15");
+        registerParam(&rate, PARAM_INT, "Rate", "S&H internal clock (Hz), 0 = external only");
+        registerParam(&seed, PARAM_INT, "Seed", "0 = random, otherwise reproducible");
+        reseed();
+        printf("Noise Start\n");
+    }
+    void stop() {
+        printf("Noise Stop\n");
+    }
+    void process() {
+        if (seed != currentSeed) {
+            reseed();
+        }
+        fillWhite(out);
+        switch (mode) {
+            case NOISE_PINK:
+                pink();
+                break;
+            case NOISE_SAMPLE_HOLD:
+                sampleHold();
+                break;
+            default:
+                break;
+        }
+        if (level < 32767) {
+            Dsp::gain(out, level, out, AUDIO_BLOCK_SIZE);
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+    // 重新播种并清空粉红噪声与采样保持状态
+    void reseed() {
+        currentSeed = seed;
+        state = seed ? (uint64_t)(uint32_t)seed * 0x9E3779B97F4A7C15ull : (uint64_t)esp_timer_get_time() * 0x9E3779B97F4A7C15ull;
+        if (state == 0) state = 0x2545F4914F6CDD1Dull;
+        counter = 0;
+        pinkSum = 0;
+        for (int r = 0; r < PINK_ROWS; r++) {
+            rows[r] = 0;
+        }
+        held = 0;
+        clockPhase = 0;
+        lastClock = false;
+    }
+
+private:
+    uint64_t state = 1;
+    int currentSeed = 0;
+    uint32_t counter = 0;
+    int32_t rows[PINK_ROWS];
+    int32_t pinkSum = 0;
+    int16_t held = 0;
+    uint32_t clockPhase = 0;
+    bool lastClock = false;
+
+    inline uint64_t next() {
+        uint64_t x = state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        state = x;
+        return x;
+    }
+
+    void fillWhite(int16_t* dst) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i += 4) {
+            uint64_t r = next();
+            dst[i] = (int16_t)r;
+            dst[i + 1] = (int16_t)(r >> 16);
+            dst[i + 2] = (int16_t)(r >> 32);
+            dst[i + 3] = (int16_t)(r >> 48);
+        }
+    }
+
+    // Voss-McCartney: 每个采样只更新一行 (由计数器末尾 0 的个数决定), 再叠加白噪声
+    // 每行取随机数的高 12 位, 13 项相加不超出 16 位范围
+    void pink() {
+        int16_t rowRandom[AUDIO_BLOCK_SIZE];
+        fillWhite(rowRandom); // 行更新用另一组随机数, 与叠加的白噪声不相关
+        int32_t sum = pinkSum;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int32_t white = out[i] >> 4;
+            counter++;
+            // 计数器回绕到 0 时 ctz 未定义; 置最高位后结果为 31, 不更新任何行
+            int row = __builtin_ctz(counter | (1u << 31));
+            if (row < PINK_ROWS) {
+                int32_t v = rowRandom[i] >> 4;
+                sum += v - rows[row];
+                rows[row] = v;
+            }
+            int32_t y = sum + white;
+            out[i] = y > 32767 ? 32767 : (y < -32768 ? -32768 : y);
+        }
+        pinkSum = sum;
+    }
+
+    // CLOCK 上升沿或内部时钟溢出时采样一个新随机值
+    void sampleHold() {
+        uint32_t inc = rate > 0 ? (uint32_t)(((uint64_t)rate << 32) / sampleRate) : 0;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            bool c = clock[i] != 0;
+            uint32_t p = clockPhase + inc;
+            bool tick = (c && !lastClock) || p < clockPhase;
+            clockPhase = p;
+            lastClock = c;
+            if (tick) held = out[i];
+            out[i] = held;
+        }
+    }
+};
+
+// 各模式单实例耗时
+inline void benchNoise(uint32_t blocks) {
+    static const char* names[] = {"noise white", "noise pink", "noise s&h"};
+    for (int m = NOISE_WHITE; m <= NOISE_SAMPLE_HOLD; m++) {
+        benchModule<NoiseModule>(names[m], blocks, [m](NoiseModule& n) {
+            n.mode = m;
+            n.seed = 1;
+            n.rate = 100;
+            n.level = 16384;
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,576 @@
+#ifndef NOTE_FX_H
+#define NOTE_FX_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "event_bus.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define ARP_MAX_NOTES 16
+#define CHORD_MAX_VOICES 4
+#define MIDI_CLOCK_PPQ 24
+
+// 事件处理模块的公共部分: 一个事件输入, 一个事件输出
+// 各模块按块处理事件列表, 输入为空时只清空输出 (琶音器在有音符按住时除外)
+class EventFxModule: public Module_t {
+public:
+    int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+protected:
+    void registerEventPorts() {
+        registerPort(in, PORT_EIN, "EVENTS IN", "note events input");
+        registerPort(out, PORT_EOUT, "EVENTS OUT", "note events output");
+    }
+
+    void emit(uint8_t offset, uint8_t type, uint8_t channel, int note, int value) {
+        if (note < 0 || note > 127) return;
+        note_event_t e = {offset, type, channel, (uint8_t)note, (int16_t)value};
+        EventBlock::push(out, e);
+    }
+};
+
+// 力度曲线: Curve < 0 偏软 (低力度抬高), > 0 偏硬; 结果映射到 Min ~ Max
+// 参数变化时重建 128 点查表
+class VelocityCurve: public EventFxModule {
+public:
+    VelocityCurve() { module_info = {"velocity curve", "libchara-dev", "Velocity curve and range for note events", false, false}; }
+
+    int curve = 0;      // -100 ~ 100
+    int minimum = 1;
+    int maximum = 127;
+
+    void start() {
+        registerEventPorts();
+        registerParam(&curve, PARAM_INT, "Curve", "-100 (soft) ~ 100 (hard)");
+        registerParam(&minimum, PARAM_INT, "Min", "1 ~ 127");
+        registerParam(&maximum, PARAM_INT, "Max", "1 ~ 127");
+        printf("VelocityCurve Start\n");
+    }
+    void stop() {
+        printf("VelocityCurve Stop\n");
+    }
+    void process() {
+        EventBlock::clear(out);
+        int n = EventBlock::take(in);
+        if (!n) return;
+        if (curve != builtCurve || minimum != builtMin || maximum != builtMax) buildTable();
+        for (int i = 0; i < n; i++) {
+            note_event_t e = EventBlock::get(in, i);
+            if (e.type == EVENT_NOTE_ON) e.data2 = table[e.data2 & 0x7F];
+            EventBlock::push(out, e);
+        }
+    }
+
+private:
+    uint8_t table[128];
+    int builtCurve = -1000, builtMin = -1, builtMax = -1;
+
+    void buildTable() {
+        builtCurve = curve;
+        builtMin = minimum;
+        builtMax = maximum;
+        int c = curve < -100 ? -100 : (curve > 100 ? 100 : curve);
+        int lo = minimum < 1 ? 1 : (minimum > 127 ? 127 : minimum);
+        int hi = maximum < lo ? lo : (maximum > 127 ? 127 : maximum);
+        float gamma = powf(2.0f, c / 50.0f);
+        table[0] = 0;
+        for (int v = 1; v < 128; v++) {
+            table[v] = (uint8_t)lrintf(lo + (hi - lo) * powf(v / 127.0f, gamma));
+        }
+    }
+};
+
+// 移调与音阶量化: 先移调, 再向下取到音阶内最近的音
+// 按下时记录映射结果, 松开使用同一结果, 演奏中改参数也不会卡音
+class NoteTranspose: public EventFxModule {
+public:
+    NoteTranspose() { module_info = {"transpose", "libchara-dev", "Transposer and scale quantizer for note events", false, false}; }
+
+    int semitones = 0;
+    int scale = 0;
+    int root = 0;
+
+    void start() {
+        registerEventPorts();
+        registerParam(&semitones, PARAM_INT, "Transpose", "semitones, -48 ~ 48");
+        registerParam(&scale, PARAM_INT, "Scale", "0:chromatic 1:major 2:minor 3:penta maj 4:penta min 5:dorian 6:harm minor 7:blues");
+        registerParam(&root, PARAM_INT, "Root", "0 ~ 11 (C ~ B)");
+        memset(mapped, 0xFF, sizeof(mapped));
+        printf("Transpose Start\n");
+    }
+    void stop() {
+        printf("Transpose Stop\n");
+    }
+    void process() {
+        EventBlock::clear(out);
+        int n = EventBlock::take(in);
+        if (!n) return;
+        if (semitones != builtShift || scale != builtScale || root != builtRoot) buildTable();
+        for (int i = 0; i < n; i++) {
+            note_event_t e = EventBlock::get(in, i);
+            int note = e.data1 & 0x7F;
+            if (e.type == EVENT_NOTE_ON) {
+                // 同一个音重复按下: 先松开上一次映射到的音, 否则它再也收不到 NOTE_OFF
+                if (mapped[note] != 0xFF) emit(e.offset, EVENT_NOTE_OFF, e.channel, mapped[note], 0);
+                mapped[note] = table[note];
+                if (mapped[note] == 0xFF) continue;
+                e.data1 = mapped[note];
+            } else if (e.type == EVENT_NOTE_OFF) {
+                if (mapped[note] == 0xFF) continue;
+                e.data1 = mapped[note];
+                mapped[note] = 0xFF;
+            }
+            EventBlock::push(out, e);
+        }
+    }
+
+private:
+    static constexpr uint16_t scales[8] = {
+        0xFFF,  // 半音阶
+        0xAB5,  // 大调 0 2 4 5 7 9 11
+        0x5AD,  // 自然小调 0 2 3 5 7 8 10
+        0x295,  // 大调五声 0 2 4 7 9
+        0x4A9,  // 小调五声 0 3 5 7 10
+        0x6AD,  // 多利亚 0 2 3 5 7 9 10
+        0x9AD,  // 和声小调 0 2 3 5 7 8 11
+        0x4E9,  // 布鲁斯 0 3 5 6 7 10
+    };
+    uint8_t table[128];     // 输入音符 -> 输出音符, 0xFF = 超出范围
+    uint8_t mapped[128];    // 按住的音符实际发出的音
+    int builtShift = 1000, builtScale = -1, builtRoot = -1;
+
+    void buildTable() {
+        builtShift = semitones;
+        builtScale = scale;
+        builtRoot = root;
+        int shift = semitones < -48 ? -48 : (semitones > 48 ? 48 : semitones);
+        uint16_t mask = scales[scale < 0 || scale > 7 ? 0 : scale];
+        int r = ((root % 12) + 12) % 12;
+        for (int n = 0; n < 128; n++) {
+            int m = n + shift;
+            while (m >= 0 && !(mask & (1 << ((m - r + 120) % 12)))) m--;
+            table[n] = (m < 0 || m > 127) ? 0xFF : m;
+        }
+    }
+};
+
+// 和弦记忆: 每个按下的音展开为 Voices 个音 (相对 Intervals)
+// Learn = 1 时按住一个和弦再全部松开, 以最低音为根记下音程, 然后自动退出学习
+class ChordMemory: public EventFxModule {
+public:
+    ChordMemory() { module_info = {"chord memory", "libchara-dev", "Plays a stored chord for every note", false, false}; }
+
+    int voices = 3;
+    int intervals[CHORD_MAX_VOICES] = {0, 4, 7, 12};
+    int learn = 0;
+
+    void start() {
+        registerEventPorts();
+        registerParam(&voices, PARAM_INT, "Voices", "1 ~ 4");
+        registerParam(intervals, PARAM_ARY, "Intervals", "int[4], semitones from the played note");
+        registerParam(&learn, PARAM_INT, "Learn", "1: capture the next chord played");
+        memset(played, 0, sizeof(played));
+        printf("ChordMemory Start\n");
+    }
+    void stop() {
+        printf("ChordMemory Stop\n");
+    }
+    // 当前和弦; 学习完成后标注 learned
+    void printProfileDetail() {
+        int count = voices < 1 ? 1 : (voices > CHORD_MAX_VOICES ? CHORD_MAX_VOICES : voices);
+        printf("    chord: %d voices", count);
+        for (int v = 0; v < count; v++) {
+            printf(" %+d", intervals[v]);
+        }
+        printf("%s\n", learned ? " (learned)" : "");
+    }
+    void process() {
+        EventBlock::clear(out);
+        int n = EventBlock::take(in);
+        if (!n) return;
+        for (int i = 0; i < n; i++) {
+            note_event_t e = EventBlock::get(in, i);
+            int note = e.data1 & 0x7F;
+            if (learn) {
+                EventBlock::push(out, e);
+                learnEvent(e);
+                continue;
+            }
+            if (e.type == EVENT_NOTE_ON) {
+                int count = voices < 1 ? 1 : (voices > CHORD_MAX_VOICES ? CHORD_MAX_VOICES : voices);
+                // 重复按下先释放上一次的和弦
+                release(e.offset, e.channel, note);
+                for (int v = 0; v < count; v++) {
+                    int m = note + intervals[v];
+                    if (m < 0 || m > 127) continue;
+                    played[note][played[note][0] + 1] = m;
+                    played[note][0]++;
+                    emit(e.offset, EVENT_NOTE_ON, e.channel, m, e.data2);
+                }
+            } else if (e.type == EVENT_NOTE_OFF) {
+                release(e.offset, e.channel, note);
+            } else {
+                EventBlock::push(out, e);
+            }
+        }
+    }
+
+private:
+    uint8_t played[128][CHORD_MAX_VOICES + 1];  // [0] = 数量, 之后为发出的音
+    uint8_t learnNotes[CHORD_MAX_VOICES];
+    volatile bool learned = false;  // 音频线程不打印, 由 printProfileDetail 报告
+    int learnCount = 0;
+    int learnHeld = 0;
+
+    void release(uint8_t offset, uint8_t channel, int note) {
+        for (int v = 0; v < played[note][0]; v++) {
+            emit(offset, EVENT_NOTE_OFF, channel, played[note][v + 1], 0);
+        }
+        played[note][0] = 0;
+    }
+
+    void learnEvent(const note_event_t& e) {
+        if (e.type == EVENT_NOTE_ON) {
+            learnHeld++;
+            if (learnCount < CHORD_MAX_VOICES) learnNotes[learnCount++] = e.data1;
+        } else if (e.type == EVENT_NOTE_OFF && learnHeld > 0 && --learnHeld == 0 && learnCount) {
+            int lowest = learnNotes[0];
+            for (int v = 1; v < learnCount; v++) {
+                if (learnNotes[v] < lowest) lowest = learnNotes[v];
+            }
+            // 按音高排列
+            for (int v = 0; v < learnCount; v++) {
+                intervals[v] = learnNotes[v] - lowest;
+            }
+            for (int a = 1; a < learnCount; a++) {
+                for (int b = a; b > 0 && intervals[b] < intervals[b - 1]; b--) {
+                    int t = intervals[b];
+                    intervals[b] = intervals[b - 1];
+                    intervals[b - 1] = t;
+                }
+            }
+            voices = learnCount;
+            learnCount = 0;
+            learn = 0;
+            learned = true;
+        }
+    }
+};
+
+// 琶音器: 按住的音按模式与八度范围轮流发出
+// 节拍来自内部速度 (32.32 定点步长) 或输入中的 MIDI 时钟 (Sync = 1)
+// 没有按住的音且上一个音已松开时不做任何计时
+class Arpeggiator: public EventFxModule {
+public:
+    Arpeggiator() { module_info = {"arpeggiator", "libchara-dev", "Arpeggiator with octave range and tempo / MIDI clock sync", false, false}; }
+
+    int mode = 0;
+    int octaves = 1;
+    int rate = 4;       // 每拍步数
+    int tempo = 120;
+    int gateLength = 50;
+    int sync = 0;
+
+    void start() {
+        registerEventPorts();
+        registerParam(&mode, PARAM_INT, "Mode", "0:up 1:down 2:up-down 3:random 4:as played");
+        registerParam(&octaves, PARAM_INT, "Octaves", "1 ~ 4");
+        registerParam(&rate, PARAM_INT, "Rate", "steps per beat: 1 2 3 4 6 8");
+        registerParam(&tempo, PARAM_INT, "Tempo", "BPM (internal clock)");
+        registerParam(&gateLength, PARAM_INT, "Gate", "% of step");
+        registerParam(&sync, PARAM_INT, "Sync", "0:internal 1:MIDI clock");
+        printf("Arpeggiator Start\n");
+    }
+    void stop() {
+        printf("Arpeggiator Stop\n");
+    }
+    void process() {
+        EventBlock::clear(out);
+        int n = EventBlock::take(in);
+        if (!n && !count && !sounding) {
+            now += AUDIO_BLOCK_SIZE;
+            return;
+        }
+        updateTiming();
+        // 从 MIDI 时钟切回内部时钟时步进时间已过期, 从本块开始重新计时
+        if ((int64_t)(nextStep >> 32) < now) nextStep = (uint64_t)now << 32;
+        for (int i = 0; i < n; i++) {
+            note_event_t e = EventBlock::get(in, i);
+            runUntil(now + e.offset);
+            handle(e);
+        }
+        runUntil(now + AUDIO_BLOCK_SIZE);
+        now += AUDIO_BLOCK_SIZE;
+    }
+
+private:
+    // 按住的音, 按按下顺序
+    uint8_t order[ARP_MAX_NOTES];
+    uint8_t velocity[ARP_MAX_NOTES];
+    // 按音高排序
+    uint8_t sorted[ARP_MAX_NOTES];
+    uint8_t sortedVelocity[ARP_MAX_NOTES];
+    int count = 0;
+    uint8_t channel = 0;
+
+    int64_t now = 0;                // 本块首个采样的位置
+    uint64_t stepLength = 0;        // 32.32
+    uint64_t nextStep = 0;          // 32.32, 仅内部时钟
+    int64_t offAt = 0;
+    bool sounding = false;
+    int soundingNote = 0;
+    uint32_t index = 0;
+    uint32_t rng = 0x2545F491;
+    uint32_t clockTicks = 0;
+    int64_t lastClock = -1;
+    int64_t clockPeriod = 0;        // 最近两个 MIDI 时钟的间隔 (采样)
+
+    void updateTiming() {
+        int r = stepsPerBeat();
+        if (sync && clockPeriod > 0) {
+            stepLength = ((uint64_t)clockPeriod << 32) * (MIDI_CLOCK_PPQ / r);
+        } else {
+            int bpm = tempo < 20 ? 20 : (tempo > 300 ? 300 : tempo);
+            stepLength = ((uint64_t)SMP_RATE * 60 << 32) / ((uint64_t)bpm * r);
+        }
+    }
+
+    int stepsPerBeat() const {
+        // 只取能整除 24 的值, 使 MIDI 时钟同步时每步为整数个时钟
+        static const int valid[] = {1, 2, 3, 4, 6, 8};
+        int r = 1;
+        for (int v : valid) {
+            if (v <= rate) r = v;
+        }
+        return r;
+    }
+
+    // 依时间顺序处理 t 之前的步进与松开
+    void runUntil(int64_t t) {
+        for (;;) {
+            int64_t step = (!sync && count) ? (int64_t)(nextStep >> 32) : INT64_MAX;
+            int64_t off = sounding ? offAt : INT64_MAX;
+            int64_t at = step < off ? step : off;
+            if (at >= t) return;
+            if (off <= step) {
+                noteOff(at);
+            } else {
+                nextStep += stepLength;
+                doStep(at);
+            }
+        }
+    }
+
+    void handle(const note_event_t& e) {
+        int64_t t = now + e.offset;
+        if (e.type == EVENT_NOTE_ON) {
+            if (!count) {
+                // 从第一个音开始, 内部时钟对齐到按下的位置
+                index = 0;
+                nextStep = (uint64_t)t << 32;
+            }
+            channel = e.channel;
+            add(e.data1, e.data2);
+            runUntil(t + 1);
+        } else if (e.type == EVENT_NOTE_OFF) {
+            remove(e.data1);
+        } else if (e.type == EVENT_CLOCK) {
+            EventBlock::push(out, e);
+            if (lastClock >= 0) clockPeriod = t - lastClock;
+            lastClock = t;
+            if (sync && count && clockTicks++ % (MIDI_CLOCK_PPQ / stepsPerBeat()) == 0) {
+                updateTiming();
+                doStep(t);
+            }
+        } else if (e.type == EVENT_START) {
+            EventBlock::push(out, e);
+            clockTicks = 0;
+            index = 0;
+        } else {
+            EventBlock::push(out, e);
+        }
+    }
+
+    void noteOff(int64_t t) {
+        emit((uint8_t)(t - now), EVENT_NOTE_OFF, channel, soundingNote, 0);
+        sounding = false;
+    }
+
+    void doStep(int64_t t) {
+        if (sounding) noteOff(t);
+        int oct = octaves < 1 ? 1 : (octaves > 4 ? 4 : octaves);
+        uint32_t total = count * oct;
+        uint32_t pos;
+        switch (mode) {
+            case 1:
+                pos = total - 1 - index % total;
+                break;
+            case 2: {
+                uint32_t period = total > 1 ? 2 * total - 2 : 1;
+                uint32_t p = index % period;
+                pos = p < total ? p : period - p;
+                break;
+            }
+            case 3:
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                pos = rng % total;
+                break;
+            default:
+                pos = index % total;
+                break;
+        }
+        index++;
+        const uint8_t* notes = mode == 4 ? order : sorted;
+        const uint8_t* vels = mode == 4 ? velocity : sortedVelocity;
+        int note = notes[pos % count] + 12 * (pos / count);
+        if (note > 127) return;
+        emit((uint8_t)(t - now), EVENT_NOTE_ON, channel, note, vels[pos % count]);
+        sounding = true;
+        soundingNote = note;
+        int g = gateLength < 1 ? 1 : (gateLength > 100 ? 100 : gateLength);
+        offAt = t + (int64_t)((stepLength >> 32) * g / 100);
+        if (offAt <= t) offAt = t + 1;
+    }
+
+    void add(uint8_t note, uint8_t vel) {
+        for (int i = 0; i < count; i++) {
+            if (order[i] == note) return;
+        }
+        if (count >= ARP_MAX_NOTES) return;
+        order[count] = note;
+        velocity[count] = vel;
+        count++;
+        sortNotes();
+    }
+
+    void remove(uint8_t note) {
+        for (int i = 0; i < count; i++) {
+            if (order[i] != note) continue;
+            memmove(order + i, order + i + 1, count - i - 1);
+            memmove(velocity + i, velocity + i + 1, count - i - 1);
+            count--;
+            sortNotes();
+            return;
+        }
+    }
+
+    void sortNotes() {
+        memcpy(sorted, order, count);
+        memcpy(sortedVelocity, velocity, count);
+        for (int a = 1; a < count; a++) {
+            for (int b = a; b > 0 && sorted[b] < sorted[b - 1]; b--) {
+                uint8_t t = sorted[b];
+                sorted[b] = sorted[b - 1];
+                sorted[b - 1] = t;
+                t = sortedVelocity[b];
+                sortedVelocity[b] = sortedVelocity[b - 1];
+                sortedVelocity[b - 1] = t;
+            }
+        }
+    }
+};
+
+// 事件到单音控制信号, 接在事件链末端驱动振荡器 / 包络
+class NoteCvModule: public Module_t {
+public:
+    NoteCvModule() { module_info = {"note to cv", "libchara-dev", "Converts note events to gate, frequency and velocity", false, false}; }
+
+    int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t velocity[AUDIO_BLOCK_SIZE] = {};
+
+    void start() {
+        cv.begin();
+        registerPort(in, PORT_EIN, "EVENTS IN", "note events input");
+        registerPort(gate, PORT_DOUT, "GATE", "gate of the last note");
+        registerPort(freq, PORT_AOUT, "FREQ", "pitch of the last note (Hz)");
+        registerPort(velocity, PORT_AOUT, "VELOCITY", "velocity of the last note, Q15");
+        printf("NoteCv Start\n");
+    }
+    void stop() {
+        printf("NoteCv Stop\n");
+    }
+    void process() {
+        int n = EventBlock::take(in);
+        int pos = 0;
+        for (int i = 0; i < n; i++) {
+            note_event_t e = EventBlock::get(in, i);
+            cv.fill(gate, freq, velocity, pos, e.offset);
+            pos = e.offset;
+            cv.apply(e);
+        }
+        cv.fill(gate, freq, velocity, pos, AUDIO_BLOCK_SIZE);
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    MonoNoteCv cv;
+};
+
+// 空闲 (无事件) 与忙碌 (每块一个按下 / 松开, 琶音器 16 分音符 300 BPM) 两种情况
+inline void benchNoteFx(uint32_t blocks) {
+    auto feed = [](int16_t* in, uint32_t block) {
+        EventBlock::clear(in);
+        if (block % 8 == 0) EventBlock::push(in, note_event_t{5, EVENT_NOTE_ON, 0, (uint8_t)(48 + block / 8 % 12), 100});
+        if (block % 8 == 4) EventBlock::push(in, note_event_t{9, EVENT_NOTE_OFF, 0, (uint8_t)(48 + block / 8 % 12), 0});
+    };
+    benchModule<Arpeggiator>("arpeggiator idle", blocks, [](Arpeggiator&) {});
+    {
+        Arpeggiator m;
+        m.start();
+        m.tempo = 300;
+        m.octaves = 3;
+        int16_t held[AUDIO_BLOCK_SIZE];
+        EventBlock::clear(held);
+        for (int k = 0; k < 3; k++) EventBlock::push(held, note_event_t{0, EVENT_NOTE_ON, 0, (uint8_t)(48 + 4 * k), 100});
+        memcpy(m.in, held, sizeof(held));
+        m.process();
+        EventBlock::clear(m.in);
+        benchPrint(benchRun("arpeggiator 3 notes", blocks, AUDIO_BLOCK_SIZE, [&]() {
+            m.process();
+        }));
+        m.stop();
+    }
+    uint32_t b = 0;
+    benchModule<ChordMemory>("chord memory", blocks, [](ChordMemory&) {});
+    {
+        ChordMemory m;
+        m.start();
+        benchPrint(benchRun("chord memory busy", blocks, AUDIO_BLOCK_SIZE, [&]() {
+            feed(m.in, b++);
+            m.process();
+        }));
+        m.stop();
+    }
+    {
+        NoteTranspose m;
+        m.start();
+        m.scale = 1;
+        benchPrint(benchRun("transpose busy", blocks, AUDIO_BLOCK_SIZE, [&]() {
+            feed(m.in, b++);
+            m.process();
+        }));
+        m.stop();
+    }
+}
+
+#endif
@@ -271,32 +271,35 @@ public:
 
     noteEventModule() { module_info = {"Note Event", "libchara-dev", "A special module that outputs note event, frequency, and on/off status. (FreeRTOS only)", false, false}; }
 
-    int16_t note = 0;
-    int16_t freq = 0;   
-    int16_t status = false;
+    int16_t note[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t status[AUDIO_BLOCK_SIZE] = {};
     uint16_t timer = 0;
     key_event_t noteEvent;
 
     void start() {
-        registerPort(&note, PORT_DOUT, "NOTE", "note event output");
-        registerPort(&freq, PORT_AOUT, "FREQ", "frequency output");
-        registerPort(&status, PORT_DOUT, "STATUS", "Note status (bool)");
+        registerPort(note, PORT_DOUT, "NOTE", "note event output");
+        registerPort(freq, PORT_AOUT, "FREQ", "frequency output");
+        registerPort(status, PORT_DOUT, "STATUS", "Note status (bool)");
     }
     void stop() {
         printf("Note Event Stop\n");
     }
     void process() {
-        if (!(timer & 15)) {
-            if (readNoteEvent == pdTRUE) {
-                if (noteEvent.status == KEY_ATTACK) {
-                    status = true;
-                } else if (noteEvent.status == KEY_RELEASE) {
-                    status = false;
-                }
-                note = noteEvent.num;
-                freq = midi2freq_int[note];
+        // 每块读取一次事件
+        if (readNoteEvent == pdTRUE) {
+            if (noteEvent.status == KEY_ATTACK) {
+                status[0] = true;
+            } else if (noteEvent.status == KEY_RELEASE) {
+                status[0] = false;
             }
-            
+            note[0] = noteEvent.num;
+            freq[0] = midi2freq_int[note[0]];
+        }
+        for (int i = 1; i < AUDIO_BLOCK_SIZE; i++) {
+            status[i] = status[0];
+            note[i] = note[0];
+            freq[i] = freq[0];
         }
         timer++;
     }
@@ -0,0 +1,206 @@
+#ifndef OVERSAMPLER_H
+#define OVERSAMPLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <array>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "dsp_kernels.h"
+#include "src_config.h"
+
+// 31 阶半带 FIR (等波纹设计, 通带 0~0.2fs, 阻带 0.3fs 起 -51dB)
+// 半带滤波器除中心抽头 (0.5) 外偶数位置均为 0, 这里只存奇数位置的单侧系数,
+// 以 Q15 表示 2 倍值, 总和为 16384 (0.5); 累加使用 64 位以免极端输入溢出
+#define HB_TAPS 8
+#define HB_HISTORY (HB_TAPS * 2 - 1)
+const int16_t halfband_coef[HB_TAPS] = {20743, -6467, 3386, -1957, 1131, -619, 305, -138};
+
+// 展开成 16 个连续抽头 (c7 .. c0 c0 .. c7), 奇相位即一次 16 点 Dsp::dot; 对齐以便 S3 走 PIE
+DSP_ALIGN const int16_t halfband_dot_coef[HB_TAPS * 2] = {
+    -138, 305, -619, 1131, -1957, 3386, -6467, 20743,
+    20743, -6467, 3386, -1957, 1131, -619, 305, -138,
+};
+
+static inline int16_t hbSaturate(int64_t v) {
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+}
+
+// 2 倍插值: 偶相位为延迟的输入, 奇相位为对称系数的点积
+class HalfBandUpsampler {
+public:
+    // 输入 n 个采样, 输出 2n 个, n 不超过 AUDIO_BLOCK_SIZE * 2
+    void process(const int16_t* in, int n, int16_t* out) {
+        int16_t work[HB_HISTORY + AUDIO_BLOCK_SIZE * 2];
+        memcpy(work, history, sizeof(history));
+        memcpy(work + HB_HISTORY, in, n * sizeof(int16_t));
+        for (int i = 0; i < n; i++) {
+            // x 指向本次输出对应的最老样本, 奇相位位于 x[HB_TAPS - 1] 与 x[HB_TAPS] 之间
+            const int16_t* x = work + i;
+            int64_t acc = (1 << 14) + Dsp::dot(x, halfband_dot_coef, HB_TAPS * 2);
+            out[i * 2] = x[HB_TAPS - 1];
+            out[i * 2 + 1] = hbSaturate(acc >> 15);
+        }
+        memcpy(history, work + n, sizeof(history));
+    }
+
+    void reset() {
+        memset(history, 0, sizeof(history));
+    }
+
+private:
+    int16_t history[HB_HISTORY] = {};
+};
+
+// 2 倍抽取: 只计算保留下来的输出, 中心抽头 0.5 加奇数位置的对称系数
+// 奇数位置的抽头全部落在奇数下标上, 先拆出奇数相位, 每个输出就是一次连续的 16 点点积
+class HalfBandDownsampler {
+public:
+    // 输入 n 个采样 (n 为偶数), 输出 n / 2 个
+    void process(const int16_t* in, int n, int16_t* out) {
+        int16_t work[HB_HISTORY * 2 + AUDIO_BLOCK_SIZE * 4];
+        int16_t odd[HB_HISTORY + AUDIO_BLOCK_SIZE * 2];
+        memcpy(work, history, sizeof(history));
+        memcpy(work + HB_HISTORY * 2, in, n * sizeof(int16_t));
+        for (int m = 0; m < HB_HISTORY + n / 2; m++) {
+            odd[m] = work[m * 2 + 1];
+        }
+        for (int i = 0; i < n / 2; i++) {
+            // 中心样本 work[2i + 16], 与插值器合计为整数样本延迟; 两侧奇数位置为 odd[i .. i + 15]
+            int64_t acc = ((int32_t)work[i * 2 + HB_HISTORY + 1] << 15) + (1 << 15);
+            acc += Dsp::dot(odd + i, halfband_dot_coef, HB_TAPS * 2);
+            out[i] = hbSaturate(acc >> 16);
+        }
+        memcpy(history, work + n, sizeof(history));
+    }
+
+    void reset() {
+        memset(history, 0, sizeof(history));
+    }
+
+private:
+    int16_t history[HB_HISTORY * 2] = {};
+};
+
+// 过采样包装: 以 FACTOR 倍采样率运行内部模块, 端口与参数原样映射到外部
+// 模拟输入经半带插值, 数字输入 (门限等) 做零阶保持; 输出对应抽取或取样
+template<typename T, int FACTOR>
+class Oversampled: public Module_t {
+public:
+    static_assert(FACTOR == 2 || FACTOR == 4, "Oversampling factor must be 2 or 4");
+    static const int STAGES = FACTOR == 4 ? 2 : 1;
+    static const int OS_BLOCK = AUDIO_BLOCK_SIZE * FACTOR;
+
+    typedef std::array<int16_t, AUDIO_BLOCK_SIZE> block_t;
+    typedef std::array<int16_t, OS_BLOCK> os_block_t;
+
+    T inner;
+
+    Oversampled() {
+        module_info = inner.module_info;
+        snprintf(module_info.name, sizeof(module_info.name), "%s x%d", inner.module_info.name, FACTOR);
+    }
+
+    void start() {
+        inner.sampleRate = sampleRate * FACTOR;
+        inner.start();
+        PortManager& ports = inner.portManager;
+        inputs.resize(ports.getInputPortCount());
+        outputs.resize(ports.getOutputPortCount());
+        inputStaging.resize(inputs.size());
+        outputStaging.resize(outputs.size());
+        upsamplers.resize(inputs.size());
+        downsamplers.resize(outputs.size());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            inputs[i].fill(0);
+            registerPort(inputs[i].data(), ports.inputPorts[i].type, ports.inputPorts[i].name, ports.inputPorts[i].profile);
+        }
+        for (size_t i = 0; i < outputs.size(); i++) {
+            outputs[i].fill(0);
+            registerPort(outputs[i].data(), ports.outputPorts[i].type, ports.outputPorts[i].name, ports.outputPorts[i].profile);
+        }
+        for (int i = 0; i < inner.paramManager.getParamCount(); i++) {
+            param_t& param = inner.paramManager.params[i];
+            registerParam(param.data, param.type, param.name, param.profile);
+        }
+        printf("Oversampled x%d start, inner rate %lu\n", FACTOR, (unsigned long)inner.sampleRate);
+    }
+    void stop() {
+        inner.stop();
+    }
+    void process() {
+        PortManager& ports = inner.portManager;
+        uint32_t t0 = perf_ticks();
+
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (ports.inputPorts[i].type == PORT_DIN) {
+                for (int j = 0; j < OS_BLOCK; j++) {
+                    inputStaging[i][j] = inputs[i][j / FACTOR];
+                }
+            } else if (STAGES == 1) {
+                upsamplers[i][0].process(inputs[i].data(), AUDIO_BLOCK_SIZE, inputStaging[i].data());
+            } else {
+                int16_t mid[AUDIO_BLOCK_SIZE * 2];
+                upsamplers[i][0].process(inputs[i].data(), AUDIO_BLOCK_SIZE, mid);
+                upsamplers[i][1].process(mid, AUDIO_BLOCK_SIZE * 2, inputStaging[i].data());
+            }
+        }
+
+        uint32_t innerTicks = 0;
+        for (int k = 0; k < FACTOR; k++) {
+            for (size_t i = 0; i < inputs.size(); i++) {
+                memcpy(ports.inputPorts[i].data, inputStaging[i].data() + k * AUDIO_BLOCK_SIZE, sizeof(block_t));
+            }
+            uint32_t t1 = perf_ticks();
+            inner.process();
+            innerTicks += perf_ticks() - t1;
+            for (size_t i = 0; i < outputs.size(); i++) {
+                memcpy(outputStaging[i].data() + k * AUDIO_BLOCK_SIZE, ports.outputPorts[i].data, sizeof(block_t));
+            }
+        }
+        inner.profile.add(innerTicks);
+
+        for (size_t i = 0; i < outputs.size(); i++) {
+            if (ports.outputPorts[i].type == PORT_DOUT) {
+                for (int j = 0; j < AUDIO_BLOCK_SIZE; j++) {
+                    outputs[i][j] = outputStaging[i][j * FACTOR];
+                }
+            } else if (STAGES == 1) {
+                downsamplers[i][0].process(outputStaging[i].data(), OS_BLOCK, outputs[i].data());
+            } else {
+                int16_t mid[AUDIO_BLOCK_SIZE * 2];
+                downsamplers[i][0].process(outputStaging[i].data(), OS_BLOCK, mid);
+                downsamplers[i][1].process(mid, AUDIO_BLOCK_SIZE * 2, outputs[i].data());
+            }
+        }
+        filterProfile.add(perf_ticks() - t0 - innerTicks);
+    }
+    void printProfileDetail() {
+        printf("    resampling filters: %6.1fus/block\n", filterProfile.averageUs());
+        printf("    %-18s %6.1fus/block (x%d rate)\n", inner.module_info.name, inner.profile.averageUs(), FACTOR);
+    }
+    void resetProfile() {
+        Module_t::resetProfile();
+        filterProfile = {};
+        inner.profile = {};
+    }
+    void customSettingPage() {
+        inner.customSettingPage();
+    }
+    void customViewPage() {
+        inner.customViewPage();
+    }
+
+private:
+    std::vector<block_t> inputs;
+    std::vector<block_t> outputs;
+    std::vector<os_block_t> inputStaging;
+    std::vector<os_block_t> outputStaging;
+    std::vector<std::array<HalfBandUpsampler, STAGES>> upsamplers;
+    std::vector<std::array<HalfBandDownsampler, STAGES>> downsamplers;
+    module_profile_t filterProfile;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef PLATFORM_COMPAT_H
+#define PLATFORM_COMPAT_H
+
+// 在主机上编译 (PlatformIO native 环境) 时替代少量 ESP-IDF / FreeRTOS 接口
+#ifdef ESP_PLATFORM
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+
+// 大块音频缓冲优先放在 PSRAM, 不足时退回内部 RAM
+static inline void* psram_malloc(size_t size) {
+    void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return p ? p : malloc(size);
+}
+
+static inline void psram_free(void* p) {
+    heap_caps_free(p);
+}
+
+// 性能计数: 目标板上为 CPU 周期, 每个核心的计数器独立, 只在固定核心的任务中求差值
+#define PERF_TICKS_PER_US CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+
+static inline uint32_t perf_ticks() {
+    return esp_cpu_get_cycle_count();
+}
+
+#else
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+
+#define IRAM_ATTR
+
+typedef struct {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) while ((mux)->flag.test_and_set(std::memory_order_acquire)) {}
+#define portEXIT_CRITICAL(mux) (mux)->flag.clear(std::memory_order_release)
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+
+inline int64_t esp_timer_get_time() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+static inline void* psram_malloc(size_t size) {
+    return malloc(size);
+}
+
+static inline void psram_free(void* p) {
+    free(p);
+}
+
+// 性能计数: 主机上为纳秒, 只用于求差值
+#define PERF_TICKS_PER_US 1000
+
+static inline uint32_t perf_ticks() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "bench.h"
+#include "src_config.h"
+
+typedef enum {
+    RESAMPLE_LINEAR,
+    RESAMPLE_HERMITE,   // 4 点 3 阶 Hermite
+    RESAMPLE_SINC       // 8 点加窗 sinc, 多相查表
+} resample_quality_t;
+
+// 加窗 sinc 多相表: 每个相位 8 个 Q14 系数, 对应 x[-3] ~ x[4]
+// 升调 (步长 > 1) 时截止频率需按 1 / ratio 降低, 否则原信号高频折叠回来;
+// 按半个八度分档各存一张表, 第 b 档用于 ratio <= 2^(b/2), 截止为 0.9 / 2^(b/2)
+#define SINC_TAPS 8
+#define SINC_PHASE_BITS 8
+#define SINC_PHASES (1 << SINC_PHASE_BITS)
+#define SINC_BANDS 5
+
+class FracResampler {
+public:
+    // 位置均为 32.32 定点 (高 32 位为整数样本, 低 32 位为小数)
+    // p 指向 x[0], 需保证 x[-3] ~ x[4] 可读
+
+    static inline int16_t linear(const int16_t* p, uint32_t frac) {
+        int32_t t = frac >> 17; // Q15
+        return p[0] + (((p[1] - p[0]) * t) >> 15);
+    }
+
+    static inline int16_t hermite(const int16_t* p, uint32_t frac) {
+        int32_t t = frac >> 17; // Q15
+        // 系数均为 2 倍值以避免小数
+        int32_t c1 = p[1] - p[-1];
+        int32_t c2 = 2 * p[-1] - 5 * p[0] + 4 * p[1] - p[2];
+        int32_t c3 = (p[2] - p[-1]) + 3 * (p[0] - p[1]);
+        int64_t y = ((int64_t)c3 * t) >> 15;
+        y = ((y + c2) * t) >> 15;
+        y = ((y + c1) * t) >> 16;
+        return saturate(p[0] + y);
+    }
+
+    static inline int16_t sinc(const int16_t* p, uint32_t frac) {
+        return sincBand(p, frac, sincTable[0]);
+    }
+
+    static inline int16_t sincBand(const int16_t* p, uint32_t frac, const int16_t (*table)[SINC_TAPS]) {
+        const int16_t* h = table[frac >> (32 - SINC_PHASE_BITS)];
+        const int16_t* x = p - (SINC_TAPS / 2 - 1);
+        int32_t acc = 1 << 13;
+        for (int k = 0; k < SINC_TAPS; k++) {
+            acc += h[k] * x[k];
+        }
+        return saturate(acc >> 14);
+    }
+
+    // 块接口: 从 src 的 pos 处开始, 每输出一个样本前进 step, 生成 n 个样本
+    // 质量选择与 sinc 分档在循环外完成, 内层循环只做插值
+    static void render(resample_quality_t quality, const int16_t* src, uint64_t& pos, uint64_t step, int16_t* out, int n) {
+        switch (quality) {
+            case RESAMPLE_LINEAR:
+                renderLoop<linear>(src, pos, step, out, n);
+                break;
+            case RESAMPLE_HERMITE:
+                renderLoop<hermite>(src, pos, step, out, n);
+                break;
+            default:
+                renderSinc(sincTable[sincBandFor(step)], src, pos, step, out, n);
+                break;
+        }
+    }
+
+    // 步长对应的 sinc 档位
+    static int sincBandFor(uint64_t step) {
+        int band = 0;
+        while (band < SINC_BANDS - 1 && step > bandLimit[band]) {
+            band++;
+        }
+        return band;
+    }
+
+    // 生成多相表, 启动时调用一次
+    static void initTables() {
+        if (tablesReady) return;
+        for (int band = 0; band < SINC_BANDS; band++) {
+            // 略低于奈奎斯特以减少镜像, 升调档位再按比例降低
+            initBand(sincTable[band], 0.9f / powf(2.0f, band * 0.5f));
+        }
+        tablesReady = true;
+    }
+
+    static int16_t saturate(int32_t v) {
+        return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+
+private:
+    static int16_t sincTable[SINC_BANDS][SINC_PHASES][SINC_TAPS];
+    static const uint64_t bandLimit[SINC_BANDS - 1];
+    static bool tablesReady;
+
+    static void initBand(int16_t (*table)[SINC_TAPS], float cutoff) {
+        for (int ph = 0; ph < SINC_PHASES; ph++) {
+            float frac = (float)ph / SINC_PHASES;
+            float coef[SINC_TAPS];
+            float sum = 0;
+            for (int k = 0; k < SINC_TAPS; k++) {
+                float x = (k - (SINC_TAPS / 2 - 1)) - frac;
+                float s = x == 0 ? 1.0f : sinf(M_PI * cutoff * x) / (M_PI * cutoff * x);
+                // Blackman 窗, 窗长覆盖 [-4, 4]
+                float w = 0.42f + 0.5f * cosf(M_PI * x / (SINC_TAPS / 2)) + 0.08f * cosf(2 * M_PI * x / (SINC_TAPS / 2));
+                coef[k] = s * w;
+                sum += coef[k];
+            }
+            // 每个相位归一化为单位直流增益
+            for (int k = 0; k < SINC_TAPS; k++) {
+                table[ph][k] = (int16_t)lrintf(coef[k] / sum * 16384);
+            }
+        }
+    }
+
+    template<int16_t (*interp)(const int16_t*, uint32_t)>
+    static void renderLoop(const int16_t* src, uint64_t& pos, uint64_t step, int16_t* out, int n) {
+        uint64_t p = pos;
+        for (int i = 0; i < n; i++) {
+            out[i] = interp(src + (p >> 32), (uint32_t)p);
+            p += step;
+        }
+        pos = p;
+    }
+
+    static void renderSinc(const int16_t (*table)[SINC_TAPS], const int16_t* src, uint64_t& pos, uint64_t step, int16_t* out, int n) {
+        uint64_t p = pos;
+        for (int i = 0; i < n; i++) {
+            out[i] = sincBand(src + (p >> 32), (uint32_t)p, table);
+            p += step;
+        }
+        pos = p;
+    }
+};
+
+int16_t FracResampler::sincTable[SINC_BANDS][SINC_PHASES][SINC_TAPS];
+// 档位上限 (32.32 步长): 1, sqrt(2), 2, 2 * sqrt(2)
+const uint64_t FracResampler::bandLimit[SINC_BANDS - 1] = {0x100000000ull, 0x16A09E668ull, 0x200000000ull, 0x2D413CCD0ull};
+bool FracResampler::tablesReady = false;
+
+// 变速/移调模块: 输入写入环形缓冲, 读头按 RATIO 速度移动
+// 读头追上或落后写头过多时跳过半个窗口, 并在两个读头之间交叉淡化
+class ResamplerModule: public Module_t {
+public:
+    static const int WINDOW = 1024;       // 环形缓冲长度 (2 的幂)
+    static const int FADE = 64;           // 跳头时的交叉淡化长度
+    static const int RATIO_ONE = 4096;    // RATIO 端口 Q12, 4096 = 1.0
+    static const int RATIO_MIN = RATIO_ONE / 4;
+    static const int RATIO_MAX = RATIO_ONE * 4;
+
+    ResamplerModule() { module_info = {"resampler", "libchara-dev", "Fractional resampler / pitch shifter (linear, hermite, sinc)", false, false}; }
+
+    int16_t in[AUDIO_BLOCK_SIZE] = {};
+    int16_t ratio[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int quality = RESAMPLE_HERMITE;
+
+    void start() {
+        FracResampler::initTables();
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            ratio[i] = RATIO_ONE;
+        }
+        registerPort(in, PORT_AIN, "INPUT", "signal input");
+        registerPort(ratio, PORT_AIN, "RATIO", "pitch ratio, Q12 (4096 = 1.0)");
+        registerPort(out, PORT_AOUT, "OUTPUT", "resampled output");
+        registerParam(&quality, PARAM_INT, "Quality", "0:linear 1:hermite 2:sinc");
+        printf("Resampler Start\n");
+    }
+    void stop() {
+        printf("Resampler Stop\n");
+    }
+    void process() {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            ring[writeIndex & (WINDOW - 1)] = in[i];
+            writeIndex++;
+        }
+        resample_quality_t q = (resample_quality_t)(quality < 0 ? 0 : (quality > RESAMPLE_SINC ? RESAMPLE_SINC : quality));
+        // 每块检查一次读头距离: 一块内读头相对写头最多移动 3 * AUDIO_BLOCK_SIZE 个样本, 留有余量
+        int32_t distance = (int32_t)(writeIndex - (uint32_t)(headA >> 32));
+        if (fade == 0 && (distance < WINDOW / 4 || distance > WINDOW * 3 / 4)) {
+            // 离写头过近时后退半窗, 过远时前进半窗
+            headB = headA;
+            headA += distance < WINDOW / 4 ? -((uint64_t)(WINDOW / 2) << 32) : ((uint64_t)(WINDOW / 2) << 32);
+            fade = FADE;
+        }
+        renderHead(q, headA, out);
+        if (fade > 0) {
+            int16_t yb[AUDIO_BLOCK_SIZE];
+            renderHead(q, headB, yb);
+            for (int i = 0; i < AUDIO_BLOCK_SIZE && fade > 0; i++, fade--) {
+                out[i] = (out[i] * (FADE - fade) + yb[i] * fade) / FADE;
+            }
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    // 一块内读头覆盖的最大样本数 (含插值窗口)
+    static const int SPAN = RATIO_MAX / RATIO_ONE * AUDIO_BLOCK_SIZE + SINC_TAPS + 1;
+
+    int16_t ring[WINDOW] = {};
+    uint32_t writeIndex = WINDOW / 2;
+    uint64_t headA = 0;
+    uint64_t headB = 0;
+    int fade = 0;
+
+    // 把读头本块覆盖的区间从环形缓冲拷成连续数组, 按 RATIO 相同的连续段调用块插值
+    void renderHead(resample_quality_t q, uint64_t& head, int16_t* dst) {
+        int16_t span[SPAN];
+        uint32_t base = (uint32_t)(head >> 32) - (SINC_TAPS / 2 - 1);
+        for (int k = 0; k < SPAN; k++) {
+            span[k] = ring[(base + k) & (WINDOW - 1)];
+        }
+        uint64_t start = head & 0xFFFFFFFFull;
+        uint64_t pos = start;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE;) {
+            int j = i + 1;
+            while (j < AUDIO_BLOCK_SIZE && ratio[j] == ratio[i]) j++;
+            int32_t r = ratio[i] < RATIO_MIN ? RATIO_MIN : (ratio[i] > RATIO_MAX ? RATIO_MAX : ratio[i]);
+            FracResampler::render(q, span + (SINC_TAPS / 2 - 1), pos, (uint64_t)r << 20, dst + i, j - i); // Q12 -> 32.32
+            i = j;
+        }
+        head += pos - start;
+    }
+};
+
+// 各质量档位下单实例耗时, 以 1.5 倍移调处理锯齿波
+inline void benchResampler(uint32_t blocks) {
+    static const char* names[] = {"resampler linear", "resampler hermite", "resampler sinc"};
+    for (int q = RESAMPLE_LINEAR; q <= RESAMPLE_SINC; q++) {
+        benchModule<ResamplerModule>(names[q], blocks, [q](ResamplerModule& m) {
+            m.quality = q;
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m.in[i] = i * 1024 - 32768;
+                m.ratio[i] = ResamplerModule::RATIO_ONE * 3 / 2;
+            }
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef REVERB_H
+#define REVERB_H
+
+#include <stdint.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "delay_line.h"
+#include "delay.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define FDN_LINES 8
+#define FDN_MAX_LINE 8192
+#define REVERB_MAX_PREDELAY_MS 500
+
+// 8 路反馈延迟网络混响, Householder 反馈矩阵 (x - 2/N * sum), 每路带阻尼低通
+// 每路最短延迟大于一块, 因此每块先从 PSRAM 整块读出各路输出, 计算后整块写回
+class FdnReverb: public Module_t {
+public:
+    FdnReverb() { module_info = {"reverb", "libchara-dev", "8-line FDN reverb in PSRAM", false, false}; }
+
+    int16_t inL[AUDIO_BLOCK_SIZE] = {};
+    int16_t inR[AUDIO_BLOCK_SIZE] = {};
+    int16_t outL[AUDIO_BLOCK_SIZE] = {};
+    int16_t outR[AUDIO_BLOCK_SIZE] = {};
+    int decayMs = 2500;     // RT60
+    int damping = 12000;    // Q15
+    int size = 100;         // 延迟长度比例 (%), 50 ~ 200
+    int predelayMs = 20;
+    int mix = 10000;        // Q15
+
+    void start() {
+        for (int k = 0; k < FDN_LINES; k++) {
+            lines[k] = new PsramDelayLine(FDN_MAX_LINE);
+        }
+        predelay = new PsramDelayLine((uint32_t)((uint64_t)REVERB_MAX_PREDELAY_MS * sampleRate / 1000) + AUDIO_BLOCK_SIZE);
+        ready = predelay->valid();
+        for (int k = 0; k < FDN_LINES; k++) {
+            ready = ready && lines[k]->valid();
+        }
+        if (!ready) {
+            printf("Reverb: PSRAM allocation failed\n");
+        }
+        registerPort(inL, PORT_AIN, "IN L", "left input");
+        registerPort(inR, PORT_AIN, "IN R", "right input");
+        registerPort(outL, PORT_AOUT, "OUT L", "left output");
+        registerPort(outR, PORT_AOUT, "OUT R", "right output");
+        registerParam(&decayMs, PARAM_INT, "Decay", "RT60 (ms)");
+        registerParam(&damping, PARAM_INT, "Damping", "high frequency damping, Q15");
+        registerParam(&size, PARAM_INT, "Size", "room size (%), 50 ~ 200");
+        registerParam(&predelayMs, PARAM_INT, "Predelay", "pre-delay (ms)");
+        registerParam(&mix, PARAM_INT, "Mix", "wet level, Q15");
+        printf("Reverb Start\n");
+    }
+    void stop() {
+        for (int k = 0; k < FDN_LINES; k++) {
+            delete lines[k];
+            lines[k] = nullptr;
+        }
+        delete predelay;
+        predelay = nullptr;
+        printf("Reverb Stop\n");
+    }
+    void process() {
+        if (!ready) {
+            memcpy(outL, inL, sizeof(outL));
+            memcpy(outR, inR, sizeof(outR));
+            return;
+        }
+        updateParams();
+
+        // 预延迟: 先写后读, 任意延迟都不会读到未写入的数据
+        int16_t mono[AUDIO_BLOCK_SIZE];
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            mono[i] = (inL[i] + inR[i]) >> 1;
+        }
+        predelay->write(mono, AUDIO_BLOCK_SIZE);
+        predelay->fetch(predelay->position() - AUDIO_BLOCK_SIZE - predelaySamples, mono, AUDIO_BLOCK_SIZE);
+
+        // 各路输出整块取回内部 SRAM
+        for (int k = 0; k < FDN_LINES; k++) {
+            lines[k]->fetch(lines[k]->position() - lengths[k], taps[k], AUDIO_BLOCK_SIZE);
+        }
+
+        int32_t damp = 32767 - damping;
+        damp = damp < 0 ? 0 : (damp > 32767 ? 32767 : damp);
+        int32_t wet = mix < 0 ? 0 : (mix > 32767 ? 32767 : mix), dry = 32767 - wet;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            int32_t v[FDN_LINES];
+            int32_t sum = 0;
+            for (int k = 0; k < FDN_LINES; k++) {
+                lp[k] += ((taps[k][i] - lp[k]) * damp) >> 15;
+                v[k] = (lp[k] * gains[k]) >> 15;
+                sum += v[k];
+            }
+            // Householder: 反馈 = v - 2/N * sum, 输入交替正负注入
+            int32_t h = sum >> 2;
+            int32_t x = mono[i] >> 2;
+            for (int k = 0; k < FDN_LINES; k++) {
+                taps[k][i] = FracResampler::saturate(v[k] - h + ((k & 1) ? -x : x));
+            }
+            int32_t yl = (v[0] - v[2] + v[4] - v[6]) >> 1;
+            int32_t yr = (v[1] - v[3] + v[5] - v[7]) >> 1;
+            outL[i] = FracResampler::saturate((inL[i] * dry + yl * wet) >> 15);
+            outR[i] = FracResampler::saturate((inR[i] * dry + yr * wet) >> 15);
+        }
+
+        for (int k = 0; k < FDN_LINES; k++) {
+            lines[k]->write(taps[k], AUDIO_BLOCK_SIZE);
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    // 互质的基础长度 (采样), 按 Size 缩放
+    static constexpr uint16_t baseLengths[FDN_LINES] = {1031, 1327, 1523, 1801, 2053, 2339, 2617, 2903};
+
+    PsramDelayLine* lines[FDN_LINES] = {};
+    PsramDelayLine* predelay = nullptr;
+    int16_t taps[FDN_LINES][AUDIO_BLOCK_SIZE];
+    int32_t lp[FDN_LINES] = {};
+    uint32_t lengths[FDN_LINES] = {};
+    int32_t gains[FDN_LINES] = {};
+    uint32_t predelaySamples = 0;
+    bool ready = false;
+    int cachedDecay = -1, cachedSize = -1, cachedPredelay = -1;
+
+    // 参数变化时才重算长度与每路衰减增益 g = 10^(-3 * len / (RT60 * fs))
+    void updateParams() {
+        if (decayMs == cachedDecay && size == cachedSize && predelayMs == cachedPredelay) return;
+        cachedDecay = decayMs;
+        cachedSize = size;
+        cachedPredelay = predelayMs;
+        int s = size < 50 ? 50 : (size > 200 ? 200 : size);
+        float rt60 = (decayMs < 100 ? 100 : decayMs) / 1000.0f;
+        for (int k = 0; k < FDN_LINES; k++) {
+            lengths[k] = baseLengths[k] * s / 100;
+            if (lengths[k] > FDN_MAX_LINE - AUDIO_BLOCK_SIZE) lengths[k] = FDN_MAX_LINE - AUDIO_BLOCK_SIZE;
+            float g = powf(10.0f, -3.0f * lengths[k] / (rt60 * sampleRate));
+            gains[k] = (int32_t)(g * 32767);
+        }
+        int pd = predelayMs < 0 ? 0 : (predelayMs > REVERB_MAX_PREDELAY_MS ? REVERB_MAX_PREDELAY_MS : predelayMs);
+        predelaySamples = (uint32_t)((uint64_t)pd * sampleRate / 1000);
+    }
+};
+
+constexpr uint16_t FdnReverb::baseLengths[FDN_LINES];
+
+// 立体声延迟 (带时间调制) 与混响的单实例耗时
+inline void benchDelayReverb(uint32_t blocks) {
+    benchModule<StereoDelay>("stereo delay", blocks, [](StereoDelay& m) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            m.inL[i] = i * 512 - 16384;
+            m.inR[i] = 16384 - i * 512;
+            m.timeMod[i] = (i * 37) & 0x3FF;
+        }
+        m.pingPong = 1;
+    });
+    benchModule<FdnReverb>("fdn reverb", blocks, [](FdnReverb& m) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            m.inL[i] = i * 512 - 16384;
+            m.inR[i] = 16384 - i * 512;
+        }
+    });
+}
+
+#endif
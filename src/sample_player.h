@@ -0,0 +1,413 @@
+#ifndef SAMPLE_PLAYER_H
+#define SAMPLE_PLAYER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "spsc_ring.h"
+#include "sample_source.h"
+#include "resampler.h"
+#include "src_config.h"
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#include <chrono>
+#endif
+
+#define SAMPLE_MAX_VOICES 4
+#define SAMPLE_HEAD_FRAMES 8192   // 常驻内存的起始部分, 覆盖预读任务的启动延迟
+#define SAMPLE_RING_FRAMES 8192   // 每个声部的预读缓冲 (PSRAM)
+#define SAMPLE_CHUNK_FRAMES 1024  // 预读任务单次读取量
+#define SAMPLE_LOCAL_FRAMES (AUDIO_BLOCK_SIZE * 4 + SINC_TAPS * 2)
+
+// 已加载的采样: 数据源加常驻的起始部分
+struct SampleData {
+    SampleSource* source = nullptr;
+    int16_t* head = nullptr;
+    size_t headFrames = 0;
+    size_t frames = 0;
+
+    ~SampleData() {
+        delete source;
+        psram_free(head);
+    }
+};
+
+// 声部状态. 音频线程修改 generation 发起播放/停止, 预读任务响应后写 ack;
+// ack 与 generation 相等前音频线程不读取 ring
+struct SampleVoice {
+    // 音频线程写, 在 generation 之前发布
+    std::atomic<SampleData*> sample{nullptr};
+    std::atomic<size_t> loopStart{0};
+    std::atomic<size_t> loopEnd{0};
+    std::atomic<size_t> fetchStart{0};
+    std::atomic<bool> loop{false};
+    std::atomic<uint32_t> generation{0};
+
+    // 预读任务写
+    std::atomic<uint32_t> ack{0};
+    std::atomic<bool> streamEnd{false};
+
+    // 仅预读任务使用, 响应 generation 时从上面复制
+    SampleData* fetchSample = nullptr;
+    size_t fetchLoopStart = 0;
+    size_t fetchLoopEnd = 0;
+    size_t fetchFrame = 0;
+    bool fetching = false;
+
+    SpscRing<int16_t> ring{SAMPLE_RING_FRAMES, true};
+
+    // 仅音频线程使用
+    bool playing = false;
+    uint32_t age = 0;
+    size_t streamFrame = 0;     // 下一个要拉取的逻辑帧
+    size_t headLimit = 0;       // 前 headLimit 帧从常驻部分读取
+    SampleData* playSample = nullptr;
+    int16_t local[SAMPLE_LOCAL_FRAMES];
+    int localCount = 0;         // local 中已有样本数
+    int validCount = 0;         // 其中真实数据 (其余为结束后的补零)
+    bool ended = false;
+    uint64_t pos = 0;           // 相对 local[SINC_TAPS / 2 - 1] 的 32.32 位置
+};
+
+class SamplePlayer;
+
+// 所有采样播放模块共用的预读任务, 优先级低于音频引擎
+class SamplePrefetcher {
+public:
+    static SamplePrefetcher& instance() {
+        static SamplePrefetcher prefetcher;
+        return prefetcher;
+    }
+
+    void add(SamplePlayer* player) {
+        std::lock_guard<std::mutex> guard(lock);
+        players.push_back(player);
+        if (!running) {
+            running = true;
+#ifdef ESP_PLATFORM
+            xTaskCreatePinnedToCore(taskEntry, "Sample prefetch", 4096, this, 1, NULL, 0);
+#else
+            std::thread(taskEntry, this).detach();
+#endif
+        }
+    }
+
+    void remove(SamplePlayer* player) {
+        std::lock_guard<std::mutex> guard(lock);
+        players.erase(std::remove(players.begin(), players.end(), player), players.end());
+    }
+
+private:
+    std::mutex lock;
+    std::vector<SamplePlayer*> players;
+    bool running = false;
+
+    static void taskEntry(void* arg) {
+        static_cast<SamplePrefetcher*>(arg)->run();
+    }
+
+    void run();
+};
+
+class SamplePlayer: public Module_t {
+public:
+    static const int RATIO_ONE = 4096;
+
+    SamplePlayer() { module_info = {"sample player", "libchara-dev", "Streams PCM from flash/file with loop points and polyphony", false, false}; }
+
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t pitch[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int loop = 0;
+    int loopStart = 0;
+    int loopEnd = 0;
+    int quality = RESAMPLE_HERMITE;
+
+    SampleVoice voices[SAMPLE_MAX_VOICES];
+    uint32_t underflows = 0;
+
+    void start() {
+        FracResampler::initTables();
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            pitch[i] = RATIO_ONE;
+        }
+        registerPort(gate, PORT_DIN, "GATE", "rising edge starts a voice");
+        registerPort(pitch, PORT_AIN, "PITCH", "playback ratio, Q12 (4096 = 1.0)");
+        registerPort(out, PORT_AOUT, "OUTPUT", "sample output");
+        registerParam(&loop, PARAM_INT, "Loop", "loop while gate is held");
+        registerParam(&loopStart, PARAM_INT, "Loop start", "loop start frame");
+        registerParam(&loopEnd, PARAM_INT, "Loop end", "loop end frame, 0 = sample end");
+        registerParam(&quality, PARAM_INT, "Quality", "0:linear 1:hermite 2:sinc");
+        SamplePrefetcher::instance().add(this);
+        printf("SamplePlayer Start\n");
+    }
+    void stop() {
+        SamplePrefetcher::instance().remove(this);
+        delete pending.exchange(nullptr);
+        delete retired.exchange(nullptr);
+        delete current;
+        current = nullptr;
+        printf("SamplePlayer Stop\n");
+    }
+
+    // 请求加载采样 (任意线程), 由预读任务完成读取, 音频线程在块边界切换
+    bool requestLoad(const char* spec) {
+        if (loadRequested.load(std::memory_order_acquire)) {
+            printf("Sample load already in progress\n");
+            return false;
+        }
+        strncpy(loadSpec, spec, sizeof(loadSpec) - 1);
+        loadRequested.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void process() {
+        SampleData* loaded = pending.exchange(nullptr, std::memory_order_acquire);
+        if (loaded) {
+            for (auto& v : voices) {
+                stopVoice(v);
+            }
+            retired.store(current, std::memory_order_release);
+            current = loaded;
+        }
+
+        int32_t mix[AUDIO_BLOCK_SIZE] = {};
+        int16_t rendered[AUDIO_BLOCK_SIZE];
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            bool g = gate[i] != 0;
+            if (g && !lastGate && current) {
+                SampleVoice& v = allocateVoice();
+                startVoice(v, i);
+            } else if (!g && lastGate) {
+                for (auto& v : voices) {
+                    v.loop.store(false, std::memory_order_relaxed);
+                }
+            }
+            lastGate = g;
+        }
+
+        int32_t r = pitch[0] < RATIO_ONE / 4 ? RATIO_ONE / 4 : (pitch[0] > RATIO_ONE * 4 ? RATIO_ONE * 4 : pitch[0]);
+        uint64_t step = (uint64_t)r << 20;
+        resample_quality_t q = (resample_quality_t)(quality < 0 ? 0 : (quality > RESAMPLE_SINC ? RESAMPLE_SINC : quality));
+
+        for (auto& v : voices) {
+            if (!v.playing) continue;
+            v.age++;
+            int offset = startOffset(v);
+            int n = AUDIO_BLOCK_SIZE - offset;
+            fill(v, (int)(((v.pos + step * n) >> 32) + SINC_TAPS));
+            FracResampler::render(q, v.local + (SINC_TAPS / 2 - 1), v.pos, step, rendered, n);
+            for (int i = 0; i < n; i++) {
+                mix[offset + i] += rendered[i];
+            }
+            // 丢弃已消费的样本, 保留插值所需的历史
+            int consumed = (int)(v.pos >> 32);
+            v.pos &= 0xFFFFFFFFull;
+            memmove(v.local, v.local + consumed, (v.localCount - consumed) * sizeof(int16_t));
+            v.localCount -= consumed;
+            v.validCount -= consumed;
+            if (v.ended && v.validCount <= SINC_TAPS / 2 - 1) {
+                stopVoice(v);
+            }
+        }
+
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            out[i] = FracResampler::saturate(mix[i]);
+        }
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    friend class SamplePrefetcher;
+
+    SampleData* current = nullptr;
+    std::atomic<SampleData*> pending{nullptr};
+    std::atomic<SampleData*> retired{nullptr};
+    std::atomic<bool> loadRequested{false};
+    char loadSpec[128] = {};
+    bool lastGate = false;
+    int pendingOffset[SAMPLE_MAX_VOICES] = {};
+
+    SampleVoice& allocateVoice() {
+        SampleVoice* oldest = &voices[0];
+        for (auto& v : voices) {
+            if (!v.playing) return v;
+            if (v.age > oldest->age) oldest = &v;
+        }
+        return *oldest;
+    }
+
+    // 新声部从块内的触发位置开始输出
+    int startOffset(SampleVoice& v) {
+        int index = &v - voices;
+        int offset = pendingOffset[index];
+        pendingOffset[index] = 0;
+        return offset;
+    }
+
+    void startVoice(SampleVoice& v, int offset) {
+        size_t end = loopEnd > 0 && (size_t)loopEnd <= current->frames ? loopEnd : current->frames;
+        v.playSample = current;
+        v.headLimit = std::min(current->headFrames, loop ? end : current->frames);
+        v.sample.store(current, std::memory_order_relaxed);
+        v.loopStart.store(loopStart >= 0 && (size_t)loopStart < end ? loopStart : 0, std::memory_order_relaxed);
+        v.loopEnd.store(end, std::memory_order_relaxed);
+        v.fetchStart.store(v.headLimit, std::memory_order_relaxed);
+        v.loop.store(loop != 0, std::memory_order_relaxed);
+        v.streamFrame = 0;
+        v.ended = false;
+        v.pos = 0;
+        // 插值历史填零
+        v.localCount = SINC_TAPS / 2 - 1;
+        v.validCount = v.localCount;
+        memset(v.local, 0, v.localCount * sizeof(int16_t));
+        v.playing = true;
+        v.age = 0;
+        pendingOffset[&v - voices] = offset;
+        v.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    void stopVoice(SampleVoice& v) {
+        v.playing = false;
+        v.playSample = nullptr;
+        v.sample.store(nullptr, std::memory_order_relaxed);
+        v.generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // 保证 local 中至少有 need 个样本, 从不阻塞: 数据未就绪时补零并计数
+    void fill(SampleVoice& v, int need) {
+        if (need > SAMPLE_LOCAL_FRAMES) need = SAMPLE_LOCAL_FRAMES;
+        while (v.localCount < need) {
+            int want = need - v.localCount;
+            int got = 0;
+            if (v.ended) {
+                // 结束后补零
+            } else if (v.streamFrame < v.headLimit) {
+                got = std::min<size_t>(want, v.headLimit - v.streamFrame);
+                memcpy(v.local + v.localCount, v.playSample->head + v.streamFrame, got * sizeof(int16_t));
+            } else if (v.ack.load(std::memory_order_acquire) == v.generation.load(std::memory_order_relaxed)) {
+                bool end = v.streamEnd.load(std::memory_order_acquire);
+                got = v.ring.pop(v.local + v.localCount, want);
+                if (got == 0 && end) {
+                    v.ended = true;
+                } else if (got == 0) {
+                    underflows++;
+                }
+            } else {
+                underflows++;
+            }
+            if (got == 0) {
+                memset(v.local + v.localCount, 0, want * sizeof(int16_t));
+                v.localCount += want;
+                if (!v.ended) v.validCount += want;
+                continue;
+            }
+            v.streamFrame += got;
+            v.localCount += got;
+            v.validCount += got;
+        }
+    }
+
+    // 以下由预读任务调用
+    void serviceLoad() {
+        if (!loadRequested.load(std::memory_order_acquire) || pending.load() || retired.load()) return;
+        SampleData* data = new SampleData();
+        data->source = createSampleSource(loadSpec);
+        if (data->source->open()) {
+            data->frames = data->source->frames();
+            data->headFrames = std::min<size_t>(data->frames, SAMPLE_HEAD_FRAMES);
+            data->head = (int16_t*)psram_malloc(data->headFrames * sizeof(int16_t) + 1);
+            data->source->read(0, data->head, data->headFrames);
+            printf("Sample %s loaded: %u frames\n", loadSpec, (unsigned)data->frames);
+            pending.store(data, std::memory_order_release);
+        } else {
+            delete data;
+        }
+        loadRequested.store(false, std::memory_order_release);
+    }
+
+    void serviceVoice(SampleVoice& v) {
+        uint32_t gen = v.generation.load(std::memory_order_acquire);
+        if (gen != v.ack.load(std::memory_order_relaxed)) {
+            // 音频线程在 ack 之前不会读取 ring, 此时可以安全复位
+            v.fetchSample = v.sample.load(std::memory_order_relaxed);
+            v.fetchLoopStart = v.loopStart.load(std::memory_order_relaxed);
+            v.fetchLoopEnd = v.loopEnd.load(std::memory_order_relaxed);
+            v.fetchFrame = v.fetchStart.load(std::memory_order_relaxed);
+            // 复制期间被再次触发则等下一轮
+            if (v.generation.load(std::memory_order_acquire) != gen) return;
+            v.ring.reset();
+            v.streamEnd.store(false, std::memory_order_relaxed);
+            v.fetching = v.fetchSample != nullptr;
+            v.ack.store(gen, std::memory_order_release);
+        }
+        if (!v.fetching) return;
+        int16_t chunk[SAMPLE_CHUNK_FRAMES];
+        while (v.ring.space() >= SAMPLE_CHUNK_FRAMES && v.generation.load(std::memory_order_relaxed) == gen) {
+            size_t end = v.loop.load(std::memory_order_relaxed) ? v.fetchLoopEnd : v.fetchSample->frames;
+            if (v.fetchFrame >= end) {
+                if (v.loop.load(std::memory_order_relaxed)) {
+                    v.fetchFrame = v.fetchLoopStart;
+                } else {
+                    v.streamEnd.store(true, std::memory_order_release);
+                    v.fetching = false;
+                    break;
+                }
+            }
+            size_t n = std::min<size_t>(SAMPLE_CHUNK_FRAMES, end - v.fetchFrame);
+            n = v.fetchSample->source->read(v.fetchFrame, chunk, n);
+            if (n == 0) {
+                v.streamEnd.store(true, std::memory_order_release);
+                v.fetching = false;
+                break;
+            }
+            v.ring.push(chunk, n);
+            v.fetchFrame += n;
+        }
+    }
+
+    // 所有声部已确认停止后释放被替换的采样
+    void serviceRetired() {
+        SampleData* old = retired.load(std::memory_order_acquire);
+        if (!old) return;
+        for (auto& v : voices) {
+            if (v.ack.load(std::memory_order_relaxed) != v.generation.load(std::memory_order_acquire)) return;
+        }
+        retired.store(nullptr, std::memory_order_release);
+        delete old;
+    }
+};
+
+inline void SamplePrefetcher::run() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (auto player : players) {
+                player->serviceLoad();
+                for (auto& v : player->voices) {
+                    player->serviceVoice(v);
+                }
+                player->serviceRetired();
+            }
+        }
+#ifdef ESP_PLATFORM
+        vTaskDelay(1);
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "platform_compat.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// 采样数据来源: 单声道 s16le, 可带 WAV 头 (其他格式在 open() 时拒绝)
+// read() 只在预读任务中调用, 可能阻塞 (flash/文件读取)
+class SampleSource {
+public:
+    virtual bool open() = 0;
+    virtual size_t frames() = 0;
+    virtual size_t read(size_t frame, int16_t* dst, size_t n) = 0;
+    virtual ~SampleSource() {}
+
+protected:
+    // 逐块遍历 RIFF/WAVE, readAt(offset, dst, n) 返回实际读到的字节数
+    // 返回 1: 找到 data 块, 位置写入 *dataOffset / *dataBytes; 0: 无 RIFF 头, 按原始 PCM 处理;
+    // -1: WAV 格式不支持 (非单声道 16 位 PCM) 或缺少 data 块
+    template<typename ReadAt>
+    static int parseWav(ReadAt&& readAt, size_t totalBytes, size_t* dataOffset, size_t* dataBytes) {
+        uint8_t h[16];
+        if (readAt(0, h, 12) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) return 0;
+        bool formatOk = false;
+        size_t pos = 12;
+        while (pos + 8 <= totalBytes && readAt(pos, h, 8) == 8) {
+            uint32_t size = h[4] | (h[5] << 8) | (h[6] << 16) | ((uint32_t)h[7] << 24);
+            if (memcmp(h, "fmt ", 4) == 0) {
+                if (size < 16 || readAt(pos + 8, h, 16) != 16) break;
+                uint16_t format = h[0] | (h[1] << 8);
+                uint16_t channels = h[2] | (h[3] << 8);
+                uint16_t bits = h[14] | (h[15] << 8);
+                // 1 = PCM, 0xFFFE = WAVE_FORMAT_EXTENSIBLE
+                if ((format != 1 && format != 0xFFFE) || channels != 1 || bits != 16) {
+                    printf("Sample: only mono 16-bit PCM WAV is supported (format %d, %d ch, %d bit)\n", format, channels, bits);
+                    return -1;
+                }
+                formatOk = true;
+            } else if (memcmp(h, "data", 4) == 0) {
+                if (!formatOk) break;
+                *dataOffset = pos + 8;
+                *dataBytes = size > totalBytes - *dataOffset ? totalBytes - *dataOffset : size;
+                return 1;
+            }
+            // 块长度超出文件剩余部分时停止, 否则在 32 位 size_t 上 pos 会回绕而原地打转
+            if (size > totalBytes - pos - 8) break;
+            pos += 8 + (size_t)size + (size & 1);
+        }
+        printf("Sample: WAV has no fmt/data chunk\n");
+        return -1;
+    }
+
+    // 内存中的完整数据 (mmap 映射) 的 WAV 解析
+    static int parseWav(const uint8_t* p, size_t totalBytes, size_t* dataOffset, size_t* dataBytes) {
+        return parseWav([p, totalBytes](size_t offset, void* dst, size_t n) -> size_t {
+            if (offset >= totalBytes) return 0;
+            if (n > totalBytes - offset) n = totalBytes - offset;
+            memcpy(dst, p + offset, n);
+            return n;
+        }, totalBytes, dataOffset, dataBytes);
+    }
+};
+
+class FileSampleSource: public SampleSource {
+public:
+    FileSampleSource(const char* filePath) {
+        strncpy(path, filePath, sizeof(path) - 1);
+    }
+
+    bool open() {
+        file = fopen(path, "rb");
+        if (!file) {
+            printf("Sample: cannot open %s\n", path);
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        size_t fileBytes = ftell(file);
+        FILE* f = file;
+        size_t dataBytes = fileBytes;
+        int wav = parseWav([f](size_t offset, void* dst, size_t n) -> size_t {
+            if (fseek(f, offset, SEEK_SET) != 0) return 0;
+            return fread(dst, 1, n, f);
+        }, fileBytes, &dataOffset, &dataBytes);
+        if (wav < 0) {
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        if (wav == 0) {
+            dataOffset = 0;
+            dataBytes = fileBytes;
+        }
+        frameCount = dataBytes / sizeof(int16_t);
+        return true;
+    }
+    size_t frames() {
+        return frameCount;
+    }
+    size_t read(size_t frame, int16_t* dst, size_t n) {
+        if (frame >= frameCount) return 0;
+        if (n > frameCount - frame) n = frameCount - frame;
+        fseek(file, dataOffset + frame * sizeof(int16_t), SEEK_SET);
+        return fread(dst, sizeof(int16_t), n, file);
+    }
+    ~FileSampleSource() {
+        if (file) fclose(file);
+    }
+
+private:
+    char path[64] = {};
+    FILE* file = nullptr;
+    size_t dataOffset = 0;
+    size_t frameCount = 0;
+};
+
+#ifdef ESP_PLATFORM
+// flash 数据分区 (原始 PCM 或 WAV), 整个分区映射到数据地址空间后直接拷贝
+// 映射经过 flash cache, 不再为每次读取走一遍 esp_partition_read 的 SPI 事务
+class PartitionSampleSource: public SampleSource {
+public:
+    PartitionSampleSource(const char* partitionLabel) {
+        strncpy(label, partitionLabel, sizeof(label) - 1);
+    }
+
+    bool open() {
+        const esp_partition_t* partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!partition) {
+            printf("Sample: partition %s not found\n", label);
+            return false;
+        }
+        const void* p = nullptr;
+        if (esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &p, &mapHandle) != ESP_OK) {
+            printf("Sample: mmap partition %s failed\n", label);
+            return false;
+        }
+        mapped = (const uint8_t*)p;
+        size_t dataOffset = 0;
+        size_t dataBytes = partition->size;
+        int wav = parseWav(mapped, partition->size, &dataOffset, &dataBytes);
+        if (wav < 0) return false;
+        if (wav == 0) {
+            dataOffset = 0;
+            dataBytes = partition->size;
+        }
+        data = (const int16_t*)(mapped + dataOffset);
+        frameCount = dataBytes / sizeof(int16_t);
+        return true;
+    }
+    size_t frames() {
+        return frameCount;
+    }
+    size_t read(size_t frame, int16_t* dst, size_t n) {
+        if (frame >= frameCount) return 0;
+        if (n > frameCount - frame) n = frameCount - frame;
+        memcpy(dst, data + frame, n * sizeof(int16_t));
+        return n;
+    }
+    ~PartitionSampleSource() {
+        if (mapped) esp_partition_munmap(mapHandle);
+    }
+
+private:
+    char label[17] = {};
+    esp_partition_mmap_handle_t mapHandle = 0;
+    const uint8_t* mapped = nullptr;
+    const int16_t* data = nullptr;
+    size_t frameCount = 0;
+};
+#else
+// 主机上直接 mmap 采样文件
+class MmapSampleSource: public SampleSource {
+public:
+    MmapSampleSource(const char* filePath) {
+        strncpy(path, filePath, sizeof(path) - 1);
+    }
+
+    bool open() {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            printf("Sample: cannot open %s\n", path);
+            return false;
+        }
+        struct stat st;
+        fstat(fd, &st);
+        mappedBytes = st.st_size;
+        void* p = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            printf("Sample: mmap %s failed\n", path);
+            return false;
+        }
+        mapped = (const uint8_t*)p;
+        size_t offset = 0;
+        size_t dataBytes = mappedBytes;
+        int wav = parseWav(mapped, mappedBytes, &offset, &dataBytes);
+        if (wav < 0) return false;
+        if (wav == 0) {
+            offset = 0;
+            dataBytes = mappedBytes;
+        }
+        data = (const int16_t*)(mapped + offset);
+        frameCount = dataBytes / sizeof(int16_t);
+        return true;
+    }
+    size_t frames() {
+        return frameCount;
+    }
+    size_t read(size_t frame, int16_t* dst, size_t n) {
+        if (frame >= frameCount) return 0;
+        if (n > frameCount - frame) n = frameCount - frame;
+        memcpy(dst, data + frame, n * sizeof(int16_t));
+        return n;
+    }
+    ~MmapSampleSource() {
+        if (mapped) munmap((void*)mapped, mappedBytes);
+    }
+
+private:
+    char path[256] = {};
+    const uint8_t* mapped = nullptr;
+    const int16_t* data = nullptr;
+    size_t mappedBytes = 0;
+    size_t frameCount = 0;
+};
+#endif
+
+// "partition:<label>" 读取 flash 分区, 其余按文件路径处理 (主机上 mmap)
+inline SampleSource* createSampleSource(const char* spec) {
+#ifdef ESP_PLATFORM
+    if (strncmp(spec, "partition:", 10) == 0) {
+        return new PartitionSampleSource(spec + 10);
+    }
+    return new FileSampleSource(spec);
+#else
+    return new MmapSampleSource(spec);
+#endif
+}
+
+#endif
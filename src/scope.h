@@ -0,0 +1,331 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "module_manager.hpp"
+#include "spsc_ring.h"
+#include "dsp_kernels.h"
+#include "bench.h"
+#include "src_config.h"
+
+#ifdef ESP_PLATFORM
+#include "WindowManager.h"
+#endif
+
+#define TAP_RING_SIZE 2048
+#define TAP_MAX_DECIMATION 64
+#define SCOPE_HISTORY 512
+#define FFT_MAX_BITS 10
+#define FFT_MAX_SIZE (1 << FFT_MAX_BITS)
+#define VIEW_COLUMNS 128
+
+// 音频线程侧的信号抽头: 按 2 的幂抽取 (组内求平均) 后写入无锁环形缓冲
+// 环满时丢弃, 从不阻塞; 界面线程每帧取走全部数据
+class AudioTap {
+public:
+    AudioTap(): ring(TAP_RING_SIZE) {}
+
+    void push(const int16_t* in, int decimation) {
+        int shift = 0;
+        while ((2 << shift) <= decimation && (2 << shift) <= TAP_MAX_DECIMATION) shift++;
+        if (shift == 0) {
+            ring.push(in, AUDIO_BLOCK_SIZE);
+            return;
+        }
+        int16_t out[AUDIO_BLOCK_SIZE];
+        int group = 1 << shift;
+        int n = AUDIO_BLOCK_SIZE >> shift;
+        for (int g = 0; g < n; g++) {
+            int32_t sum = 0;
+            for (int i = 0; i < group; i++) {
+                sum += in[g * group + i];
+            }
+            out[g] = sum >> shift;
+        }
+        ring.push(out, n);
+    }
+
+    // 取出全部新数据, 追加到 history (长度 len) 的末尾, 旧数据前移
+    void drain(int16_t* history, int len) {
+        int16_t chunk[256];
+        size_t n;
+        while ((n = ring.pop(chunk, sizeof(chunk) / sizeof(chunk[0]))) > 0) {
+            memmove(history, history + n, (len - n) * sizeof(int16_t));
+            memcpy(history + len - n, chunk, n * sizeof(int16_t));
+        }
+    }
+
+private:
+    SpscRing<int16_t> ring;
+};
+
+// 定点基 2 FFT (Q15), 每级右移 1 位防止溢出, 结果为 X[k] / N
+class FixedFft {
+public:
+    static void initTables() {
+        if (tablesReady) return;
+        for (int i = 0; i < FFT_MAX_SIZE / 2; i++) {
+            cosTable[i] = (int16_t)lrintf(32767.0f * cosf(2.0f * (float)M_PI * i / FFT_MAX_SIZE));
+            sinTable[i] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * i / FFT_MAX_SIZE));
+        }
+        for (int i = 0; i < FFT_MAX_SIZE; i++) {
+            hannTable[i] = (int16_t)lrintf(32767.0f * (0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / FFT_MAX_SIZE)));
+        }
+        tablesReady = true;
+    }
+
+    static void transform(int16_t* re, int16_t* im, int bits) {
+        int n = 1 << bits;
+        for (int i = 1, j = 0; i < n; i++) {
+            int bit = n >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+                t = im[i]; im[i] = im[j]; im[j] = t;
+            }
+        }
+        for (int size = 2; size <= n; size <<= 1) {
+            int half = size >> 1;
+            int step = FFT_MAX_SIZE / size;
+            for (int i = 0; i < n; i += size) {
+                for (int k = 0; k < half; k++) {
+                    // w = cos - j sin
+                    int32_t c = cosTable[k * step], s = sinTable[k * step];
+                    int a = i + k, b = a + half;
+                    int32_t tr = (re[b] * c + im[b] * s) >> 15;
+                    int32_t ti = (im[b] * c - re[b] * s) >> 15;
+                    re[b] = (re[a] - tr) >> 1;
+                    im[b] = (im[a] - ti) >> 1;
+                    re[a] = (re[a] + tr) >> 1;
+                    im[a] = (im[a] + ti) >> 1;
+                }
+            }
+        }
+    }
+
+    // 取 Hann 窗系数, 按 FFT 长度抽取最大长度的表
+    static int16_t hann(int i, int bits) {
+        return hannTable[i << (FFT_MAX_BITS - bits)];
+    }
+
+    // log2(x) 的 Q8 近似: 整数部分取最高位, 小数部分取其后 8 位线性插值
+    static int32_t log2Q8(uint32_t x) {
+        if (x == 0) return 0;
+        int e = 31 - __builtin_clz(x);
+        uint32_t m = e >= 8 ? (x >> (e - 8)) & 0xFF : (x << (8 - e)) & 0xFF;
+        return (e << 8) | m;
+    }
+
+private:
+    static int16_t cosTable[FFT_MAX_SIZE / 2];
+    static int16_t sinTable[FFT_MAX_SIZE / 2];
+    static int16_t hannTable[FFT_MAX_SIZE];
+    static bool tablesReady;
+};
+
+int16_t FixedFft::cosTable[FFT_MAX_SIZE / 2];
+int16_t FixedFft::sinTable[FFT_MAX_SIZE / 2];
+int16_t FixedFft::hannTable[FFT_MAX_SIZE];
+bool FixedFft::tablesReady = false;
+
+// 示波器 / 频谱视图模块的公共部分: 输入原样送到 THRU, 同时写入抽头
+// customViewPage() 在界面线程中以显示帧率调用, 完成取数、分析与绘制
+class TapViewModule: public Module_t {
+public:
+    DSP_ALIGN int16_t in[AUDIO_BLOCK_SIZE] = {};
+    DSP_ALIGN int16_t thru[AUDIO_BLOCK_SIZE] = {};
+    int decimation = 1;
+
+    void process() {
+        memcpy(thru, in, sizeof(thru));
+        tap.push(in, decimation);
+    }
+    void customSettingPage() {
+
+    }
+
+#ifdef ESP_PLATFORM
+    // 由界面线程指定绘制目标, nullptr 时只分析不绘制
+    void attachView(Window* window) {
+        view = window;
+    }
+
+protected:
+    Window* view = nullptr;
+#else
+protected:
+#endif
+    AudioTap tap;
+
+    void registerTapPorts() {
+        registerPort(in, PORT_AIN, "INPUT", "signal to display");
+        registerPort(thru, PORT_AOUT, "THRU", "input passed through");
+        registerParam(&decimation, PARAM_INT, "Decimation", "1 ~ 64, power of two");
+    }
+};
+
+// 示波器: 在最近的历史中找上升沿触发点, 显示触发后的 128 个采样
+class ScopeModule: public TapViewModule {
+public:
+    ScopeModule() { module_info = {"scope", "libchara-dev", "Oscilloscope view of a decimated audio tap", false, false}; }
+
+    int triggerLevel = 0;   // 触发电平, Q15
+    int triggerMode = 1;    // 0: 自由运行 1: 上升沿
+
+    int16_t trace[VIEW_COLUMNS] = {}; // 最近一帧的显示数据
+
+    void start() {
+        registerTapPorts();
+        registerParam(&triggerLevel, PARAM_INT, "Trigger", "trigger level, Q15");
+        registerParam(&triggerMode, PARAM_INT, "Trigger mode", "0:free 1:rising edge");
+        printf("Scope Start\n");
+    }
+    void stop() {
+        printf("Scope Stop\n");
+    }
+    void customViewPage() {
+        tap.drain(history, SCOPE_HISTORY);
+        int start = SCOPE_HISTORY - VIEW_COLUMNS;
+        if (triggerMode) {
+            // 从最新往前找, 保证触发点之后有完整一屏
+            for (int i = SCOPE_HISTORY - VIEW_COLUMNS; i > 0; i--) {
+                if (history[i - 1] < triggerLevel && history[i] >= triggerLevel) {
+                    start = i;
+                    break;
+                }
+            }
+        }
+        memcpy(trace, history + start, sizeof(trace));
+#ifdef ESP_PLATFORM
+        if (!view) return;
+        int w = view->width() < VIEW_COLUMNS ? view->width() : VIEW_COLUMNS;
+        int h = view->height();
+        view->fillScreen(0);
+        view->drawFastHLine(0, h / 2, w, 64);
+        int lastY = h / 2 - ((trace[0] * h) >> 16);
+        for (int x = 1; x < w; x++) {
+            int y = h / 2 - ((trace[x] * h) >> 16);
+            view->drawLine(x - 1, lastY, x, y, 255);
+            lastY = y;
+        }
+        view->display();
+#endif
+    }
+
+private:
+    int16_t history[SCOPE_HISTORY] = {};
+};
+
+// 频谱: 最近 N 个采样加 Hann 窗后做定点 FFT, 对数频率轴上每列取范围内最大值
+class SpectrumModule: public TapViewModule {
+public:
+    SpectrumModule() { module_info = {"spectrum", "libchara-dev", "Spectrum analyzer view with fixed-point FFT", false, false}; }
+
+    int fftSize = 512;      // 256 / 512 / 1024
+    int range = 60;         // 显示动态范围 (dB)
+
+    uint8_t columns[VIEW_COLUMNS] = {}; // 每列高度, 0 ~ 255 对应 -range ~ 0 dBFS
+
+    void start() {
+        FixedFft::initTables();
+        registerTapPorts();
+        registerParam(&fftSize, PARAM_INT, "FFT size", "256 / 512 / 1024");
+        registerParam(&range, PARAM_INT, "Range", "dynamic range (dB)");
+        printf("Spectrum Start\n");
+    }
+    void stop() {
+        printf("Spectrum Stop\n");
+    }
+    void customViewPage() {
+        tap.drain(history, FFT_MAX_SIZE);
+        analyze();
+#ifdef ESP_PLATFORM
+        if (!view) return;
+        int w = view->width() < VIEW_COLUMNS ? view->width() : VIEW_COLUMNS;
+        int h = view->height();
+        view->fillScreen(0);
+        for (int x = 0; x < w; x++) {
+            int bar = (columns[x] * h) >> 8;
+            if (bar > 0) view->drawFastVLine(x, h - bar, bar, 255);
+        }
+        view->display();
+#endif
+    }
+
+    // 对 history 末尾 fftSize 个采样做一次分析, 结果写入 columns
+    void analyze() {
+        int bits = fftSize >= 1024 ? 10 : (fftSize >= 512 ? 9 : 8);
+        int n = 1 << bits;
+        if (bits != columnBits) buildColumnMap(bits);
+        const int16_t* x = history + FFT_MAX_SIZE - n;
+        for (int i = 0; i < n; i++) {
+            re[i] = (x[i] * FixedFft::hann(i, bits)) >> 15;
+            im[i] = 0;
+        }
+        FixedFft::transform(re, im, bits);
+        // 满幅正弦加 Hann 窗后峰值约为 32767 / 4, 以此为 0 dB
+        const int32_t fullScale = FixedFft::log2Q8((uint32_t)8192 * 8192);
+        int32_t span = (range < 12 ? 12 : range) * 256 * 10 / 30; // dB -> log2(功率) Q8, 10 dB 约 3.32
+        for (int c = 0; c < VIEW_COLUMNS; c++) {
+            uint32_t peak = 0;
+            for (int k = columnBin[c]; k < columnBin[c + 1]; k++) {
+                uint32_t p = (uint32_t)(re[k] * re[k]) + (uint32_t)(im[k] * im[k]);
+                if (p > peak) peak = p;
+            }
+            int32_t level = FixedFft::log2Q8(peak) - fullScale + span;
+            level = level < 0 ? 0 : (level * 255 / span);
+            columns[c] = level > 255 ? 255 : level;
+        }
+    }
+
+private:
+    int16_t history[FFT_MAX_SIZE] = {};
+    int16_t re[FFT_MAX_SIZE];
+    int16_t im[FFT_MAX_SIZE];
+    uint16_t columnBin[VIEW_COLUMNS + 1];
+    int columnBits = 0;
+
+    // 第 c 列覆盖 [bin(c), bin(c + 1)), 第 1 ~ N/2 个频点按对数分布, 每列至少一个频点
+    void buildColumnMap(int bits) {
+        int end = (1 << (bits - 1)) + 1;
+        float ratio = logf((float)end) / VIEW_COLUMNS;
+        columnBin[0] = 1;
+        for (int c = 1; c <= VIEW_COLUMNS; c++) {
+            int b = (int)lrintf(expf(ratio * c));
+            int limit = end - (VIEW_COLUMNS - c);
+            if (b > limit) b = limit;
+            if (b <= columnBin[c - 1]) b = columnBin[c - 1] + 1;
+            columnBin[c] = b;
+        }
+        columnBits = bits;
+    }
+};
+
+// 音频侧抽头开销, 以及界面侧一次 FFT 分析的耗时
+inline void benchViews(uint32_t blocks) {
+    benchModule<ScopeModule>("scope tap", blocks, [](ScopeModule& m) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            m.in[i] = i * 512 - 16384;
+        }
+    });
+    benchModule<SpectrumModule>("spectrum tap /4", blocks, [](SpectrumModule& m) {
+        m.decimation = 4;
+    });
+    static const int sizes[] = {256, 512, 1024};
+    static const char* names[] = {"spectrum fft 256", "spectrum fft 512", "spectrum fft 1024"};
+    for (int s = 0; s < 3; s++) {
+        SpectrumModule* m = new SpectrumModule();
+        m->start();
+        m->fftSize = sizes[s];
+        benchPrint(benchRun(names[s], blocks / 64 + 1, sizes[s], [&]() {
+            m->analyze();
+        }));
+        m->stop();
+        delete m;
+    }
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include "module_manager.hpp"
+#include "bench.h"
+#include "src_config.h"
+
+#define SEQ_MAX_STEPS 16
+#define SEQ_TRIG_SAMPLES 32     // 触发脉冲宽度
+#define SEQ_NEVER INT64_MAX
+
+// 步进音序器 / 时钟: 按速度与摇摆计算每个事件的精确采样位置 (32.32 定点, 不累积误差)
+// 每块只遍历块内的少量事件, 两个事件之间整段填充输出, 采样循环内没有分支
+// 步数据为每步一个原子字 (音符 | 门长 << 8), 界面线程可随时修改, 无需加锁
+class SequencerModule: public Module_t {
+public:
+    SequencerModule() {
+        module_info = {"sequencer", "libchara-dev", "Step sequencer and clock with swing", false, false};
+        static const uint8_t defaultNotes[SEQ_MAX_STEPS] = {57, 0, 60, 64, 69, 0, 64, 60, 55, 0, 59, 62, 67, 0, 62, 59};
+        for (int i = 0; i < SEQ_MAX_STEPS; i++) {
+            setStep(i, defaultNotes[i], 0);
+        }
+    }
+
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t trig[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t clock[AUDIO_BLOCK_SIZE] = {};
+    int tempo = 120;        // BPM, 每步为十六分音符
+    int swing = 50;         // 偶数步后半拍的位置 (%), 50 = 无摇摆, 最大 75
+    int steps = SEQ_MAX_STEPS;
+    int gateLength = 50;    // 默认门长 (步长的 %)
+    int run = 1;
+
+    void start() {
+        for (int n = 0; n < 128; n++) {
+            float hz = 440.0f * powf(2.0f, (n - 69) / 12.0f);
+            noteHz[n] = (int16_t)(hz > 32767 ? 32767 : lrintf(hz));
+        }
+        registerPort(gate, PORT_DOUT, "GATE", "gate output");
+        registerPort(trig, PORT_DOUT, "TRIG", "trigger at each step");
+        registerPort(freq, PORT_AOUT, "FREQ", "step pitch (Hz)");
+        registerPort(clock, PORT_DOUT, "CLOCK", "sixteenth note clock, unswung");
+        registerParam(&tempo, PARAM_INT, "Tempo", "BPM");
+        registerParam(&swing, PARAM_INT, "Swing", "50 ~ 75 (%)");
+        registerParam(&steps, PARAM_INT, "Steps", "1 ~ 16");
+        registerParam(&gateLength, PARAM_INT, "Gate", "default gate length (% of step)");
+        registerParam(&run, PARAM_INT, "Run", "0:stop 1:run");
+        printf("Sequencer Start\n");
+    }
+    void stop() {
+        printf("Sequencer Stop\n");
+    }
+
+    // 任意线程调用; note 为 MIDI 音符号, 0 = 休止; length 为门长 %, 0 = 使用 Gate 参数
+    void setStep(int index, int note, int length) {
+        if (index < 0 || index >= SEQ_MAX_STEPS) return;
+        uint32_t v = (uint32_t)(note & 0x7F) | ((uint32_t)(length < 0 ? 0 : (length > 255 ? 255 : length)) << 8);
+        pattern[index].store(v, std::memory_order_relaxed);
+    }
+    uint32_t getStep(int index) const {
+        return pattern[index].load(std::memory_order_relaxed);
+    }
+    int currentStep() const {
+        return playing.load(std::memory_order_relaxed);
+    }
+
+    void process() {
+        if (!run) {
+            if (running) {
+                running = false;
+                gateLevel = trigLevel = clockLevel = 0;
+            }
+            fillRun(0, AUDIO_BLOCK_SIZE);
+            now += AUDIO_BLOCK_SIZE;
+            return;
+        }
+        if (!running) {
+            // 从第 0 步开始, 第一个事件落在本块第一个采样
+            running = true;
+            stepIndex = 0;
+            stepTime = (uint64_t)now << 32;
+            clockTime = stepTime;
+            gateOffAt = trigOffAt = SEQ_NEVER;
+            clockLevel = 0;
+        }
+        updateTiming();
+
+        int64_t end = now + AUDIO_BLOCK_SIZE;
+        int pos = 0;
+        for (;;) {
+            int64_t stepAt = (int64_t)(stepTime >> 32);
+            int64_t clockAt = (int64_t)(clockTime >> 32);
+            int64_t t = stepAt;
+            if (clockAt < t) t = clockAt;
+            if (gateOffAt < t) t = gateOffAt;
+            if (trigOffAt < t) t = trigOffAt;
+            if (t >= end) break;
+            fillRun(pos, (int)(t - now));
+            pos = (int)(t - now);
+            if (t == gateOffAt) {
+                gateLevel = 0;
+                gateOffAt = SEQ_NEVER;
+            }
+            if (t == trigOffAt) {
+                trigLevel = 0;
+                trigOffAt = SEQ_NEVER;
+            }
+            if (t == clockAt) {
+                // 时钟为不带摇摆的方波, 上升沿对齐每步的原始位置
+                clockLevel = !clockLevel;
+                clockTime += stepLength / 2;
+            }
+            if (t == stepAt) {
+                beginStep(t);
+            }
+        }
+        fillRun(pos, AUDIO_BLOCK_SIZE);
+        now = end;
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    std::atomic<uint32_t> pattern[SEQ_MAX_STEPS];
+    std::atomic<int> playing{0};
+    int16_t noteHz[128];
+
+    int64_t now = 0;            // 本块首个采样的绝对位置
+    uint64_t stepTime = 0;      // 下一步的开始位置, 32.32
+    uint64_t clockTime = 0;     // 下一个时钟沿, 32.32
+    uint64_t stepLength = 0;    // 每步采样数, 32.32
+    int64_t gateOffAt = SEQ_NEVER;
+    int64_t trigOffAt = SEQ_NEVER;
+    int stepIndex = 0;
+    bool running = false;
+    int16_t gateLevel = 0, trigLevel = 0, clockLevel = 0, freqLevel = 0;
+
+    void updateTiming() {
+        int bpm = tempo < 20 ? 20 : (tempo > 300 ? 300 : tempo);
+        stepLength = ((uint64_t)sampleRate * 15 << 32) / bpm; // 60 / bpm / 4 秒
+    }
+
+    void fillRun(int from, int to) {
+        for (int i = from; i < to; i++) {
+            gate[i] = gateLevel;
+            trig[i] = trigLevel;
+            freq[i] = freqLevel;
+            clock[i] = clockLevel;
+        }
+    }
+
+    // 在采样位置 t 开始当前步, 并按摇摆安排下一步
+    void beginStep(int64_t t) {
+        int count = steps < 1 ? 1 : (steps > SEQ_MAX_STEPS ? SEQ_MAX_STEPS : steps);
+        if (stepIndex >= count) stepIndex = 0;
+        uint32_t v = pattern[stepIndex].load(std::memory_order_relaxed);
+        playing.store(stepIndex, std::memory_order_relaxed);
+        int note = v & 0x7F;
+        int length = (v >> 8) & 0xFF;
+        if (length == 0) length = gateLength;
+
+        int sw = swing < 50 ? 50 : (swing > 75 ? 75 : swing);
+        // 一对步共 2 个步长, 偶数步占 swing%, 奇数步占其余部分
+        uint64_t pair = stepLength * 2;
+        uint64_t duration = (stepIndex & 1) ? pair - pair / 100 * sw : pair / 100 * sw;
+
+        if (note) {
+            gateLevel = 1;
+            trigLevel = 1;
+            freqLevel = noteHz[note];
+            trigOffAt = t + SEQ_TRIG_SAMPLES;
+            // 门长不小于 100% 时保持到下一步 (连奏), 仍由 TRIG 标出每一步
+            gateOffAt = length >= 100 ? SEQ_NEVER : t + (int64_t)((duration >> 32) * length / 100);
+            if (gateOffAt <= t) gateOffAt = t + 1;
+        } else {
+            gateLevel = 0;
+            gateOffAt = SEQ_NEVER;
+        }
+        stepTime += duration;
+        stepIndex++;
+    }
+};
+
+inline void benchSequencer(uint32_t blocks) {
+    benchModule<SequencerModule>("sequencer 300 bpm", blocks, [](SequencerModule& m) {
+        m.tempo = 300;
+        m.swing = 60;
+    });
+}
+
+#endif
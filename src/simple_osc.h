@@ -34,32 +34,36 @@ public:
     SimpleOsc() { module_info = {"simple osc", "libchara-dev", "A simple wavetable oscillator module.", false, false}; }
     float wave_t_c = 32.0f / SMP_RATE;
 
-    int16_t out = 0;
-    int16_t freq = 0;
-    int16_t gate = 0;
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
     int wave = 4;
 
     float wave_time = 0;
 
     void start() {
-        registerPort(&freq, PORT_AIN, "FREQ IN", "frequency input");
-        registerPort(&gate, PORT_DIN, "GATE", "gate");
-        registerPort(&out, PORT_AOUT, "OUTPUT", "signal output");
+        registerPort(freq, PORT_AIN, "FREQ IN", "frequency input");
+        registerPort(gate, PORT_DIN, "GATE", "gate");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
         registerParam(&wave, PARAM_INT, "Wave type", "wavetable");
+        wave_t_c = 32.0f / sampleRate;
         printf("SimpleOsc Start\n");
     }
     void stop() {
         printf("SimpleOsc Start\n");
     }
     void process() {
-        if (gate) {
-            wave_time += wave_t_c * freq;
-            if (wave_time >= 32) {
-                wave_time -= 32;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            if (gate[i]) {
+                wave_time += wave_t_c * freq[i];
+                if (wave_time >= 32) {
+                    wave_time -= 32;
+                }
+                // 四舍五入可能得到 32, 回绕到表头
+                out[i] = wave_table[wave][(int)roundf(wave_time) & 31] * 2048;
+            } else {
+                out[i] = 0;
             }
-            out = wave_table[wave][(int)roundf(wave_time)] * 2048;
-        } else {
-            out = 0;
         }
     }
     void customSettingPage() {
@@ -0,0 +1,93 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "platform_compat.h"
+
+// 单生产者单消费者无锁环形缓冲, 容量为 2 的幂
+// 生产者只写 head, 消费者只写 tail, 双方都不会阻塞
+template<typename T>
+class SpscRing {
+public:
+    SpscRing(size_t capacityPow2, bool usePsram = false): capacity(capacityPow2), mask(capacityPow2 - 1), psram(usePsram) {
+        buffer = (T*)(psram ? psram_malloc(capacity * sizeof(T)) : malloc(capacity * sizeof(T)));
+    }
+
+    ~SpscRing() {
+        if (psram) {
+            psram_free(buffer);
+        } else {
+            free(buffer);
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    // 可读数量 (消费者调用)
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    // 可写数量 (生产者调用)
+    size_t space() const {
+        return capacity - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    // 写入最多 n 个元素, 返回实际写入数量
+    size_t push(const T* data, size_t n) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t free = capacity - (h - tail.load(std::memory_order_acquire));
+        if (n > free) n = free;
+        size_t first = capacity - (h & mask);
+        if (first > n) first = n;
+        memcpy(buffer + (h & mask), data, first * sizeof(T));
+        memcpy(buffer, data + first, (n - first) * sizeof(T));
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    bool push(const T& item) {
+        return push(&item, 1) == 1;
+    }
+
+    // 读出最多 n 个元素, 返回实际读出数量
+    size_t pop(T* data, size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t avail = head.load(std::memory_order_acquire) - t;
+        if (n > avail) n = avail;
+        size_t first = capacity - (t & mask);
+        if (first > n) first = n;
+        memcpy(data, buffer + (t & mask), first * sizeof(T));
+        memcpy(data + first, buffer, (n - first) * sizeof(T));
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    bool pop(T& item) {
+        return pop(&item, 1) == 1;
+    }
+
+    // 只能在消费者确定不会访问时由生产者调用 (或双方都停止时)
+    void reset() {
+        tail.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_release);
+    }
+
+private:
+    T* buffer;
+    size_t capacity;
+    size_t mask;
+    bool psram;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+};
+
+#endif
@@ -10,4 +10,11 @@
 
 #define SMP_RATE 44100
 
-#endif
\ No newline at end of file
+// 每次 process() 处理的采样数, 端口数据均为该长度的块
+#define AUDIO_BLOCK_SIZE 64
+// I2S DMA 描述符数量 (每个描述符一个块)
+#define AUDIO_DMA_BLOCKS 4
+// xrun 记录环形缓冲长度
+#define XRUN_LOG_SIZE 16
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SSD1306_REGION_H
+#define SSD1306_REGION_H
+
+#include <Arduino.h>
+#include <Adafruit_SSD1306.h>
+
+// SSD1306 局部刷新: 只发送指定列范围与页范围 (每页 8 行) 的显存
+// 依赖 begin() 设置的水平寻址模式, 写入在列 / 页窗口内自动换行
+// 只用库的公开接口 (getBuffer(), SSD1306_* 命令宏): 硬件 SPI 的总线与引脚在构造时自行保存,
+// 不读取 Adafruit_SSD1306 的 protected 成员; 按 platformio.ini 中的 Adafruit SSD1306 2.5.x 验证
+// 其他构造方式 (I2C / 软件 SPI) 退回整屏 display()
+class RegionSSD1306 : public Adafruit_SSD1306 {
+public:
+    using Adafruit_SSD1306::Adafruit_SSD1306;
+
+    // 硬件 SPI, 参数与 Adafruit_SSD1306 相同
+    RegionSSD1306(uint8_t w, uint8_t h, SPIClass* spiBus, int8_t dc, int8_t rst, int8_t cs, uint32_t bitrate = 8000000UL)
+        : Adafruit_SSD1306(w, h, spiBus, dc, rst, cs, bitrate), bus(spiBus), settings(bitrate, MSBFIRST, SPI_MODE0),
+          dcPin(dc), csPin(cs), panelWidth(w), panelHeight(h) {}
+
+    uint32_t pushes = 0;
+    uint32_t pushedBytes = 0;
+
+    // 刷新 [x0, x1) × [y0, y1), 行按页对齐
+    void displayRegion(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (!bus) {
+            display();
+            pushes++;
+            pushedBytes += width() * height() / 8;
+            return;
+        }
+        if (x1 > panelWidth) x1 = panelWidth;
+        if (y1 > panelHeight) y1 = panelHeight;
+        if (x0 >= x1 || y0 >= y1) return;
+        uint8_t page0 = y0 >> 3;
+        uint8_t page1 = (y1 - 1) >> 3;
+        const uint8_t window[] = {SSD1306_PAGEADDR, page0, page1, SSD1306_COLUMNADDR, (uint8_t)x0, (uint8_t)(x1 - 1)};
+        const uint8_t* buffer = getBuffer();
+        bus->beginTransaction(settings);
+        digitalWrite(csPin, LOW);
+        digitalWrite(dcPin, LOW);
+        for (uint8_t c : window) {
+            bus->transfer(c);
+        }
+        digitalWrite(dcPin, HIGH);
+        for (int page = page0; page <= page1; page++) {
+            bus->writeBytes(buffer + page * panelWidth + x0, x1 - x0);
+        }
+        digitalWrite(csPin, HIGH);
+        bus->endTransaction();
+        pushes++;
+        pushedBytes += (page1 - page0 + 1) * (x1 - x0);
+    }
+
+private:
+    SPIClass* bus = nullptr;
+    SPISettings settings;
+    int8_t dcPin = -1, csPin = -1;
+    int16_t panelWidth = 0, panelHeight = 0;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef TOUCH_KEYS_H
+#define TOUCH_KEYS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "event_bus.h"
+#include "midi_input.h"
+#include "spsc_ring.h"
+#include "bench.h"
+#include "platform_compat.h"
+
+#ifdef ESP_PLATFORM
+#include <Arduino.h>
+#include <Wire.h>
+#define TOUCH_SDA_PIN 8
+#define TOUCH_SCL_PIN 9
+#define TOUCH_IRQ_PIN0 1
+#define TOUCH_IRQ_PIN1 2
+#endif
+
+#define TOUCH_CHIPS 2
+#define TOUCH_KEYS_PER_CHIP 12
+#define TOUCH_KEYS (TOUCH_CHIPS * TOUCH_KEYS_PER_CHIP)
+// 一次突发读取: 触摸状态 (0x00) 起, 经滤波数据 (0x04 ~ 0x1D) 到基线 (0x1E ~ 0x29)
+#define TOUCH_BURST 0x2A
+#define TOUCH_FILTERED_REG 0x04
+#define TOUCH_BASELINE_REG 0x1E
+#define TOUCH_SAMPLE_US 1000        // MPR121 电极采样周期 (ESI = 1 ms)
+#define TOUCH_THRESHOLD 12          // 与 Adafruit_MPR121::begin() 的默认触摸阈值一致
+#define TOUCH_LOCKOUT_US 10000      // 按下后此时间内的松开视为抖动
+#define TOUCH_NO_NOTE 0xFF          // 按下时音符超出 0 ~ 127, 未发出
+
+// MPR121 电容键盘: 由 IRQ 唤醒读取任务, 每次唤醒对每片芯片做一次突发读取 (状态 + 滤波数据 + 基线)
+// 去抖不延迟按下: 按下沿立即发出; 按下后 TOUCH_LOCKOUT_US 内的松开先挂起,
+// 到期仍未重新触摸才发出, 期间的抖动被吞掉
+// 力度由检测时刻的滤波数据斜率估计: 上一个采样尚未越过阈值, 越过量 / 经过时间 即手指接近的速度
+class TouchKeyboard {
+public:
+    SpscRing<midi_event_t> events{128};
+    int baseNote = 48;
+    int fullScaleSlope = 40;    // 达到力度 127 的斜率 (计数 / ms)
+
+    // 统计: IRQ 到读取完成的时间, 抖动次数
+    volatile uint32_t scans = 0;
+    volatile uint32_t chatter = 0;
+    volatile uint32_t dropped = 0;
+    int64_t readUsSum = 0;
+    int32_t readUsMax = 0;
+
+    // 处理一次读取结果; irqUs 为 IRQ 时间 (超时唤醒时为读取开始时间)
+    void handleScan(const uint8_t raw[TOUCH_CHIPS][TOUCH_BURST], int64_t irqUs, int64_t readUs) {
+        scans++;
+        int32_t readTime = (int32_t)(readUs - irqUs);
+        readUsSum += readTime;
+        if (readTime > readUsMax) readUsMax = readTime;
+
+        uint32_t status = 0;
+        for (int c = 0; c < TOUCH_CHIPS; c++) {
+            status |= (uint32_t)((raw[c][0] | (raw[c][1] << 8)) & 0x0FFF) << (c * TOUCH_KEYS_PER_CHIP);
+        }
+        touched = status;
+        // 只处理状态变化的键, 以及挂起松开但又被触摸的键
+        uint32_t changed = (status ^ down) | (status & pendingRelease);
+        while (changed) {
+            int k = __builtin_ctz(changed);
+            changed &= changed - 1;
+            uint32_t bit = 1u << k;
+            if (status & bit) {
+                if (pendingRelease & bit) {
+                    pendingRelease &= ~bit;
+                    chatter++;
+                } else {
+                    // 松开时用按下时的音符: 按住期间 baseNote 可能被 GUI 任务改变
+                    int note = baseNote + k;
+                    pressNote[k] = note >= 0 && note <= 127 ? note : TOUCH_NO_NOTE;
+                    pressUs[k] = irqUs;
+                    down |= bit;
+                    emit(EVENT_NOTE_ON, pressNote[k], estimateVelocity(raw, k, irqUs, readUs), irqUs);
+                }
+            } else if (readUs - pressUs[k] < TOUCH_LOCKOUT_US) {
+                pendingRelease |= bit;
+            } else {
+                // 挂起的松开在这里一并完成, 否则 releaseExpired() 会再发一次 NOTE_OFF
+                pendingRelease &= ~bit;
+                down &= ~bit;
+                emit(EVENT_NOTE_OFF, pressNote[k], 0, irqUs);
+            }
+        }
+        releaseExpired(readUs);
+    }
+
+    // 到期的挂起松开; 返回下一个到期时间, 无挂起时为 -1
+    int64_t releaseExpired(int64_t nowUs) {
+        int64_t next = -1;
+        uint32_t pending = pendingRelease;
+        while (pending) {
+            int k = __builtin_ctz(pending);
+            pending &= pending - 1;
+            int64_t due = pressUs[k] + TOUCH_LOCKOUT_US;
+            if (due <= nowUs) {
+                pendingRelease &= ~(1u << k);
+                down &= ~(1u << k);
+                emit(EVENT_NOTE_OFF, pressNote[k], 0, due);
+            } else if (next < 0 || due < next) {
+                next = due;
+            }
+        }
+        return next;
+    }
+
+    uint32_t heldKeys() const {
+        return down;
+    }
+
+    void printStats() {
+        printf("Touch keys: %lu scans, read avg %.0fus max %ldus, %lu chatter, %lu dropped\n",
+               (unsigned long)scans, scans ? (float)readUsSum / scans : 0.0f, (long)readUsMax,
+               (unsigned long)chatter, (unsigned long)dropped);
+    }
+
+#ifdef ESP_PLATFORM
+    // 芯片已由 Adafruit_MPR121::begin() 完成配置; 此后只用突发读取访问
+    bool begin(TwoWire* bus, const uint8_t* addresses, const int* irqPins) {
+        wire = bus;
+        for (int c = 0; c < TOUCH_CHIPS; c++) {
+            address[c] = addresses[c];
+        }
+        xTaskCreatePinnedToCore(scanTask, "Touch", 3072, this, 4, &task, 1);
+        for (int c = 0; c < TOUCH_CHIPS; c++) {
+            pinMode(irqPins[c], INPUT_PULLUP);
+            attachInterruptArg(irqPins[c], onIrq, this, FALLING);
+        }
+        return true;
+    }
+#endif
+
+private:
+    uint32_t down = 0;              // 已发出按下的键
+    uint32_t pendingRelease = 0;    // 等待去抖到期的松开
+    uint32_t touched = 0;
+    int64_t pressUs[TOUCH_KEYS] = {};
+    uint8_t pressNote[TOUCH_KEYS] = {};     // 按下时发出的音符
+
+    int estimateVelocity(const uint8_t raw[TOUCH_CHIPS][TOUCH_BURST], int k, int64_t irqUs, int64_t readUs) {
+        const uint8_t* r = raw[k / TOUCH_KEYS_PER_CHIP];
+        int e = k % TOUCH_KEYS_PER_CHIP;
+        int filtered = r[TOUCH_FILTERED_REG + 2 * e] | ((r[TOUCH_FILTERED_REG + 2 * e + 1] & 0x03) << 8);
+        int baseline = r[TOUCH_BASELINE_REG + e] << 2;
+        int excess = baseline - filtered - TOUCH_THRESHOLD;
+        if (excess < 0) excess = 0;
+        // 越过量在 IRQ 之前最多一个采样周期内积累, 再加上 IRQ 到读取的时间
+        int32_t elapsedUs = (int32_t)(readUs - irqUs) + TOUCH_SAMPLE_US;
+        int32_t scale = fullScaleSlope < 1 ? 1 : fullScaleSlope;
+        int32_t v = (int32_t)((int64_t)excess * 127 * 1000 / ((int64_t)elapsedUs * scale));
+        return v < 1 ? 1 : (v > 127 ? 127 : v);
+    }
+
+    void emit(uint8_t type, uint8_t note, int vel, int64_t us) {
+        if (note == TOUCH_NO_NOTE) return;
+        midi_event_t e = {audio_clock.sampleAt(us), type, 0, note, (int16_t)vel};
+        if (!events.push(e)) dropped++;
+    }
+
+#ifdef ESP_PLATFORM
+    TwoWire* wire = nullptr;
+    uint8_t address[TOUCH_CHIPS] = {};
+    TaskHandle_t task = nullptr;
+    volatile int64_t irqUs = 0;
+
+    static void IRAM_ATTR onIrq(void* arg) {
+        TouchKeyboard* self = (TouchKeyboard*)arg;
+        BaseType_t woken = pdFALSE;
+        self->irqUs = esp_timer_get_time();
+        vTaskNotifyGiveFromISR(self->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    // 每片芯片一次带重复起始条件的突发读取; 读状态寄存器同时清除该芯片的 IRQ
+    void readChips(uint8_t raw[TOUCH_CHIPS][TOUCH_BURST]) {
+        for (int c = 0; c < TOUCH_CHIPS; c++) {
+            wire->beginTransmission(address[c]);
+            wire->write(0x00);
+            wire->endTransmission(false);
+            size_t n = wire->requestFrom(address[c], (size_t)TOUCH_BURST);
+            if (n == TOUCH_BURST) {
+                wire->readBytes(raw[c], TOUCH_BURST);
+            } else {
+                memset(raw[c], 0, TOUCH_BURST);
+            }
+        }
+    }
+
+    static void scanTask(void* arg) {
+        TouchKeyboard* self = (TouchKeyboard*)arg;
+        uint8_t raw[TOUCH_CHIPS][TOUCH_BURST];
+        int64_t next = -1;
+        for (;;) {
+            // 没有挂起的松开时一直等待 IRQ, 否则最多等到最早的到期时间
+            TickType_t wait = portMAX_DELAY;
+            if (next >= 0) {
+                int64_t ms = (next - esp_timer_get_time() + 999) / 1000;
+                wait = pdMS_TO_TICKS(ms < 1 ? 1 : ms);
+            }
+            bool irq = ulTaskNotifyTake(pdTRUE, wait) > 0;
+            int64_t t0 = irq ? self->irqUs : esp_timer_get_time();
+            self->readChips(raw);
+            self->handleScan(raw, t0, esp_timer_get_time());
+            next = self->releaseExpired(esp_timer_get_time());
+        }
+    }
+#endif
+};
+
+TouchKeyboard touch_keys;
+
+// 电容键盘模块, 读取 touch_keys 的事件; 与 MIDI 输入相同, 只允许一个实例
+class TouchKeysModule: public NoteSourceModule {
+public:
+    TouchKeysModule(): NoteSourceModule(touch_keys.events) { module_info = {"touch keys", "libchara-dev", "MPR121 touch keyboard with velocity", false, false, true}; }
+
+    void start() {
+        registerNotePorts();
+        printf("TouchKeys Start\n");
+    }
+    void stop() {
+        printf("TouchKeys Stop\n");
+    }
+    void printProfileDetail() {
+        NoteSourceModule::printProfileDetail();
+        printf("    touch: %lu scans, read avg %.0fus max %ldus, %lu chatter\n", (unsigned long)touch_keys.scans,
+               touch_keys.scans ? (float)touch_keys.readUsSum / touch_keys.scans : 0.0f, (long)touch_keys.readUsMax,
+               (unsigned long)touch_keys.chatter);
+    }
+};
+
+// 合成数据驱动的扫描处理耗时 (不含 I2C 传输), 每次为一个按下或松开
+inline void benchTouchKeys(uint32_t scans) {
+    TouchKeyboard keys;
+    uint8_t raw[TOUCH_CHIPS][TOUCH_BURST] = {};
+    for (int c = 0; c < TOUCH_CHIPS; c++) {
+        for (int e = 0; e < TOUCH_KEYS_PER_CHIP; e++) {
+            raw[c][TOUCH_FILTERED_REG + 2 * e] = 0x80;
+            raw[c][TOUCH_FILTERED_REG + 2 * e + 1] = 0x02;
+            raw[c][TOUCH_BASELINE_REG + e] = 0xA8;
+        }
+    }
+    int64_t us = 0;
+    midi_event_t sink;
+    uint32_t n = 0;
+    bench_result_t r = benchRun("touch keys scan", scans, 1, [&]() {
+        int k = n % TOUCH_KEYS;
+        uint8_t* r = raw[k / TOUCH_KEYS_PER_CHIP];
+        int e = k % TOUCH_KEYS_PER_CHIP;
+        r[e / 8] ^= 1 << (e % 8);
+        us += TOUCH_LOCKOUT_US;
+        keys.handleScan(raw, us, us + 150);
+        keys.events.pop(sink);
+        n++;
+    });
+    printf("%-24s %8.1f ns/scan\n", r.name, r.totalUs * 1000.0 / r.iterations);
+}
+
+#endif
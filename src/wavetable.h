@@ -0,0 +1,333 @@
+#ifndef WAVETABLE_H
+#define WAVETABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "module_manager.hpp"
+#include "platform_compat.h"
+#include "sample_source.h"
+#include "bench.h"
+#include "src_config.h"
+
+#define WT_MIN_FRAME_SIZE 256
+#define WT_MAX_FRAME_SIZE 2048
+#define WT_MAX_FRAMES 256
+#define WT_MAX_LEVELS 11        // 2048 点单帧: 1024, 512, ... 1 次谐波
+#define WT_MIN_LEVEL_LEN 64     // 高八度的表不再缩短, 保证线性插值精度
+#define WT_HEADER_WORDS 8       // 文件头 16 字节
+
+// 波表文件 (主机 wtconvert 生成): 16 字节头 + 各八度层依次存放的全部帧
+// 头: "WTBL", frameSize, frames, levels, 保留; 均为小端 uint16
+// 第 L 层只保留 (frameSize / 2) >> L 次以下的谐波, 表长 max(frameSize >> L, 64)
+struct WavetableData {
+    char spec[64] = {};
+    uint16_t frameSize = 0;
+    uint16_t frames = 0;
+    uint16_t levels = 0;
+    uint8_t lenBits[WT_MAX_LEVELS] = {};
+    uint32_t offset[WT_MAX_LEVELS] = {};
+    int16_t* data = nullptr;    // PSRAM, 每帧末尾多存一个回绕采样
+    int refs = 0;               // 由 WavetableCache 的锁保护
+
+    static int levelCount(int frameSize) {
+        return 32 - __builtin_clz(frameSize / 2);
+    }
+    static int levelLength(int frameSize, int level) {
+        int len = frameSize >> level;
+        return len < WT_MIN_LEVEL_LEN ? WT_MIN_LEVEL_LEN : len;
+    }
+    static int levelHarmonics(int frameSize, int level) {
+        return (frameSize / 2) >> level;
+    }
+    static bool validFrameSize(int frameSize) {
+        return frameSize >= WT_MIN_FRAME_SIZE && frameSize <= WT_MAX_FRAME_SIZE && (frameSize & (frameSize - 1)) == 0;
+    }
+
+    bool allocate(int size, int count) {
+        frameSize = size;
+        frames = count;
+        levels = levelCount(size);
+        uint32_t total = 0;
+        for (int l = 0; l < levels; l++) {
+            int len = levelLength(size, l);
+            lenBits[l] = 31 - __builtin_clz(len);
+            offset[l] = total;
+            total += (len + 1) * count;
+        }
+        data = (int16_t*)psram_malloc(total * sizeof(int16_t));
+        return data != nullptr;
+    }
+
+    const int16_t* frame(int level, int f) const {
+        return data + offset[level] + f * ((1 << lenBits[level]) + 1);
+    }
+    int16_t* frame(int level, int f) {
+        return data + offset[level] + f * ((1 << lenBits[level]) + 1);
+    }
+
+    // 写完一帧后补上回绕采样
+    void closeFrame(int level, int f) {
+        int16_t* p = frame(level, f);
+        p[1 << lenBits[level]] = p[0];
+    }
+
+    ~WavetableData() {
+        psram_free(data);
+    }
+};
+
+// 所有实例共享的波表缓存, 按 spec 查找, 引用计数归零时释放 PSRAM
+// acquire() 可能读取 flash / 文件, 只能在非音频线程调用
+class WavetableCache {
+public:
+    static WavetableCache& instance() {
+        static WavetableCache cache;
+        return cache;
+    }
+
+    WavetableData* acquire(const char* spec) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto t : tables) {
+            if (strcmp(t->spec, spec) == 0) {
+                t->refs++;
+                return t;
+            }
+        }
+        WavetableData* t = strncmp(spec, "builtin", 7) == 0 ? buildDefault() : load(spec);
+        if (!t) return nullptr;
+        strncpy(t->spec, spec, sizeof(t->spec) - 1);
+        t->refs = 1;
+        tables.push_back(t);
+        return t;
+    }
+
+    void release(WavetableData* t) {
+        if (!t) return;
+        std::lock_guard<std::mutex> guard(lock);
+        if (--t->refs > 0) return;
+        for (size_t i = 0; i < tables.size(); i++) {
+            if (tables[i] == t) {
+                tables.erase(tables.begin() + i);
+                break;
+            }
+        }
+        delete t;
+    }
+
+    void printInfo() {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto t : tables) {
+            uint32_t bytes = (t->offset[t->levels - 1] + ((1 << t->lenBits[t->levels - 1]) + 1) * t->frames) * sizeof(int16_t);
+            printf("%-32s %4d x %4d, %2d levels, %6u bytes, %d refs\n", t->spec, t->frames, t->frameSize, t->levels, (unsigned)bytes, t->refs);
+        }
+    }
+
+private:
+    std::mutex lock;
+    std::vector<WavetableData*> tables;
+
+    static WavetableData* load(const char* spec) {
+        SampleSource* source = createSampleSource(spec);
+        WavetableData* t = nullptr;
+        int16_t header[WT_HEADER_WORDS];
+        if (source->open() && source->read(0, header, WT_HEADER_WORDS) == WT_HEADER_WORDS) {
+            int frameSize = (uint16_t)header[2];
+            int frames = (uint16_t)header[3];
+            int levels = (uint16_t)header[4];
+            if (memcmp(header, "WTBL", 4) != 0 || !WavetableData::validFrameSize(frameSize) ||
+                frames < 1 || frames > WT_MAX_FRAMES || levels != WavetableData::levelCount(frameSize)) {
+                printf("Wavetable: %s is not a converted wavetable\n", spec);
+            } else {
+                t = new WavetableData();
+                if (!t->allocate(frameSize, frames)) {
+                    printf("Wavetable: out of memory\n");
+                    delete t;
+                    t = nullptr;
+                }
+            }
+        }
+        // 文件中每帧没有回绕采样, 逐帧读入
+        size_t pos = WT_HEADER_WORDS;
+        for (int l = 0; t && l < t->levels; l++) {
+            int len = 1 << t->lenBits[l];
+            for (int f = 0; f < t->frames; f++) {
+                if (source->read(pos, t->frame(l, f), len) != (size_t)len) {
+                    printf("Wavetable: %s is truncated\n", spec);
+                    delete t;
+                    t = nullptr;
+                    break;
+                }
+                t->closeFrame(l, f);
+                pos += len;
+            }
+        }
+        delete source;
+        if (t) printf("Wavetable %s loaded: %d frames x %d\n", spec, t->frames, t->frameSize);
+        return t;
+    }
+
+    // 内置表: 8 帧, 锯齿波逐步过渡到方波, 按层加法合成
+    static WavetableData* buildDefault() {
+        const int size = 256, frames = 8;
+        WavetableData* t = new WavetableData();
+        if (!t->allocate(size, frames)) {
+            delete t;
+            return nullptr;
+        }
+        for (int f = 0; f < frames; f++) {
+            float square = (float)f / (frames - 1);
+            for (int l = 0; l < t->levels; l++) {
+                int len = 1 << t->lenBits[l];
+                int harmonics = WavetableData::levelHarmonics(size, l);
+                int16_t* p = t->frame(l, f);
+                for (int n = 0; n < len; n++) {
+                    float y = 0;
+                    for (int h = 1; h <= harmonics; h++) {
+                        float a = (h & 1) ? 1.0f / h : (1.0f - square) / h;
+                        y += a * sinf(2.0f * (float)M_PI * h * n / len);
+                    }
+                    y *= 17000.0f; // 带限锯齿波峰值约 1.85 (含吉布斯过冲)
+                    p[n] = y > 32767 ? 32767 : (y < -32768 ? -32768 : (int16_t)y);
+                }
+                t->closeFrame(l, f);
+            }
+        }
+        return t;
+    }
+};
+
+// 波表振荡器: 按块内最高频率选择八度层, 帧内线性插值, 相邻帧之间按位置混合
+class WavetableOsc: public Module_t {
+public:
+    WavetableOsc() { module_info = {"wavetable osc", "libchara-dev", "Mipmapped wavetable oscillator with frame morphing", false, false}; }
+
+    int16_t freq[AUDIO_BLOCK_SIZE] = {};
+    int16_t morph[AUDIO_BLOCK_SIZE] = {};
+    int16_t gate[AUDIO_BLOCK_SIZE] = {};
+    int16_t out[AUDIO_BLOCK_SIZE] = {};
+    int position = 0;   // Q15, 0 = 第一帧, 32767 = 最后一帧
+
+    uint32_t phase = 0;
+
+    void start() {
+        registerPort(freq, PORT_AIN, "FREQ IN", "frequency input (Hz)");
+        registerPort(morph, PORT_AIN, "MORPH", "frame position offset, Q15");
+        registerPort(gate, PORT_DIN, "GATE", "gate");
+        registerPort(out, PORT_AOUT, "OUTPUT", "signal output");
+        registerParam(&position, PARAM_INT, "Position", "frame position, Q15");
+        incPerHz = (uint32_t)(4294967296.0 / sampleRate);
+        printf("WavetableOsc Start\n");
+    }
+    void stop() {
+        WavetableCache& cache = WavetableCache::instance();
+        cache.release(pending.exchange(nullptr));
+        cache.release(retired.exchange(nullptr));
+        cache.release(table);
+        table = nullptr;
+        printf("WavetableOsc Stop\n");
+    }
+
+    // 任意非音频线程调用: 从缓存取得波表, 音频线程在块边界切换
+    // 换下的表暂存在 retired, 在下一次加载或 stop() 时归还缓存
+    bool loadTable(const char* spec) {
+        WavetableCache& cache = WavetableCache::instance();
+        WavetableData* t = cache.acquire(spec);
+        if (!t) return false;
+        cache.release(pending.exchange(t, std::memory_order_acq_rel));
+        cache.release(retired.exchange(nullptr, std::memory_order_acq_rel));
+        return true;
+    }
+
+    void process() {
+        // retired 被归还之前不切换, 保证换下的表只由一个槽持有
+        if (!retired.load(std::memory_order_acquire)) {
+            WavetableData* loaded = pending.exchange(nullptr, std::memory_order_acquire);
+            if (loaded) {
+                retired.store(table, std::memory_order_release);
+                table = loaded;
+            }
+        }
+        if (!table) {
+            memset(out, 0, sizeof(out));
+            return;
+        }
+
+        // 本块最高频率决定层: 该层最高谐波不超过奈奎斯特
+        int16_t maxFreq = 0;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            if (gate[i] && freq[i] > maxFreq) maxFreq = freq[i];
+        }
+        uint64_t maxInc = (uint64_t)maxFreq * incPerHz;
+        int level = 0;
+        while (level < table->levels - 1 && (uint64_t)WavetableData::levelHarmonics(table->frameSize, level) * maxInc > 0x80000000ull) {
+            level++;
+        }
+
+        // 位置参数在块内线性平滑
+        int32_t target = position < 0 ? 0 : (position > 32767 ? 32767 : position);
+        int32_t from = currentPosition;
+        currentPosition = target;
+        int32_t step = (target - from) / AUDIO_BLOCK_SIZE;
+
+        int bits = table->lenBits[level];
+        int fracShift = 32 - bits - 15;
+        int lastFrame = table->frames - 1;
+        uint32_t p = phase;
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            if (!gate[i]) {
+                out[i] = 0;
+                continue;
+            }
+            p += freq[i] > 0 ? (uint32_t)freq[i] * incPerHz : 0;
+            int32_t pos = from + step * i + morph[i];
+            pos = pos < 0 ? 0 : (pos > 32767 ? 32767 : pos);
+            int32_t fp = pos * lastFrame;
+            int f = fp >> 15;
+            int32_t m = fp & 0x7FFF;
+            const int16_t* a = table->frame(level, f);
+            const int16_t* b = table->frame(level, f < lastFrame ? f + 1 : f);
+            uint32_t idx = p >> (32 - bits);
+            int32_t t = (p >> fracShift) & 0x7FFF;
+            int32_t ya = a[idx] + (((a[idx + 1] - a[idx]) * t) >> 15);
+            int32_t yb = b[idx] + (((b[idx + 1] - b[idx]) * t) >> 15);
+            out[i] = ya + (((yb - ya) * m) >> 15);
+        }
+        phase = p;
+    }
+    void customSettingPage() {
+
+    }
+    void customViewPage() {
+
+    }
+
+private:
+    uint32_t incPerHz = 97391; // 2^32 / 44100
+    WavetableData* table = nullptr;
+    std::atomic<WavetableData*> pending{nullptr};
+    std::atomic<WavetableData*> retired{nullptr};
+    int32_t currentPosition = 0;
+};
+
+// 每个波表振荡器实例 (一个声部) 的耗时, 低音与高音各测一次
+inline void benchWavetable(uint32_t blocks) {
+    static const char* names[] = {"wavetable osc 110 Hz", "wavetable osc 1760 Hz"};
+    static const int16_t freqs[] = {110, 1760};
+    for (int v = 0; v < 2; v++) {
+        benchModule<WavetableOsc>(names[v], blocks, [v](WavetableOsc& m) {
+            m.loadTable("builtin");
+            for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+                m.freq[i] = freqs[v];
+                m.gate[i] = 1;
+                m.morph[i] = i * 128;
+            }
+            m.position = 12000;
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,199 @@
+// Dsp (平台 SIMD 实现) 与 DspPortable 逐位一致
+// 目标板: pio test -e esp32s3 (PIE 汇编), 主机: pio test -e native (SSE2 / NEON)
+// 随机与边界数据, 覆盖未对齐地址, 非 8 倍数长度, 以及超过一次 PIE 点积分段的长度
+#include <unity.h>
+#include <string.h>
+#include "dsp_kernels.h"
+
+#define TEST_LEN 320
+#define TEST_ROUNDS 48
+
+static const int lengths[] = {0, 1, 7, 8, 9, 63, 64, 67, 300};
+static const int16_t edges[] = {-32768, -32767, -1, 0, 1, 32767};
+
+DSP_ALIGN static int16_t a[TEST_LEN + 16], b[TEST_LEN + 16], outRef[TEST_LEN], outSimd[TEST_LEN];
+DSP_ALIGN static int32_t acc32[TEST_LEN + 16], accRef[TEST_LEN], accSimd[TEST_LEN];
+DSP_ALIGN static float f[TEST_LEN + 16], fRef[TEST_LEN], fSimd[TEST_LEN];
+static int16_t g[8];
+static uint32_t seed;
+
+// Unity 不接受长度为 0 的数组比较; 长度为 0 时只检查调用本身
+#define EXPECT_EQUAL_ARRAY(kind, expected, actual, n) \
+    if (n) TEST_ASSERT_EQUAL_##kind##_ARRAY(expected, actual, n)
+
+static int16_t rnd() {
+    seed = seed * 1664525 + 1013904223;
+    return (int16_t)(seed >> 16);
+}
+
+// 前 8 轮使用边界值, 之后为随机数据; 奇数轮的浮点输入正好落在舍入的中点上
+static void fill(int round) {
+    for (int i = 0; i < TEST_LEN + 16; i++) {
+        a[i] = round < 8 ? edges[(i + round) % 6] : rnd();
+        b[i] = round < 8 ? edges[(i * 5 + round) % 6] : rnd();
+        acc32[i] = (int32_t)((uint32_t)rnd() << 16 | (uint16_t)rnd());
+        f[i] = (rnd() / 16384.0f) + (round & 1 ? 0.5f / 32768 : 0);
+    }
+    for (int k = 0; k < 8; k++) {
+        g[k] = round < 8 ? edges[(k + round) % 6] : rnd();
+    }
+}
+
+// 对每轮数据, 每个偏移与长度调用一次 check(x, y, n, offset)
+template<typename F>
+static void forEachCase(int offsets, F&& check) {
+    seed = 0x1234567;
+    for (int round = 0; round < TEST_ROUNDS; round++) {
+        fill(round);
+        for (int offset = 0; offset < offsets; offset++) {
+            for (int n : lengths) {
+                check(a + offset, b + offset, n, offset);
+            }
+        }
+    }
+}
+
+static void test_gain() {
+    forEachCase(2, [](const int16_t* x, const int16_t*, int n, int) {
+        DspPortable::gain(x, g[0], outRef, n);
+        Dsp::gain(x, g[0], outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_add() {
+    forEachCase(2, [](const int16_t* x, const int16_t* y, int n, int) {
+        DspPortable::add(x, y, outRef, n);
+        Dsp::add(x, y, outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_mix() {
+    forEachCase(2, [](const int16_t* x, const int16_t* y, int n, int) {
+        DspPortable::mix(x, g[1], y, g[2], outRef, n);
+        Dsp::mix(x, g[1], y, g[2], outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_mac() {
+    forEachCase(2, [](const int16_t* x, const int16_t* y, int n, int) {
+        memcpy(outRef, y, n * sizeof(int16_t));
+        memcpy(outSimd, y, n * sizeof(int16_t));
+        DspPortable::mac(x, g[3], outRef, n);
+        Dsp::mac(x, g[3], outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_mac32() {
+    forEachCase(2, [](const int16_t* x, const int16_t*, int n, int) {
+        memcpy(accRef, acc32, n * sizeof(int32_t));
+        memcpy(accSimd, acc32, n * sizeof(int32_t));
+        DspPortable::mac32(x, g[4], accRef, n);
+        Dsp::mac32(x, g[4], accSimd, n);
+        EXPECT_EQUAL_ARRAY(INT32, accRef, accSimd, n);
+    });
+}
+
+static void test_saturate() {
+    forEachCase(2, [](const int16_t*, const int16_t*, int n, int offset) {
+        int shift = (n + offset * 7 + (uint16_t)g[0]) % 20;
+        DspPortable::saturate(acc32 + offset, shift, outRef, n);
+        Dsp::saturate(acc32 + offset, shift, outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_clip() {
+    forEachCase(2, [](const int16_t* x, const int16_t*, int n, int) {
+        int16_t lo = g[5] < g[6] ? g[5] : g[6];
+        int16_t hi = g[5] < g[6] ? g[6] : g[5];
+        DspPortable::clip(x, lo, hi, outRef, n);
+        Dsp::clip(x, lo, hi, outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+static void test_crossfade() {
+    forEachCase(2, [](const int16_t* x, const int16_t* y, int n, int) {
+        DspPortable::crossfade(x, y, g[7], outRef, n);
+        Dsp::crossfade(x, y, g[7], outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+// 点积的 a 可以是滑动窗口中的任意位置, 覆盖全部 8 种相对 16 字节的偏移
+static void test_dot() {
+    forEachCase(8, [](const int16_t* x, const int16_t*, int n, int) {
+        TEST_ASSERT_TRUE(DspPortable::dot(x, b, n) == Dsp::dot(x, b, n));
+    });
+}
+
+static void test_peak() {
+    forEachCase(2, [](const int16_t* x, const int16_t*, int n, int) {
+        TEST_ASSERT_EQUAL_INT32(DspPortable::peak(x, n), Dsp::peak(x, n));
+    });
+}
+
+static void test_to_float() {
+    forEachCase(2, [](const int16_t* x, const int16_t*, int n, int) {
+        DspPortable::toFloat(x, fRef, n);
+        Dsp::toFloat(x, fSimd, n);
+        if (n) TEST_ASSERT_EQUAL_MEMORY(fRef, fSimd, n * sizeof(float));
+    });
+}
+
+static void test_from_float() {
+    forEachCase(2, [](const int16_t*, const int16_t*, int n, int offset) {
+        DspPortable::fromFloat(f + offset, outRef, n);
+        Dsp::fromFloat(f + offset, outSimd, n);
+        EXPECT_EQUAL_ARRAY(INT16, outRef, outSimd, n);
+    });
+}
+
+void setUp() {
+    memset(outRef, 0, sizeof(outRef));
+    memset(outSimd, 0, sizeof(outSimd));
+    memset(accRef, 0, sizeof(accRef));
+    memset(accSimd, 0, sizeof(accSimd));
+    memset(fRef, 0, sizeof(fRef));
+    memset(fSimd, 0, sizeof(fSimd));
+}
+
+void tearDown() {
+}
+
+static int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_gain);
+    RUN_TEST(test_add);
+    RUN_TEST(test_mix);
+    RUN_TEST(test_mac);
+    RUN_TEST(test_mac32);
+    RUN_TEST(test_saturate);
+    RUN_TEST(test_clip);
+    RUN_TEST(test_crossfade);
+    RUN_TEST(test_dot);
+    RUN_TEST(test_peak);
+    RUN_TEST(test_to_float);
+    RUN_TEST(test_from_float);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+void setup() {
+    delay(2000);    // 等待串口连接
+    runTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,94 @@
+// GranularModule 的缓冲长度: 载入长度不是块长整数倍的采样后录入, 有效长度止于缓冲长度, 颗粒不越界读取
+// 主机: pio test -e native (载入经 mmap 的 WAV 文件)
+#include <unity.h>
+#include <stdio.h>
+#include "granular.h"
+
+#define SHORT_FRAMES 100
+#define WAV_PATH "granular_short.wav"
+
+static GranularModule* granular;
+
+// 单声道 16 位 PCM WAV
+static bool writeWav(const char* path, int frames) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    uint32_t dataBytes = frames * sizeof(int16_t);
+    uint32_t riffBytes = 36 + dataBytes;
+    uint32_t fmtBytes = 16, rate = SMP_RATE, byteRate = SMP_RATE * 2;
+    uint16_t format = 1, channels = 1, align = 2, bits = 16;
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riffBytes, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmtBytes, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byteRate, 4, 1, f);
+    fwrite(&align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&dataBytes, 4, 1, f);
+    for (int i = 0; i < frames; i++) {
+        int16_t s = (int16_t)(i * 300 - 15000);
+        fwrite(&s, 2, 1, f);
+    }
+    fclose(f);
+    return true;
+}
+
+static void setGate(int16_t level) {
+    for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        granular->gate[i] = level;
+    }
+}
+
+static void test_load_short_sample() {
+    TEST_ASSERT_TRUE(granular->loadBuffer(WAV_PATH));
+    granular->process();
+    TEST_ASSERT_EQUAL_INT(SHORT_FRAMES, granular->bufferFrames());
+}
+
+// 录入一直持续到写满之后: 有效长度逐块增长, 最终恰好停在 GRAIN_BUFFER_FRAMES
+static void test_record_after_short_sample() {
+    TEST_ASSERT_TRUE(granular->loadBuffer(WAV_PATH));
+    granular->process();
+    granular->record = 1;
+    granular->density = 400;
+    granular->spray = 32767;
+    setGate(1);
+    const int blocks = GRAIN_BUFFER_FRAMES / AUDIO_BLOCK_SIZE + 64;
+    for (int b = 0; b < blocks; b++) {
+        for (int i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+            granular->in[i] = (int16_t)((b * AUDIO_BLOCK_SIZE + i) * 7);
+        }
+        granular->process();
+        size_t expected = SHORT_FRAMES + (size_t)(b + 1) * AUDIO_BLOCK_SIZE;
+        if (expected > GRAIN_BUFFER_FRAMES) expected = GRAIN_BUFFER_FRAMES;
+        if (granular->bufferFrames() != expected) {
+            TEST_ASSERT_EQUAL_INT((int)expected, (int)granular->bufferFrames());
+            return;
+        }
+    }
+    TEST_ASSERT_TRUE(granular->spawned > 0);
+}
+
+void setUp() {
+    granular = new GranularModule();
+    granular->start();
+}
+
+void tearDown() {
+    granular->stop();
+    delete granular;
+}
+
+int main() {
+    if (!writeWav(WAV_PATH, SHORT_FRAMES)) return 1;
+    UNITY_BEGIN();
+    RUN_TEST(test_load_short_sample);
+    RUN_TEST(test_record_after_short_sample);
+    int failures = UNITY_END();
+    remove(WAV_PATH);
+    return failures;
+}
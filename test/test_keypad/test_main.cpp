@@ -0,0 +1,126 @@
+// KeyEventGenerator 的事件序列: 按下 / 松开, 长按与重复, 迟到的扫描, 和弦与和弦松开
+// 主机: pio test -e native (生成器不依赖扫描硬件)
+#include <unity.h>
+#include "keypad_input.h"
+
+#define MAX_EVENTS 64
+#define SCAN_US (KEYPAD_SCAN_MS * 1000)
+
+static KeyEventGenerator generator;
+static key_event_t events[MAX_EVENTS];
+static int eventCount;
+static int64_t now;
+
+// 按住 held 扫描一次, 时间前进一个扫描周期
+static void scan(uint16_t held) {
+    generator.update(held, now, [](const key_event_t& e) {
+        if (eventCount < MAX_EVENTS) events[eventCount] = e;
+        eventCount++;
+    });
+    now += SCAN_US;
+}
+
+// 按住 held 持续扫描 ms 毫秒
+static void hold(uint16_t held, int ms) {
+    for (int64_t end = now + (int64_t)ms * 1000; now < end;) {
+        scan(held);
+    }
+}
+
+static void expectEvent(int i, int num, key_status_t status) {
+    TEST_ASSERT_TRUE(i < eventCount);
+    TEST_ASSERT_EQUAL_INT(num, events[i].num);
+    TEST_ASSERT_EQUAL_INT(status, events[i].status);
+}
+
+static int eventMs(int i) {
+    return (int)(events[i].us / 1000);
+}
+
+static void test_press_release() {
+    scan(0x0001);
+    scan(0x0001);
+    scan(0x0000);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 0, KEY_ATTACK);
+    TEST_ASSERT_EQUAL_INT(0x0001, events[0].mask);
+    expectEvent(1, 0, KEY_RELEASE);
+    TEST_ASSERT_EQUAL_INT(0, events[1].mask);
+}
+
+// 按住 1 秒: 500 ms 时一次长按, 之后每 100 ms 一次重复
+static void test_long_press_repeat() {
+    hold(0x0004, 1000);
+    TEST_ASSERT_EQUAL_INT(6, eventCount);
+    expectEvent(0, 2, KEY_ATTACK);
+    expectEvent(1, 2, KEY_LONG_PRESS);
+    TEST_ASSERT_EQUAL_INT(KEYPAD_LONG_PRESS_MS, eventMs(1));
+    for (int i = 2; i < eventCount; i++) {
+        expectEvent(i, 2, KEY_REPEAT);
+        TEST_ASSERT_EQUAL_INT(KEYPAD_REPEAT_MS, eventMs(i) - eventMs(i - 1));
+    }
+}
+
+// 扫描停顿 1 秒后恢复: 只补一次重复, 不连发
+static void test_late_scan() {
+    hold(0x0001, 600);
+    int before = eventCount;
+    now += 1000 * 1000;
+    hold(0x0001, 60);
+    TEST_ASSERT_EQUAL_INT(before + 1, eventCount);
+    expectEvent(before, 0, KEY_REPEAT);
+    hold(0x0001, 100);
+    TEST_ASSERT_EQUAL_INT(before + 2, eventCount);
+    TEST_ASSERT_TRUE(eventMs(before + 1) - eventMs(before) >= KEYPAD_REPEAT_MS);
+}
+
+// 和弦按住期间不产生长按与重复; 松开到只剩一个键后从松开时刻重新计长按
+static void test_chord_release() {
+    hold(0x0001, 100);
+    hold(0x0003, 3000);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 0, KEY_ATTACK);
+    expectEvent(1, 1, KEY_CHORD);
+    TEST_ASSERT_EQUAL_INT(0x0003, events[1].mask);
+
+    int releaseMs = (int)(now / 1000);
+    hold(0x0001, 120);
+    TEST_ASSERT_EQUAL_INT(3, eventCount);
+    expectEvent(2, 1, KEY_RELEASE);
+
+    hold(0x0001, KEYPAD_LONG_PRESS_MS - 100);
+    TEST_ASSERT_EQUAL_INT(4, eventCount);
+    expectEvent(3, 0, KEY_LONG_PRESS);
+    TEST_ASSERT_EQUAL_INT(releaseMs + KEYPAD_LONG_PRESS_MS, eventMs(3));
+}
+
+// 同一次扫描里同时按下两个键: 第一个为按下, 第二个为和弦
+static void test_simultaneous_press() {
+    scan(0x0006);
+    TEST_ASSERT_EQUAL_INT(2, eventCount);
+    expectEvent(0, 1, KEY_ATTACK);
+    expectEvent(1, 2, KEY_CHORD);
+    scan(0x0000);
+    TEST_ASSERT_EQUAL_INT(4, eventCount);
+    expectEvent(2, 1, KEY_RELEASE);
+    expectEvent(3, 2, KEY_RELEASE);
+}
+
+void setUp() {
+    generator = KeyEventGenerator();
+    eventCount = 0;
+    now = 0;
+}
+
+void tearDown() {
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_press_release);
+    RUN_TEST(test_long_press_repeat);
+    RUN_TEST(test_late_scan);
+    RUN_TEST(test_chord_release);
+    RUN_TEST(test_simultaneous_press);
+    return UNITY_END();
+}